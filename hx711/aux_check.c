@@ -0,0 +1,103 @@
+/**
+ *
+ * Channel-B interleave check for the acquisition engine
+ *
+ * Compile with: gcc -O2 aux_check.c hx711.c hx711_timing.c hx711_curve.c hx711_sim.c -o aux_check -lpthread -lm
+ *
+ * ./aux_check [every [seconds]]
+ *     Runs the engine against the behavioural chip with channel A at
+ *     +100000 counts and channel B at -200000, and one channel-B conversion
+ *     every `every` channel-A ones (default 10). The model settles the way
+ *     the datasheet gives it: the 4 conversions after an input change land
+ *     between the two inputs. Every sample in the weight stream must read
+ *     exactly A and every channel-B sample exactly B; the share of weight
+ *     conversions spent must be (1 + 2 * HX711_AUX_SETTLE_SAMPLES) per cycle.
+ *
+ *     Built with -DHX711_AUX_SETTLE_SAMPLES=1 the same run must FAIL, which
+ *     shows the check can see settling conversions leak into either stream.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "hx711.h"
+#include "hx711_sim.h"
+#include "hx711_timing.h"
+
+#define SIM_PERIOD_NS 1000000u // 1 ms conversions, so a few seconds cover many switches
+#define CHANNEL_A 100000L
+#define CHANNEL_B (-200000L)
+
+static hx711_acq_t acq;
+static hx711_sim_t sim;
+static hx711_t hx;
+
+static long two_inputs(void* ctx, uint8_t channel) {
+    (void)ctx;
+    return channel == 2 ? CHANNEL_B : CHANNEL_A;
+}
+
+static void sim_delay_us(unsigned int us) { (void)us; }
+
+static void sim_delay_ms(unsigned int ms) {
+    struct timespec ts = { ms / 1000, ms ? (long)(ms % 1000) * 1000000L : 100000L };
+    nanosleep(&ts, NULL);
+}
+
+int main(int argc, char** argv) {
+    uint32_t every = argc >= 2 ? (uint32_t)atoi(argv[1]) : 10;
+    int seconds = argc >= 3 ? atoi(argv[2]) : 3;
+    hx711_reader_t reader, aux_reader;
+    hx711_sample_t s;
+    uint64_t a_n = 0, a_bad = 0, b_n = 0, b_bad = 0;
+
+    if (every < 1) every = 10;
+    hx711_sim_init(&sim, 0, SIM_PERIOD_NS);
+    hx711_sim_set_source(&sim, two_inputs, NULL);
+    hx711_sim_attach(&sim);
+
+    hx711_backend_t backend = {
+        .gpio_write = hx711_sim_gpio_write,
+        .gpio_read = hx711_sim_gpio_read,
+        .delay_us = sim_delay_us,
+        .delay_ms = sim_delay_ms,
+    };
+    hx711_init_backend(&hx, 0, 0, &backend);
+    hx711_acq_set_channel_b(&acq, every);
+    if (hx711_acq_start(&acq, &hx) != 0) {
+        fprintf(stderr, "could not start acquisition\n");
+        return 1;
+    }
+    hx711_acq_reader_init(&acq, &reader);
+    hx711_acq_aux_reader_init(&acq, &aux_reader);
+
+    for (int i = 0; i < seconds * 100; i++) {
+        sim_delay_ms(10);
+        while (hx711_acq_poll(&acq, &reader, &s)) {
+            a_n++;
+            if (s.value != CHANNEL_A) a_bad++;
+        }
+        while (hx711_acq_aux_poll(&acq, &aux_reader, &s)) {
+            b_n++;
+            if (s.value != CHANNEL_B) b_bad++;
+        }
+    }
+    hx711_acq_stop(&acq);
+
+    hx711_acq_snapshot_t snap;
+    hx711_acq_snapshot(&acq, &snap);
+    double lost = 100.0 * (double)snap.aux_lost / (double)(a_n + snap.aux_lost);
+    double expect = 100.0 * (1 + 2 * HX711_AUX_SETTLE_SAMPLES) / (double)(every + 1 + 2 * HX711_AUX_SETTLE_SAMPLES);
+
+    printf("channel B 1/%u, %d conversions settling per switch, %d discarded\n", (unsigned)every,
+           HX711_SIM_SETTLE_CONVERSIONS, HX711_AUX_SETTLE_SAMPLES);
+    printf("channel A: %llu samples, %llu not exactly %ld\n", (unsigned long long)a_n,
+           (unsigned long long)a_bad, CHANNEL_A);
+    printf("channel B: %llu samples, %llu not exactly %ld\n", (unsigned long long)b_n,
+           (unsigned long long)b_bad, CHANNEL_B);
+    printf("weight conversions spent on channel B: %.1f%% (expected %.1f%%)\n", lost, expect);
+
+    bool ok = a_n > 0 && b_n > 0 && a_bad == 0 && b_bad == 0;
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
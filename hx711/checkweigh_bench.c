@@ -0,0 +1,172 @@
+/**
+ *
+ * Sustained-throughput benchmark for hx711_checkweigh
+ *
+ * Compile with: gcc -O2 checkweigh_bench.c hx711_checkweigh.c -o checkweigh_bench -lm
+ *
+ * ./checkweigh_bench trace.csv [on_level lower upper]
+ *     Replays a recorded trace ("timestamp_ns,grams" per line, as written by
+ *     mw11 with "cw_trace") and prints every item.
+ * ./checkweigh_bench
+ *     Synthesizes 80 SPS conveyor traces at 1..5 items per second (entry and
+ *     exit ramps, belt vibration, noise) and reports detection, weighing error
+ *     and processing cost per sample for each rate.
+ *
+ */
+#define _GNU_SOURCE // M_PI
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "hx711_checkweigh.h"
+
+#define SPS 80
+#define MAX_TRACE (SPS * 600) // Ten minutes
+
+static uint64_t trace_t[MAX_TRACE];
+static float trace_v[MAX_TRACE];
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static double gauss(void) {
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+static const char* verdict_name(hx711_cw_verdict_t v) {
+    switch (v) {
+    case HX711_CW_ACCEPT: return "ACCEPT";
+    case HX711_CW_UNDER:  return "UNDER";
+    case HX711_CW_OVER:   return "OVER";
+    default:              return "NO PLATEAU";
+    }
+}
+
+// --- Recorded trace ---
+
+static void print_item(const hx711_cw_item_t* item, void* ctx) {
+    (void)ctx;
+    printf("#%u %8.2f g sd %.2f  %3u/%3u samples  %s%s\n", (unsigned)item->index, item->weight, item->sd,
+           (unsigned)item->plateau, (unsigned)item->samples, verdict_name(item->verdict),
+           item->truncated ? " (truncated)" : "");
+}
+
+static int replay(const char* path, float on_level, float lower, float upper) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) { perror(path); return 1; }
+
+    int n = 0;
+    unsigned long long t;
+    float v;
+    while (n < MAX_TRACE && fscanf(fp, "%llu,%f", &t, &v) == 2) {
+        trace_t[n] = t;
+        trace_v[n] = v;
+        n++;
+    }
+    fclose(fp);
+    if (n < 2) { fprintf(stderr, "%s: no samples\n", path); return 1; }
+
+    static hx711_checkweigh_t cw;
+    hx711_checkweigh_init(&cw, on_level, lower, upper, 1.0f, print_item, NULL);
+
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < n; i++) hx711_checkweigh_push(&cw, trace_t[i], trace_v[i]);
+    uint64_t cpu = now_ns() - t0;
+
+    double span_s = (double)(trace_t[n - 1] - trace_t[0]) / 1e9;
+    printf("%d samples over %.1f s, %u items (%.2f/s): %u accepted, %u under, %u over, %u without plateau\n",
+           n, span_s, (unsigned)cw.items, span_s > 0 ? cw.items / span_s : 0.0,
+           (unsigned)cw.verdicts[HX711_CW_ACCEPT], (unsigned)cw.verdicts[HX711_CW_UNDER],
+           (unsigned)cw.verdicts[HX711_CW_OVER], (unsigned)cw.verdicts[HX711_CW_NO_PLATEAU]);
+    printf("processing: %.0f ns per sample\n", (double)cpu / n);
+    return 0;
+}
+
+// --- Synthetic conveyor ---
+
+typedef struct {
+    double error_sq;
+    double error_max;
+    unsigned matched;
+} synth_score_t;
+
+static float synth_weight[MAX_TRACE / 8];
+static synth_score_t score;
+
+static void score_item(const hx711_cw_item_t* item, void* ctx) {
+    (void)ctx;
+    if (item->verdict == HX711_CW_NO_PLATEAU || item->index > MAX_TRACE / 8) return;
+    double err = item->weight - synth_weight[item->index - 1];
+    score.error_sq += err * err;
+    if (fabs(err) > score.error_max) score.error_max = fabs(err);
+    score.matched++;
+}
+
+// Items of 480..520 g, each on the plate for 60% of its slot with 40 ms
+// ramps; 0.5 g noise and a 2 g, 7 Hz belt vibration on top
+static int synthesize(double items_per_s, double seconds) {
+    int n = (int)(seconds * SPS);
+    double slot = 1.0 / items_per_s;
+    double ramp = 0.040;
+    int items = 0;
+
+    for (int i = 0; i < n; i++) {
+        double t = (double)i / SPS;
+        int k = (int)(t / slot);
+        double in_slot = t - k * slot;
+        double dwell = 0.6 * slot;
+
+        if (k >= items && k < MAX_TRACE / 8) {
+            synth_weight[k] = 480.0f + (float)(rand() % 4000) / 100.0f;
+            items = k + 1;
+        }
+        double load = 0.0;
+        if (in_slot < dwell) {
+            double shape = 1.0;
+            if (in_slot < ramp) shape = in_slot / ramp;
+            else if (in_slot > dwell - ramp) shape = (dwell - in_slot) / ramp;
+            load = synth_weight[k] * shape;
+        }
+        trace_t[i] = (uint64_t)(t * 1e9);
+        trace_v[i] = (float)(load + 0.5 * gauss() + 2.0 * sin(2.0 * M_PI * 7.0 * t));
+    }
+
+    // Last slot cut off by the end of the trace is not an item
+    double last = n / (double)SPS - (items - 1) * slot;
+    return last >= 0.6 * slot ? items : items - 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2) {
+        float on_level = argc >= 3 ? (float)atof(argv[2]) : 20.0f;
+        float lower = argc >= 4 ? (float)atof(argv[3]) : 0.0f;
+        float upper = argc >= 5 ? (float)atof(argv[4]) : 0.0f;
+        return replay(argv[1], on_level, lower, upper);
+    }
+
+    srand(1);
+    printf("items/s  expected  found  weighed  rms err g  max err g  accepted  ns/sample\n");
+    for (double rate = 1.0; rate <= 5.0; rate += 1.0) {
+        static hx711_checkweigh_t cw;
+        int expected = synthesize(rate, 300.0);
+        int n = (int)(300.0 * SPS);
+
+        score = (synth_score_t){0};
+        hx711_checkweigh_init(&cw, 100.0f, 490.0f, 510.0f, 1.0f, score_item, NULL);
+
+        uint64_t t0 = now_ns();
+        for (int i = 0; i < n; i++) hx711_checkweigh_push(&cw, trace_t[i], trace_v[i]);
+        uint64_t cpu = now_ns() - t0;
+
+        printf("%7.0f  %8d  %5u  %7u  %9.2f  %9.2f  %8u  %9.0f\n", rate, expected, (unsigned)cw.items,
+               score.matched, score.matched ? sqrt(score.error_sq / score.matched) : 0.0, score.error_max,
+               (unsigned)cw.verdicts[HX711_CW_ACCEPT], (double)cpu / n);
+    }
+    return 0;
+}
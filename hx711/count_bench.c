@@ -0,0 +1,107 @@
+/**
+ *
+ * Counting accuracy benchmark for hx711_count
+ *
+ * Compile with: gcc -O2 count_bench.c hx711_count.c -o count_bench -lm
+ *
+ * ./count_bench
+ *     Synthesizes 80 SPS counting sessions: a reference of 10 pieces, then
+ *     handfuls added up to 500 pieces, each settling for 0.6 s after a
+ *     drop transient. Reports how often the settled count is exact with the
+ *     APW taken once from the reference and with refinement, how often the
+ *     reported 95% bound covers the true count, and the refinements made.
+ *     Pieces vary by the cv the counter assumes, and by more than it.
+ *
+ */
+#define _GNU_SOURCE // M_PI
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "hx711_count.h"
+
+#define SPS 80
+#define WINDOW 16            // 200 ms
+#define SETTLE_SAMPLES 48    // 0.6 s per handful
+#define REF_PIECES 10
+#define FINAL_PIECES 500
+#define SESSIONS 400
+#define APW_G 2.0            // M4 screws
+#define NOISE_G 0.05
+#define ASSUMED_CV 0.02f
+
+static double gauss(void) {
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+typedef struct {
+    long reads, exact, covered, exact_final, refinements;
+} tally_t;
+
+// Drop transient, then the settled load
+static void settle(hx711_count_t* c, double load, double before) {
+    for (int i = 0; i < SETTLE_SAMPLES; i++) {
+        double v = load;
+        if (i < 12) v += (load - before) * 0.4 * exp(-i / 3.0) * cos(i * 1.3);
+        hx711_count_push(c, (float)(v + NOISE_G * gauss()));
+    }
+}
+
+static void session(double true_cv, float refine, tally_t* t) {
+    static hx711_count_t c;
+    double load = 0.0;
+    long pieces = 0;
+
+    hx711_count_init(&c, WINDOW, 4.0f * NOISE_G, ASSUMED_CV, refine);
+    settle(&c, 0.0, 0.0);
+    while (pieces < REF_PIECES) {
+        load += APW_G * (1.0 + true_cv * gauss());
+        pieces++;
+    }
+    settle(&c, load, 0.0);
+    if (hx711_count_set_reference(&c, REF_PIECES) != 0) return;
+
+    while (pieces < FINAL_PIECES) {
+        long handful = 1 + rand() % (pieces < 40 ? 10 : 40);
+        if (pieces + handful > FINAL_PIECES) handful = FINAL_PIECES - pieces;
+        double before = load;
+        for (long i = 0; i < handful; i++) load += APW_G * (1.0 + true_cv * gauss());
+        pieces += handful;
+        settle(&c, load, before);
+
+        hx711_count_result_t r;
+        if (hx711_count_get(&c, &r) != 0 || !r.stable) continue;
+        t->reads++;
+        if (r.count == pieces) t->exact++;
+        if (fabs(r.exact - pieces) <= r.bound) t->covered++;
+        if (pieces == FINAL_PIECES && r.count == pieces) t->exact_final++;
+    }
+    t->refinements += c.refinements;
+}
+
+static void run(const char* name, double true_cv) {
+    tally_t fixed = {0}, refined = {0};
+
+    srand(1);
+    for (int s = 0; s < SESSIONS; s++) session(true_cv, 0.0f, &fixed);
+    srand(1);
+    for (int s = 0; s < SESSIONS; s++) session(true_cv, 0.999f, &refined);
+
+    printf("%-22s  fixed APW: %5.1f%% exact, %5.1f%% at %d, bound covers %5.1f%%\n", name,
+           100.0 * fixed.exact / fixed.reads, 100.0 * fixed.exact_final / SESSIONS, FINAL_PIECES,
+           100.0 * fixed.covered / fixed.reads);
+    printf("%-22s  refined:   %5.1f%% exact, %5.1f%% at %d, bound covers %5.1f%%, %.1f refinements\n", "",
+           100.0 * refined.exact / refined.reads, 100.0 * refined.exact_final / SESSIONS, FINAL_PIECES,
+           100.0 * refined.covered / refined.reads, (double)refined.refinements / SESSIONS);
+}
+
+int main(void) {
+    printf("%d sessions, reference %d pieces of %.1f g, counted up to %d, %.2f g noise, cv assumed %.0f%%\n",
+           SESSIONS, REF_PIECES, APW_G, FINAL_PIECES, NOISE_G, 100.0 * ASSUMED_CV);
+    run("pieces cv 1%", 0.01);
+    run("pieces cv 2%", 0.02);
+    run("pieces cv 4% (uneven)", 0.04);
+    return 0;
+}
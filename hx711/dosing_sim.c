@@ -0,0 +1,236 @@
+/**
+ *
+ * Filling simulation for hx711_dosing: valve + falling material + scale
+ *
+ * Compile with: gcc -O2 dosing_sim.c hx711_dosing.c hx711.c hx711_timing.c hx711_curve.c hx711_sim.c -o dosing_sim -lpthread -lm
+ *
+ * ./dosing_sim [cycles target learn]
+ *
+ * Runs the real acquisition engine against the behavioural chip at 80 SPS,
+ * with the controller on the sample hook, as mw11 does in dosing mode. The
+ * chip's conversions come from a plant model: coarse and fine feeds that
+ * open and close 30 ms after the command, flow that varies +/-10% from
+ * cycle to cycle, material that takes 0.25 s to fall into the container and
+ * pushes on it when it lands, and 0.3 g of noise. Each cycle empties the
+ * container, fills it to the target and prints the result; the summary shows
+ * the error once the preact has settled and how long the controller took
+ * from data-ready to the valve command.
+ *
+ * A conversion the engine rejects is skipped with the feeds left as they
+ * are, as in mw11; HX711_DOSE_MAX_REJECTS in a row end the running cycle as
+ * a FAULT. The model chip never powers down, so on a busy host the rejects
+ * are OVERRUN flags from the acquisition thread being preempted mid-read;
+ * the summary counts them.
+ *
+ */
+#define _GNU_SOURCE // M_PI
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <math.h>
+#include <time.h>
+#include "hx711.h"
+#include "hx711_sim.h"
+#include "hx711_timing.h"
+#include "hx711_dosing.h"
+
+#define SIM_PERIOD_NS 12500000u  // 80 SPS
+#define COUNTS_PER_G 400.0
+#define OFFSET_COUNTS 8000.0
+#define CONTAINER_G 150.0
+#define COARSE_G_S 250.0
+#define FINE_G_S 15.0
+#define VALVE_DELAY_NS 30000000ull
+#define FALL_NS 250000000ull
+#define IMPACT_S 0.15            // Landing force as grams per g/s of landing flow
+#define NOISE_G 0.3
+#define MAX_STEPS 16
+#define WARMUP_CYCLES 8          // Left out of the settled statistics
+
+// Outflow changes of the current fill: from t_ns on, rate g/s leaves the feeder
+typedef struct {
+    uint64_t t_ns;
+    double rate;
+} flow_step_t;
+
+typedef struct {
+    flow_step_t steps[MAX_STEPS];
+    int n;
+    double flow_scale;           // This cycle's flow, 0.9..1.1
+    bool coarse, fine;
+    _Atomic uint32_t swap_req;   // Main thread: empty the container
+    uint32_t swap_seen;
+
+    // Controller latency, data-ready to valve command (acquisition thread)
+    uint64_t ready_ns;
+    uint64_t lat_sum, lat_max;
+    uint32_t lat_n;
+} plant_t;
+
+static plant_t plant;
+static hx711_t hx;
+static hx711_acq_t acq;
+static hx711_sim_t sim;
+static hx711_dosing_t dose;
+static _Atomic uint32_t rejected;   // Conversions skipped by the controller
+
+static double gauss(void) {
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+static double outflow_at(const plant_t* p, uint64_t t) {
+    double rate = 0.0;
+    for (int i = 0; i < p->n && p->steps[i].t_ns <= t; i++) rate = p->steps[i].rate;
+    return rate;
+}
+
+// Material that left the feeder before t
+static double fed_before(const plant_t* p, uint64_t t) {
+    double g = 0.0;
+    for (int i = 0; i < p->n && p->steps[i].t_ns < t; i++) {
+        uint64_t end = i + 1 < p->n && p->steps[i + 1].t_ns < t ? p->steps[i + 1].t_ns : t;
+        g += p->steps[i].rate * (double)(end - p->steps[i].t_ns) / 1e9;
+    }
+    return g;
+}
+
+// Conversion source (acquisition thread): what the load cell sees right now
+static long plant_source(void* ctx, uint8_t channel) {
+    plant_t* p = (plant_t*)ctx;
+    uint64_t now = hx711_time_ns();
+    (void)channel;
+
+    uint32_t swap = atomic_load(&p->swap_req);
+    if (swap != p->swap_seen) {
+        p->swap_seen = swap;
+        p->n = 0;
+        p->flow_scale = 0.9 + 0.2 * rand() / RAND_MAX;
+    }
+
+    double landed = now > FALL_NS ? fed_before(p, now - FALL_NS) : 0.0;
+    double landing = now > FALL_NS ? outflow_at(p, now - FALL_NS) : 0.0;
+    double grams = CONTAINER_G + landed + IMPACT_S * landing + NOISE_G * gauss();
+    return lround(OFFSET_COUNTS + grams * COUNTS_PER_G);
+}
+
+// Valve outputs (acquisition thread, from the controller)
+static void plant_output(bool coarse, bool fine, void* ctx) {
+    plant_t* p = (plant_t*)ctx;
+    uint64_t now = hx711_time_ns();
+
+    if (coarse == p->coarse && fine == p->fine) return;
+    p->coarse = coarse;
+    p->fine = fine;
+    if (p->ready_ns && now > p->ready_ns) {
+        uint64_t lat = now - p->ready_ns;
+        p->lat_sum += lat;
+        p->lat_n++;
+        if (lat > p->lat_max) p->lat_max = lat;
+    }
+    if (p->n < MAX_STEPS) {
+        double rate = ((coarse ? COARSE_G_S : 0.0) + (fine ? FINE_G_S : 0.0)) * p->flow_scale;
+        p->steps[p->n++] = (flow_step_t){ now + VALVE_DELAY_NS, rate };
+    }
+}
+
+static void on_sample(const hx711_sample_t* sample, void* ctx) {
+    (void)ctx;
+    plant.ready_ns = sample->ready_ns;
+    if (sample->flags & HX711_FLAGS_REJECT) {
+        atomic_fetch_add_explicit(&rejected, 1, memory_order_relaxed);
+        hx711_dosing_reject(&dose, sample->timestamp_ns);
+        return;
+    }
+    hx711_dosing_push(&dose, sample->timestamp_ns, hx711_raw_to_units(&hx, sample->value));
+}
+
+static void sleep_ms(unsigned int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static void sim_delay_us(unsigned int us) {
+    (void)us;
+}
+
+// The engine polls DOUT with delay_ms(0); keep that from spinning a core
+static void sim_delay_ms(unsigned int ms) {
+    struct timespec ts = { ms / 1000, ms ? (long)(ms % 1000) * 1000000L : 200000L };
+    nanosleep(&ts, NULL);
+}
+
+int main(int argc, char** argv) {
+    int cycles = argc >= 2 ? atoi(argv[1]) : 30;
+    float target = argc >= 3 ? (float)atof(argv[2]) : 500.0f;
+    float learn = argc >= 4 ? (float)atof(argv[3]) : 0.5f;
+
+    srand(1);
+    plant.flow_scale = 1.0;
+    hx711_sim_init(&sim, 0, SIM_PERIOD_NS);
+    hx711_sim_set_source(&sim, plant_source, &plant);
+    hx711_sim_attach(&sim);
+
+    hx711_backend_t backend = {
+        .gpio_write = hx711_sim_gpio_write,
+        .gpio_read = hx711_sim_gpio_read,
+        .delay_us = sim_delay_us,
+        .delay_ms = sim_delay_ms,
+    };
+    hx711_init_backend(&hx, 0, 0, &backend);
+    hx711_set_offset(&hx, (long)OFFSET_COUNTS);
+    hx711_set_scale(&hx, (float)COUNTS_PER_G);
+
+    hx711_dosing_init(&dose, 20.0f, plant_output, &plant);
+    hx711_dosing_set_learning(&dose, learn, 200.0f);
+
+    hx711_acq_set_sample_hook(&acq, on_sample, NULL);
+    if (hx711_acq_start(&acq, &hx) != 0) {
+        fprintf(stderr, "could not start acquisition\n");
+        return 1;
+    }
+
+    printf("%d cycles to %.1f g, learn %.2f; coarse %.0f g/s, fine %.0f g/s, valve %llu ms, fall %llu ms\n",
+           cycles, target, learn, COARSE_G_S, FINE_G_S, VALVE_DELAY_NS / 1000000ull, FALL_NS / 1000000ull);
+    printf("cycle  target    actual   over    preact  coarse    cut at    fill    cycle\n");
+
+    uint32_t seen = 0;
+    int settled = 0, faults = 0;
+    double err_sum = 0.0, err_sq = 0.0, err_max = 0.0, cycle_sum = 0.0;
+    for (int k = 0; k < cycles; k++) {
+        atomic_fetch_add(&plant.swap_req, 1);
+        sleep_ms(200);
+        hx711_dosing_start(&dose, target);
+
+        hx711_dose_cycle_t c;
+        while (!hx711_dosing_poll_cycle(&dose, &seen, &c)) sleep_ms(5);
+
+        printf("%5u  %6.1f  %8.2f  %+6.2f  %6.2f  %6.2f  %7.2f  %5.2f s  %5.2f s%s\n", c.index, c.target, c.actual,
+               c.overshoot, c.preact, c.coarse_preact, c.cut_weight, c.fill_ns / 1e9, c.cycle_ns / 1e9, c.fault ? "  FAULT" : "");
+        if (c.fault) {
+            faults++;
+            continue;
+        }
+        if (k < WARMUP_CYCLES) continue;
+        settled++;
+        err_sum += c.overshoot;
+        err_sq += (double)c.overshoot * c.overshoot;
+        if (fabs(c.overshoot) > err_max) err_max = fabs(c.overshoot);
+        cycle_sum += c.cycle_ns / 1e9;
+    }
+    hx711_acq_stop(&acq);
+
+    if (settled > 0) {
+        double mean = err_sum / settled;
+        printf("after %d warm-up cycles: mean error %+.2f g, sd %.2f g, max %.2f g, cycle %.2f s, %d faults, "
+               "%u rejected conversions skipped\n",
+               WARMUP_CYCLES, mean, sqrt(fmax(err_sq / settled - mean * mean, 0.0)), err_max, cycle_sum / settled,
+               faults, (unsigned)atomic_load(&rejected));
+    }
+    printf("preact %.2f g, coarse %.2f g; data-ready to valve command: mean %.1f us, max %.1f us over %u switches\n", dose.preact, dose.coarse_preact,
+           plant.lat_n ? plant.lat_sum / 1e3 / plant.lat_n : 0.0, plant.lat_max / 1e3, plant.lat_n);
+    hx711_acq_print_stats(&acq, stdout);
+    return 0;
+}
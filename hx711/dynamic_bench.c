@@ -0,0 +1,231 @@
+/**
+ *
+ * Time-to-hold and accuracy benchmark for hx711_dynamic
+ *
+ * Compile with: gcc -O2 dynamic_bench.c hx711_dynamic.c -o dynamic_bench -lm
+ *
+ * ./dynamic_bench trace.csv [min_load tolerance confidence]
+ *     Replays a recorded trace ("timestamp_ns,grams" per line, as written by
+ *     mw11 with "dyn_trace") and prints every hold.
+ * ./dynamic_bench
+ *     Synthesizes 80 SPS swinging-load traces (sack on a hook, sheep, calf)
+ *     and reports time to hold, held error against the true load, how often
+ *     the error is inside the tolerance, and the jitter a 5-sample average
+ *     shows on the same traces. "in tol" is what the lock confidence
+ *     promises and should not fall below it; a load that is not held within
+ *     its 12 s counts against "held", not against "in tol". No recorded
+ *     traces come with the repo, so this is only checked against these models.
+ *
+ */
+#define _GNU_SOURCE // M_PI
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "hx711_dynamic.h"
+
+#define SPS 80
+#define MAX_TRACE (SPS * 600) // Ten minutes
+#define LOAD_SECONDS 12       // Each synthetic load stays this long
+#define LOADS 1000
+
+static uint64_t trace_t[MAX_TRACE];
+static float trace_v[MAX_TRACE];
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static double gauss(void) {
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+// --- Recorded trace ---
+
+static void print_event(const hx711_dyn_event_t* ev, void* ctx) {
+    (void)ctx;
+    if (ev->held) {
+        printf("HOLD    %10.1f g  +/- %.1f g  %3.0f%%  after %.2f s\n", ev->value, ev->sem,
+               100.0f * ev->confidence, ev->elapsed_ns / 1e9);
+    } else {
+        printf("RELEASE\n");
+    }
+}
+
+static int replay(const char* path, float min_load, float tolerance, float confidence) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) { perror(path); return 1; }
+
+    int n = 0;
+    unsigned long long t;
+    float v;
+    while (n < MAX_TRACE && fscanf(fp, "%llu,%f", &t, &v) == 2) {
+        trace_t[n] = t;
+        trace_v[n] = v;
+        n++;
+    }
+    fclose(fp);
+    if (n < 2) { fprintf(stderr, "%s: no samples\n", path); return 1; }
+
+    static hx711_dynamic_t dyn;
+    hx711_dynamic_init(&dyn, min_load, tolerance, confidence, print_event, NULL);
+
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < n; i++) hx711_dynamic_push(&dyn, trace_t[i], trace_v[i]);
+    uint64_t cpu = now_ns() - t0;
+
+    printf("%d samples over %.1f s, processing %.0f ns per sample\n", n,
+           (double)(trace_t[n - 1] - trace_t[0]) / 1e9, (double)cpu / n);
+    return 0;
+}
+
+// --- Synthetic loads ---
+
+typedef struct {
+    const char* name;
+    double weight;       // True load, g
+    double tolerance;    // Hold tolerance, g
+    double swing_hz;     // Periodic swing (0 = none)
+    double swing_amp;    // Fraction of the load
+    double move_sd;      // Random movement, fraction of the load (low-passed)
+    double move_hz;      // Movement bandwidth
+    double kicks_per_s;  // Short knocks
+    double kick_amp;     // Fraction of the load
+    double arrive_s;     // Stepping on / hanging up
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    { "sack 25 kg, hook", 25000.0, 125.0,  1.4, 0.04, 0.005, 1.0, 0.0, 0.0, 0.5 },
+    { "sheep 60 kg",      60000.0, 500.0, 0.0, 0.0,  0.01,  1.5, 0.5, 0.25, 1.5 },
+    { "calf 150 kg",      150000.0, 1500.0, 0.0, 0.0, 0.02, 1.0, 1.0, 0.25, 2.0 },
+};
+
+// One load: arrival ramp with impact, then motion; the platform is empty before and after
+static int synth_load(const scenario_t* sc, int start, double weight) {
+    int n = LOAD_SECONDS * SPS;
+    double lp = 0.0;
+    double alpha = 1.0 - exp(-2.0 * M_PI * sc->move_hz / SPS);
+    double lp_gain = sqrt((2.0 - alpha) / alpha); // Keeps the low-passed noise at move_sd
+    double phase = 2.0 * M_PI * rand() / RAND_MAX;
+    int kick_left = 0;
+    double kick = 0.0;
+
+    for (int i = 0; i < n; i++) {
+        double t = (double)i / SPS;
+        double load = weight;
+
+        if (t < sc->arrive_s) {
+            load *= t / sc->arrive_s * (1.0 + 0.3 * sin(M_PI * t / sc->arrive_s));
+        }
+        lp += alpha * (gauss() - lp);
+        load += weight * sc->move_sd * lp_gain * lp;
+        load += weight * sc->swing_amp * exp(-t / 8.0) * sin(2.0 * M_PI * sc->swing_hz * t + phase);
+
+        if (kick_left == 0 && (double)rand() / RAND_MAX < sc->kicks_per_s / SPS) {
+            kick_left = 6 + rand() % 6;
+            kick = weight * sc->kick_amp * (rand() & 1 ? 1.0 : -1.0);
+        }
+        if (kick_left > 0) {
+            load += kick;
+            kick_left--;
+        }
+
+        trace_t[start + i] = (uint64_t)((start + i) * (1e9 / SPS));
+        trace_v[start + i] = (float)(load + 5.0 * gauss());
+    }
+    // One second empty
+    for (int i = 0; i < SPS; i++) {
+        trace_t[start + n + i] = (uint64_t)((start + n + i) * (1e9 / SPS));
+        trace_v[start + n + i] = (float)(5.0 * gauss());
+    }
+    return n + SPS;
+}
+
+typedef struct {
+    double truth;
+    bool held;
+    double hold_s;
+    double value;
+} load_result_t;
+
+static load_result_t result;
+
+static void score_event(const hx711_dyn_event_t* ev, void* ctx) {
+    (void)ctx;
+    if (!ev->held || result.held) return;
+    result.held = true;
+    result.hold_s = ev->elapsed_ns / 1e9;
+    result.value = ev->value;
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void run_scenario(const scenario_t* sc) {
+    static hx711_dynamic_t dyn;
+    static double hold_s[LOADS];
+    int held = 0, within = 0, held_5s = 0;
+    double err_sq = 0.0, err_max = 0.0, jitter_sum = 0.0;
+    uint64_t cpu = 0, samples = 0;
+
+    hx711_dynamic_init(&dyn, 0.2f * (float)sc->weight, (float)sc->tolerance, 0.95f, score_event, NULL);
+
+    for (int k = 0; k < LOADS; k++) {
+        double truth = sc->weight * (0.9 + 0.2 * rand() / RAND_MAX);
+        int n = synth_load(sc, 0, truth);
+        result = (load_result_t){ .truth = truth };
+
+        uint64_t t0 = now_ns();
+        for (int i = 0; i < n; i++) hx711_dynamic_push(&dyn, trace_t[i], trace_v[i]);
+        cpu += now_ns() - t0;
+        samples += (uint64_t)n;
+
+        // What the old display did: a 5-sample average, peak-to-peak over the last 3 s of the load
+        double lo = INFINITY, hi = -INFINITY;
+        for (int i = (LOAD_SECONDS - 3) * SPS; i < LOAD_SECONDS * SPS; i++) {
+            double avg = 0.0;
+            for (int j = 0; j < 5; j++) avg += trace_v[i - j];
+            avg /= 5.0;
+            if (avg < lo) lo = avg;
+            if (avg > hi) hi = avg;
+        }
+        jitter_sum += hi - lo;
+
+        if (!result.held) continue;
+        double err = result.value - truth;
+        hold_s[held++] = result.hold_s;
+        if (result.hold_s <= 5.0) held_5s++;
+        if (fabs(err) <= sc->tolerance) within++;
+        err_sq += err * err;
+        if (fabs(err) > err_max) err_max = fabs(err);
+    }
+
+    qsort(hold_s, (size_t)held, sizeof(double), cmp_double);
+    printf("%-17s %6.0f g  %3d/%d  %3d%%  %5.2f s  %5.2f s  %6.1f g  %6.1f g  %4d%%  %8.0f g  %5.0f ns\n",
+           sc->name, sc->tolerance, held, LOADS, 100 * held_5s / LOADS, held ? hold_s[held / 2] : 0.0,
+           held ? hold_s[held * 9 / 10] : 0.0, held ? sqrt(err_sq / held) : 0.0, err_max,
+           held ? 100 * within / held : 0, jitter_sum / LOADS, (double)cpu / samples);
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2) {
+        float min_load = argc >= 3 ? (float)atof(argv[2]) : 1000.0f;
+        float tolerance = argc >= 4 ? (float)atof(argv[3]) : 100.0f;
+        float confidence = argc >= 5 ? (float)atof(argv[4]) : 0.95f;
+        return replay(argv[1], min_load, tolerance, confidence);
+    }
+
+    srand(1);
+    printf("%d loads of %d s each per scenario, lock at 95%% confidence\n", LOADS, LOAD_SECONDS);
+    printf("scenario          tolerance  held  <=5s  median    p90       rms err   max err   in tol  5-avg p-p  cost\n");
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) run_scenario(&scenarios[i]);
+    return 0;
+}
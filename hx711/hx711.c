@@ -6,33 +6,70 @@
  * to achieve maximum timing stability on a preemptive OS.
  *
  */
+#define _GNU_SOURCE // CPU_SET, pthread_setaffinity_np
 #include "hx711.h"
+#include "hx711_timing.h"
+#include "hx711_fast.h"
+#include "hx711_curve.h"
 #include <sched.h>
 #include <signal.h>
 #include <string.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
+#include <math.h>
 #include <pthread.h> // <-- THE MISSING HEADER
+#include <time.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <linux/futex.h>
 
 // Initialize the HX711 struct
 void hx711_init(hx711_t* hx, int dout_pin, int sck_pin,
                 gpio_write_func write_func, gpio_read_func read_func,
                 delay_us_func us_func, delay_ms_func ms_func) {
+    hx711_backend_t backend = {
+        .gpio_write = write_func,
+        .gpio_read = read_func,
+        .delay_us = us_func,
+        .delay_ms = ms_func,
+    };
+    hx711_init_backend(hx, dout_pin, sck_pin, &backend);
+}
+
+void hx711_init_backend(hx711_t* hx, int dout_pin, int sck_pin, const hx711_backend_t* backend) {
     hx->dout_pin = dout_pin;
     hx->sck_pin = sck_pin;
-    hx->gpio_write = write_func;
-    hx->gpio_read = read_func;
-    hx->delay_us = us_func;
-    hx->delay_ms = ms_func;
+    hx->gpio_write = backend->gpio_write;
+    hx->gpio_read = backend->gpio_read;
+    hx->delay_us = backend->delay_us;
+    hx->delay_ms = backend->delay_ms;
+    hx->wait_ready = backend->wait_ready;
+    hx->read_sample = backend->read_sample;
+    hx->read_sample_rt = backend->read_sample_rt;
     hx->offset = 0;
     hx->scale = 1.0f;
+    hx->curve = NULL;
+    hx->rt_context = false;
+    hx->delay_ns = NULL;
+    hx->pulse_ns = 0;
+    hx->capture_timing = false;
+    hx->last_ready_ns = 0;
+    memset(&hx->last_timing, 0, sizeof(hx->last_timing));
+    hx->input_gain = 1; // Channel A, gain 128 after power-up
+    hx->last_flags = 0;
+    memset(&hx->integrity, 0, sizeof(hx->integrity));
+    hx->integrity.frozen_repeats = HX711_FROZEN_REPEATS;
 
-    hx->gpio_write(hx->sck_pin, 0); // Start with clock low
+    if (hx->gpio_write) hx->gpio_write(hx->sck_pin, 0); // Start with clock low
     hx711_set_gain(hx, 128);
 }
 
 bool hx711_is_ready(hx711_t* hx) {
-    return hx->gpio_read(hx->dout_pin) == 0;
+    return hx->gpio_read && hx->gpio_read(hx->dout_pin) == 0;
 }
 
 void hx711_set_gain(hx711_t* hx, uint8_t gain) {
@@ -41,89 +78,433 @@ void hx711_set_gain(hx711_t* hx, uint8_t gain) {
         case 64:  hx->gain = 3; break;
         case 32:  hx->gain = 2; break;
     }
+    hx->main_gain = hx->gain;
 }
 
-long hx711_read(hx711_t* hx) {
-    while (!hx711_is_ready(hx)) {
-        hx->delay_ms(0);
+// --- Clock pulse helpers ---
+
+// SCK hold: sub-microsecond when a ns delay is configured, else delay_us(1)
+static inline void pulse_hold(hx711_t* hx) {
+    if (hx->delay_ns) {
+        hx->delay_ns(hx->pulse_ns);
+    } else {
+        hx->delay_us(1);
     }
+}
+
+static inline uint64_t pulse_stamp(hx711_t* hx) {
+    (void)hx;
+    return hx711_time_ns(); // Every high phase is timed for the OVERRUN check
+}
+
+static inline void pulse_begin(hx711_t* hx) {
+    hx->integrity.sck_high_max_ns = 0;
+    if (!hx->capture_timing) return;
+    memset(&hx->last_timing, 0, sizeof(hx->last_timing));
+    hx->last_timing.sck_high_min_ns = UINT32_MAX;
+}
+
+// Records one SCK-high phase, measured from before the rising write to
+// after the falling write, i.e. the longest the chip could have seen it high
+static inline void pulse_end(hx711_t* hx, uint64_t t_rise) {
+    uint64_t t_fall = hx711_time_ns();
+    uint32_t high = (uint32_t)(t_fall - t_rise);
+
+    if (high > hx->integrity.sck_high_max_ns) hx->integrity.sck_high_max_ns = high;
+    if (!hx->capture_timing) return;
+
+    hx711_pulse_timing_t* pt = &hx->last_timing;
+    if (pt->pulses == 0) {
+        pt->first_rise_ns = t_rise;
+    } else {
+        uint32_t low = (uint32_t)(t_rise - pt->last_fall_ns);
+        if (low > pt->sck_low_max_ns) pt->sck_low_max_ns = low;
+    }
+    if (high > pt->sck_high_max_ns) pt->sck_high_max_ns = high;
+    if (high < pt->sck_high_min_ns) pt->sck_high_min_ns = high;
+    pt->last_fall_ns = t_fall;
+    pt->total_ns = (uint32_t)(t_fall - pt->first_rise_ns);
+    pt->pulses++;
+}
+
+long hx711_sign_extend24(uint32_t raw) {
+    return (long)((int32_t)(raw << 8) >> 8);
+}
+
+// A persistent RT thread (hx711_acq_start_rt) already runs SCHED_FIFO
+// with every signal blocked, so only the legacy path pays for this.
+void hx711_critical_enter(bool rt_context, hx711_rt_saved_t* saved) {
+    struct sched_param new_param;
+    sigset_t new_mask;
+
+    if (rt_context) return;
 
-    unsigned long value = 0;
-    
-    // --- BEGIN CRITICAL TIMING SECTION ---
-    struct sched_param old_param, new_param;
-    int old_policy;
-    
     // Get current scheduling policy and priority
-    pthread_getschedparam(pthread_self(), &old_policy, &old_param);
-    
+    saved->policy = SCHED_OTHER;
+    pthread_getschedparam(pthread_self(), &saved->policy, &saved->param);
+
     // Set to real-time FIFO scheduling with high priority
     memset(&new_param, 0, sizeof(new_param));
     new_param.sched_priority = sched_get_priority_max(SCHED_FIFO);
     if (sched_setscheduler(0, SCHED_FIFO, &new_param) != 0) {
         // Non-fatal error, we can still try. Might fail if not run with sudo.
     }
-    
+
     // Block signals
-    sigset_t old_mask, new_mask;
     sigfillset(&new_mask);
-    pthread_sigmask(SIG_BLOCK, &new_mask, &old_mask);
+    pthread_sigmask(SIG_BLOCK, &new_mask, &saved->mask);
+}
+
+void hx711_critical_leave(bool rt_context, const hx711_rt_saved_t* saved) {
+    if (rt_context) return;
+
+    // Restore original signal mask
+    pthread_sigmask(SIG_SETMASK, &saved->mask, NULL);
+
+    // Restore original scheduling policy
+    sched_setscheduler(0, saved->policy, &saved->param);
+}
+
+// Clocks out one conversion. The caller has already seen DOUT go low.
+// Returns -1 if the transport failed; there is no value then.
+static int clock_conversion(hx711_t* hx, long* out) {
+    unsigned long value = 0;
+    bool failed = false;
+    hx711_rt_saved_t saved;
+
+    // Whole-sample transport: the controller (or a specialized loop) generates the clock train
+    if (hx->read_sample) {
+        uint32_t raw = 0;
+        hx711_fast_high_max_ns = 0;
+        if (hx->read_sample_rt) hx711_critical_enter(hx->rt_context, &saved);
+        int ret = hx->read_sample(hx->gain, &raw);
+        if (hx->read_sample_rt) hx711_critical_leave(hx->rt_context, &saved);
+        hx->integrity.sck_high_max_ns = hx711_fast_high_max_ns;
+        if (ret != 0) return -1;
+        *out = hx711_sign_extend24(raw);
+        return 0;
+    }
+    
+    // --- BEGIN CRITICAL TIMING SECTION ---
+    hx711_critical_enter(hx->rt_context, &saved);
 
     // --- Bit-banging read loop ---
+    pulse_begin(hx);
     for (int i = 0; i < 24; ++i) {
+        uint64_t t_rise = pulse_stamp(hx);
         hx->gpio_write(hx->sck_pin, 1);
-        hx->delay_us(1);
+        pulse_hold(hx);
         value <<= 1;
-        if (hx->gpio_read(hx->dout_pin)) {
+        int bit = hx->gpio_read(hx->dout_pin);
+        if (bit < 0) {
+            failed = true; // Keep clocking so the chip finishes the train
+        } else if (bit) {
             value++;
         }
         hx->gpio_write(hx->sck_pin, 0);
-        hx->delay_us(1);
+        pulse_end(hx, t_rise);
+        pulse_hold(hx);
     }
     
-    // Restore original signal mask
-    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
-    
-    // Restore original scheduling policy
-    sched_setscheduler(0, old_policy, &old_param);
+    hx711_critical_leave(hx->rt_context, &saved);
     
     // --- END CRITICAL TIMING SECTION ---
 
     // Set gain for the next reading
     for (unsigned int i = 0; i < hx->gain; i++) {
+        uint64_t t_rise = pulse_stamp(hx);
         hx->gpio_write(hx->sck_pin, 1);
-        hx->delay_us(1);
+        pulse_hold(hx);
         hx->gpio_write(hx->sck_pin, 0);
-        hx->delay_us(1);
+        pulse_end(hx, t_rise);
+        pulse_hold(hx);
+    }
+
+    if (failed) return -1;
+    *out = hx711_sign_extend24((uint32_t)value);
+    return 0;
+}
+
+// The chip powers down only if SCK stays high past 60 us; a stall with SCK
+// low just stretches the read. Every high phase of the read was timed.
+static bool clock_overrun(hx711_t* hx) {
+    return hx->integrity.sck_high_max_ns > HX711_SCK_POWER_DOWN_NS;
+}
+
+// Jump check against the trend prediction, so a steady ramp is followed. A
+// value off the prediction is held back until HX711_JUMP_CONFIRM of them in a
+// row agree on a new level or ramp; an isolated glitch never does.
+static bool jumped(hx711_integrity_t* in, long value) {
+    if (!in->have_ref || labs(value - (in->ref + in->trend)) <= in->jump_limit) {
+        in->trend = in->have_ref ? in->trend + (value - in->ref - in->trend) / 2 : 0;
+        in->have_pending = false;
+        return false;
     }
 
-    if (value & 0x800000) {
-        value |= 0xFF000000;
+    long step = in->have_pending ? value - in->pending : 0;
+    if (in->have_pending && labs(value - (in->pending + in->pending_step)) <= in->jump_limit) {
+        in->pending_run++;
+    } else {
+        in->pending_run = 1;
     }
+    in->pending = value;
+    in->pending_step = step;
+    in->have_pending = true;
+    if (in->pending_run < HX711_JUMP_CONFIRM) return true;
 
-    return (long)value;
+    in->trend = step;
+    in->have_pending = false;
+    return false;
 }
 
-long hx711_read_average(hx711_t* hx, uint8_t times) {
-    long sum = 0;
-    for (uint8_t i = 0; i < times; i++) {
-        sum += hx711_read(hx);
-        hx->delay_ms(10); // A small rest between full readings
+// Flags one conversion and counts it. Frozen, jump and stuck-bit state
+// follows the main input only, so interleaved channel-B reads do not disturb it.
+static uint8_t check_conversion(hx711_t* hx, long value, uint8_t input) {
+    hx711_integrity_t* in = &hx->integrity;
+    uint8_t flags = hx->last_flags;
+
+    if (value == 0x7FFFFF || value == -0x800000) flags |= HX711_FLAG_SATURATED;
+    if (hx->gpio_write && (!hx->read_sample || hx->read_sample_rt) && clock_overrun(hx)) {
+        flags |= HX711_FLAG_OVERRUN;
+    }
+
+    if (input == hx->main_gain) {
+        in->repeats = (in->checked && value == in->prev) ? in->repeats + 1 : 1;
+        in->prev = value;
+        if (in->frozen_repeats && in->repeats >= in->frozen_repeats) flags |= HX711_FLAG_FROZEN;
+
+        // A real load change holds its new level or ramp; a glitch does not
+        if (in->jump_limit && !(flags & HX711_FLAGS_REJECT) && jumped(in, value)) {
+            flags |= HX711_FLAG_JUMP;
+        }
+        if (!(flags & HX711_FLAGS_REJECT)) {
+            in->ref = value;
+            in->have_ref = true;
+        }
+
+        uint32_t bits = (uint32_t)value & HX711_STUCK_BITS;
+        in->bits_and = in->window ? in->bits_and & bits : bits;
+        in->bits_or = in->window ? in->bits_or | bits : bits;
+        if (++in->window == HX711_STUCK_WINDOW) {
+            in->stuck_mask = (in->bits_and | ~in->bits_or) & HX711_STUCK_BITS;
+            in->window = 0;
+        }
+        if (in->stuck_mask) flags |= HX711_FLAG_STUCK_BIT;
+    }
+
+    in->checked++;
+    if (flags & HX711_FLAG_SATURATED) in->saturated++;
+    if (flags & HX711_FLAG_FROZEN) in->frozen++;
+    if (flags & HX711_FLAG_OVERRUN) in->overrun++;
+    if (flags & HX711_FLAG_JUMP) in->jumps++;
+    if (flags & HX711_FLAGS_REJECT) in->rejected++;
+    return flags;
+}
+
+// Reads and checks one conversion; the flags are left in hx->last_flags.
+// A failed transport read is counted and returns -1 without a value.
+static int read_conversion(hx711_t* hx, long* value) {
+    uint8_t input = hx->input_gain;
+
+    hx->last_flags = 0;
+    int ret = clock_conversion(hx, value);
+
+    // The pulses just sent select the input of the next conversion
+    hx->input_gain = hx->gain;
+    if (ret != 0) {
+        hx->last_flags = HX711_FLAG_READ_ERROR;
+        hx->integrity.checked++;
+        hx->integrity.read_errors++;
+        hx->integrity.rejected++;
+        return -1;
+    }
+    hx->last_flags = check_conversion(hx, *value, input);
+    return 0;
+}
+
+// Waits for DOUT to go low and records when it did. Returns 1 when ready,
+// 0 if nothing arrived within timeout_ms (event wait only; polling never
+// times out) and -1 if the wait failed on a backend that cannot be polled
+// or reading DOUT failed.
+static int wait_until_ready(hx711_t* hx, int timeout_ms) {
+    if (hx->wait_ready) {
+        uint64_t ready_ns = 0;
+        int ret = hx->wait_ready(hx->dout_pin, timeout_ms, &ready_ns);
+        if (ret == 1) {
+            hx->last_ready_ns = ready_ns;
+            return 1;
+        }
+        if (ret == 0) return 0;
+    }
+
+    // Event wait broken or absent: poll DOUT if there is one, else rest and report it
+    if (!hx->gpio_read) {
+        hx->integrity.read_errors++;
+        hx->delay_ms(HX711_ERROR_BACKOFF_MS);
+        return -1;
+    }
+
+    int dout;
+    while ((dout = hx->gpio_read(hx->dout_pin)) != 0) {
+        if (dout < 0) {
+            hx->integrity.read_errors++;
+            hx->delay_ms(HX711_ERROR_BACKOFF_MS);
+            return -1;
+        }
+        hx->delay_ms(0);
+    }
+    hx->last_ready_ns = hx711_time_ns();
+    return 1;
+}
+
+int hx711_read_value(hx711_t* hx, long* value) {
+    int ret;
+    while ((ret = wait_until_ready(hx, HX711_READY_TIMEOUT_MS)) == 0) {
+        // keep waiting
+    }
+    if (ret < 0) {
+        hx->last_flags = HX711_FLAG_READ_ERROR;
+        return -1;
+    }
+    return read_conversion(hx, value);
+}
+
+long hx711_read(hx711_t* hx) {
+    long value = 0;
+    return hx711_read_value(hx, &value) == 0 ? value : 0;
+}
+
+// --- Streaming accumulator ---
+
+void hx711_stat_reset(hx711_stat_t* st) {
+    memset(st, 0, sizeof(*st));
+}
+
+void hx711_stat_push(hx711_stat_t* st, long value) {
+    if (st->count == 0) {
+        st->first = value;
+        st->min = value;
+        st->max = value;
+    }
+    if (value < st->min) st->min = value;
+    if (value > st->max) st->max = value;
+
+    double d = (double)(value - st->first);
+    st->sum += value;
+    st->sum_sq += d * d;
+    st->count++;
+}
+
+uint32_t hx711_stat_count(const hx711_stat_t* st) {
+    return st->count;
+}
+
+long hx711_stat_mean(const hx711_stat_t* st) {
+    return st->count ? (long)(st->sum / (int64_t)st->count) : 0;
+}
+
+double hx711_stat_variance(const hx711_stat_t* st) {
+    if (st->count < 2) return 0.0;
+    double n = (double)st->count;
+    double d = (double)(st->sum - (int64_t)st->first * (int64_t)st->count); // Sum of (value - first)
+    double var = (st->sum_sq - d * d / n) / (n - 1.0);
+    return var > 0.0 ? var : 0.0;
+}
+
+double hx711_stat_sem(const hx711_stat_t* st) {
+    if (st->count < 2) return HUGE_VAL;
+    return sqrt(hx711_stat_variance(st) / (double)st->count);
+}
+
+// Every good conversion is used: the next one is clocked out as soon as DOUT drops
+void hx711_read_stat(hx711_t* hx, uint32_t times, hx711_stat_t* st) {
+    uint32_t good = 0;
+    uint64_t budget = 2ull * times + HX711_REJECT_EXTRA;
+
+    for (uint64_t i = 0; i < budget && good < times; i++) {
+        long value;
+        if (hx711_read_value(hx, &value) != 0 || (hx->last_flags & HX711_FLAGS_REJECT)) continue;
+        hx711_stat_push(st, value);
+        good++;
     }
-    return sum / times;
+}
+
+long hx711_read_average(hx711_t* hx, uint8_t times) {
+    long average = 0;
+    hx711_read_average_value(hx, times, &average);
+    return average;
+}
+
+int hx711_read_average_value(hx711_t* hx, uint8_t times, long* average) {
+    hx711_stat_t st;
+    hx711_stat_reset(&st);
+    hx711_read_stat(hx, times, &st);
+    if (hx711_stat_count(&st) == 0) return -1;
+    *average = hx711_stat_mean(&st);
+    return 0;
 }
 
 double hx711_get_value(hx711_t* hx, uint8_t times) {
-    return hx711_read_average(hx, times) - hx->offset;
+    long average;
+    if (hx711_read_average_value(hx, times, &average) != 0) return NAN;
+    return average - hx->offset;
 }
 
 float hx711_get_units(hx711_t* hx, uint8_t times) {
-    return (float)hx711_get_value(hx, times) / hx->scale;
+    long average;
+    if (hx711_read_average_value(hx, times, &average) != 0) return NAN;
+    return hx711_raw_to_units(hx, average);
+}
+
+float hx711_raw_to_units(hx711_t* hx, long raw) {
+    if (hx->curve) return hx711_curve_eval(hx->curve, raw - hx->offset);
+    return (float)(raw - hx->offset) / hx->scale;
+}
+
+void hx711_set_curve(hx711_t* hx, const struct hx711_curve_s* curve) {
+    hx->curve = (curve && curve->built) ? curve : NULL;
 }
 
 void hx711_tare(hx711_t* hx, uint8_t times) {
-    long sum = hx711_read_average(hx, times);
-    hx711_set_offset(hx, sum);
+    hx711_stat_t st;
+    hx711_stat_reset(&st);
+    hx711_read_stat(hx, times, &st);
+
+    // Nothing but rejected conversions: keep the old zero rather than a bad one
+    if (hx711_stat_count(&st) > 0) hx711_set_offset(hx, hx711_stat_mean(&st));
+}
+
+void hx711_set_pulse_ns(hx711_t* hx, delay_ns_func ns_func, unsigned int pulse_ns) {
+    hx->delay_ns = ns_func;
+    hx->pulse_ns = pulse_ns;
+}
+
+void hx711_set_wait_ready(hx711_t* hx, wait_ready_func wait_func) {
+    hx->wait_ready = wait_func;
+}
+
+void hx711_capture_timing(hx711_t* hx, bool enable) {
+    hx->capture_timing = enable;
+}
+
+void hx711_set_integrity_limits(hx711_t* hx, long jump_limit, uint32_t frozen_repeats) {
+    hx->integrity.jump_limit = jump_limit;
+    hx->integrity.frozen_repeats = frozen_repeats;
+}
+
+static void print_integrity(const hx711_integrity_t* in, FILE* out) {
+    fprintf(out, "HX711 integrity: %llu checked, %llu rejected (saturated %llu, frozen %llu, "
+            "overrun %llu, jump %llu, read error %llu)",
+            (unsigned long long)in->checked, (unsigned long long)in->rejected,
+            (unsigned long long)in->saturated, (unsigned long long)in->frozen,
+            (unsigned long long)in->overrun, (unsigned long long)in->jumps,
+            (unsigned long long)in->read_errors);
+    if (in->stuck_mask) fprintf(out, ", stuck bits 0x%x", (unsigned)in->stuck_mask);
+    fprintf(out, "\n");
+}
+
+void hx711_print_integrity(const hx711_t* hx, FILE* out) {
+    print_integrity(&hx->integrity, out);
 }
 
 void hx711_set_scale(hx711_t* hx, float scale) {
@@ -143,10 +524,530 @@ long hx711_get_offset(hx711_t* hx) {
 }
 
 void hx711_power_down(hx711_t* hx) {
+    if (!hx->gpio_write) return; // Clock owned by a transport
     hx->gpio_write(hx->sck_pin, 0);
     hx->gpio_write(hx->sck_pin, 1);
 }
 
 void hx711_power_up(hx711_t* hx) {
+    if (!hx->gpio_write) return;
     hx->gpio_write(hx->sck_pin, 0);
 }
+
+// --- Acquisition engine ---
+
+#define HX711_RING_MASK (HX711_RING_SIZE - 1)
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void ring_push(hx711_ring_t* ring, long value, uint64_t timestamp_ns, uint64_t ready_ns, uint16_t sps,
+                      uint8_t flags) {
+    uint64_t seq = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    hx711_slot_t* slot = &ring->slots[seq & HX711_RING_MASK];
+
+    atomic_store_explicit(&slot->lock, 2 * seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->sample.value = value;
+    slot->sample.timestamp_ns = timestamp_ns;
+    slot->sample.ready_ns = ready_ns;
+    slot->sample.seq = seq;
+    slot->sample.sps = sps;
+    slot->sample.flags = flags;
+    atomic_store_explicit(&slot->lock, 2 * seq + 2, memory_order_release);
+    atomic_store_explicit(&ring->head, seq + 1, memory_order_release);
+
+    // Only pay for the futex syscall when somebody is actually asleep
+    atomic_fetch_add(&ring->wake, 1);
+    if (atomic_load(&ring->waiters) > 0) {
+        syscall(SYS_futex, &ring->wake, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+    }
+}
+
+// Copies sample `seq` out of the ring. Returns false if it was overwritten.
+static bool ring_copy(hx711_ring_t* ring, uint64_t seq, hx711_sample_t* out) {
+    hx711_slot_t* slot = &ring->slots[seq & HX711_RING_MASK];
+    uint64_t expect = 2 * seq + 2;
+
+    if (atomic_load_explicit(&slot->lock, memory_order_acquire) != expect) {
+        return false;
+    }
+    *out = slot->sample;
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&slot->lock, memory_order_relaxed) == expect;
+}
+
+// Touch the stack once so the read loop never takes a page fault
+static void __attribute__((noinline)) prefault_stack(size_t bytes) {
+    unsigned char buf[bytes];
+    memset(buf, 0, bytes);
+    __asm__ __volatile__("" : : "r"(buf) : "memory");
+}
+
+// One-time RT setup. Returns 0 or the errno of the first step that failed.
+static int rt_setup(const hx711_rt_config_t* rt) {
+    int err = 0;
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0 && !err) err = errno;
+
+    if (rt->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(rt->cpu, &set);
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (ret != 0 && !err) err = ret;
+    }
+
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = rt->priority > 0 ? rt->priority : sched_get_priority_max(SCHED_FIFO);
+    int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (ret != 0 && !err) err = ret;
+
+    sigset_t mask;
+    sigfillset(&mask);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    prefault_stack(rt->stack_prefault ? rt->stack_prefault : HX711_RT_STACK_PREFAULT);
+    return err;
+}
+
+static void stats_add_pulses(hx711_acq_stats_t* st, const hx711_pulse_timing_t* pt) {
+    if (pt->pulses == 0) return;
+    if (pt->sck_high_max_ns > st->sck_high_ns_max) st->sck_high_ns_max = pt->sck_high_max_ns;
+    if (pt->total_ns > st->clockout_ns_max) st->clockout_ns_max = pt->total_ns;
+    st->clockout_pulses = pt->pulses;
+}
+
+static void stats_add(hx711_acq_stats_t* st, uint64_t read_ns, uint64_t period_ns) {
+    if (st->samples == 0 || read_ns < st->read_ns_min) st->read_ns_min = read_ns;
+    if (read_ns > st->read_ns_max) st->read_ns_max = read_ns;
+    st->read_ns_sum += read_ns;
+    st->read_ns_sq += (double)read_ns * (double)read_ns;
+
+    if (period_ns) {
+        if (st->periods == 0 || period_ns < st->period_ns_min) st->period_ns_min = period_ns;
+        if (period_ns > st->period_ns_max) st->period_ns_max = period_ns;
+        st->periods++;
+    }
+    st->samples++;
+}
+
+// Publishes the counters for hx711_acq_snapshot(); acquisition thread only
+static void stats_publish(hx711_acq_t* acq) {
+    uint32_t seq = atomic_load_explicit(&acq->snap_seq, memory_order_relaxed);
+
+    atomic_store_explicit(&acq->snap_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    acq->snap.stats = acq->stats;
+    acq->snap.timing = acq->hx->last_timing;
+    acq->snap.integrity = acq->hx->integrity;
+    acq->snap.rate_cur = acq->rate_cur;
+    acq->snap.rate_switches = acq->rate_switches;
+    acq->snap.aux_lost = acq->aux_lost;
+    acq->snap.aux_samples = atomic_load_explicit(&acq->aux_ring.head, memory_order_relaxed);
+    atomic_store_explicit(&acq->snap_seq, seq + 2, memory_order_release);
+}
+
+// Applies a pending RATE request; the chip switches with the next conversion
+static void rate_apply(hx711_acq_t* acq) {
+    uint16_t req = atomic_load_explicit(&acq->rate_req, memory_order_relaxed);
+    if (!acq->rate_write || req == acq->rate_cur) return;
+
+    acq->rate_write(acq->rate_pin, req == HX711_SPS_FAST);
+    acq->rate_cur = req;
+    acq->rate_discard = HX711_RATE_SETTLE_SAMPLES;
+    acq->rate_switches++;
+}
+
+// Channel-B interleave. The gain pulses after a read select the input of the
+// following conversion, so the schedule runs one conversion ahead:
+// A ... A (B pulses) | B settling | B kept (A pulses) | A settling | A ...
+#define HX711_CHANNEL_B_PULSES 2 // Channel B, gain 32
+
+enum { AUX_MAIN, AUX_B_SETTLE, AUX_B_SAMPLE, AUX_A_SETTLE };
+
+// Gain pulses for the coming read; moves aux_state on to the input they select
+static uint8_t aux_advance(hx711_acq_t* acq) {
+    switch (acq->aux_state) {
+    case AUX_MAIN:
+        if (++acq->aux_count < acq->aux_every) return acq->aux_main_gain;
+        acq->aux_count = 0;
+        acq->aux_left = HX711_AUX_SETTLE_SAMPLES;
+        acq->aux_state = acq->aux_left ? AUX_B_SETTLE : AUX_B_SAMPLE;
+        return HX711_CHANNEL_B_PULSES;
+    case AUX_B_SETTLE:
+        if (--acq->aux_left == 0) acq->aux_state = AUX_B_SAMPLE;
+        return HX711_CHANNEL_B_PULSES;
+    case AUX_B_SAMPLE:
+        acq->aux_left = HX711_AUX_SETTLE_SAMPLES;
+        acq->aux_state = acq->aux_left ? AUX_A_SETTLE : AUX_MAIN;
+        return acq->aux_main_gain;
+    default:
+        if (--acq->aux_left == 0) acq->aux_state = AUX_MAIN;
+        return acq->aux_main_gain;
+    }
+}
+
+// Wake an epoll consumer; a full counter (never drained) just drops the post
+static void notify_post(int fd) {
+    uint64_t one = 1;
+    ssize_t ret = write(fd, &one, sizeof(one));
+    (void)ret;
+}
+
+static void* acq_thread(void* arg) {
+    hx711_acq_t* acq = (hx711_acq_t*)arg;
+    hx711_t* hx = acq->hx;
+    uint64_t last_ns = 0;
+
+    if (acq->rt.enabled) {
+        acq->rt_error = rt_setup(&acq->rt);
+        hx->rt_context = true;
+    }
+
+    while (atomic_load_explicit(&acq->running, memory_order_relaxed)) {
+        rate_apply(acq);
+
+        // Time out now and then so hx711_acq_stop() is noticed; a failed
+        // wait has already backed off
+        if (wait_until_ready(hx, HX711_READY_TIMEOUT_MS) != 1) continue;
+
+        uint8_t input = acq->aux_state;
+        if (acq->aux_every) hx->gain = aux_advance(acq);
+
+        uint64_t t0 = monotonic_ns();
+        long value;
+        int ret = read_conversion(hx, &value);
+        uint64_t t1 = monotonic_ns();
+
+        // Nothing was read: publish nothing, and let a failing transport rest
+        if (ret != 0) {
+            if (acq->rate_discard) acq->rate_discard--;
+            last_ns = 0;
+            stats_publish(acq);
+            hx->delay_ms(HX711_ERROR_BACKOFF_MS);
+            continue;
+        }
+
+        // Output still settling after a RATE change: keep it out of the stream
+        if (acq->rate_discard) {
+            acq->rate_discard--;
+            last_ns = 0;
+            stats_publish(acq);
+            continue;
+        }
+
+        if (input != AUX_MAIN) {
+            if (input == AUX_B_SAMPLE) ring_push(&acq->aux_ring, value, t1, hx->last_ready_ns, acq->rate_cur, hx->last_flags);
+            acq->aux_lost++;
+            last_ns = 0;
+            stats_publish(acq);
+            continue;
+        }
+
+        ring_push(&acq->ring, value, t1, hx->last_ready_ns, acq->rate_cur, hx->last_flags);
+        if (acq->hook) {
+            hx711_sample_t sample = {
+                .value = value,
+                .timestamp_ns = t1,
+                .ready_ns = hx->last_ready_ns,
+                .seq = atomic_load_explicit(&acq->ring.head, memory_order_relaxed) - 1,
+                .sps = acq->rate_cur,
+                .flags = hx->last_flags,
+            };
+            acq->hook(&sample, acq->hook_ctx);
+        }
+        if (acq->notify) notify_post(acq->notify_fd);
+        stats_add(&acq->stats, t1 - t0, last_ns ? t1 - last_ns : 0);
+        stats_add_pulses(&acq->stats, &hx->last_timing);
+        stats_publish(acq);
+        last_ns = t1;
+    }
+
+    if (acq->aux_every) hx->gain = acq->aux_main_gain;
+    hx->rt_context = false;
+    return NULL;
+}
+
+int hx711_acq_start(hx711_acq_t* acq, hx711_t* hx) {
+    return hx711_acq_start_rt(acq, hx, NULL);
+}
+
+void hx711_acq_set_rate_pin(hx711_acq_t* acq, gpio_write_func write_func, int rate_pin, int sps) {
+    acq->rate_write = write_func;
+    acq->rate_pin = rate_pin;
+    acq->rate_cur = 0; // Forces the first rate_apply() to drive the pin
+    acq->rate_discard = 0;
+    acq->rate_switches = 0;
+    atomic_store(&acq->rate_req, (uint16_t)(sps == HX711_SPS_FAST ? HX711_SPS_FAST : HX711_SPS_SLOW));
+}
+
+void hx711_acq_request_rate(hx711_acq_t* acq, int sps) {
+    if (!acq->rate_write) return;
+    atomic_store_explicit(&acq->rate_req, (uint16_t)(sps == HX711_SPS_FAST ? HX711_SPS_FAST : HX711_SPS_SLOW),
+                          memory_order_relaxed);
+}
+
+void hx711_acq_set_channel_b(hx711_acq_t* acq, uint32_t every) {
+    acq->aux_every = every;
+}
+
+void hx711_acq_set_sample_hook(hx711_acq_t* acq, hx711_sample_hook_func hook, void* ctx) {
+    acq->hook = hook;
+    acq->hook_ctx = ctx;
+}
+
+int hx711_acq_notify_fd(hx711_acq_t* acq) {
+    if (!acq->notify) {
+        int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd < 0) return -1;
+        acq->notify_fd = fd;
+        acq->notify = true;
+    }
+    return acq->notify_fd;
+}
+
+int hx711_acq_start_rt(hx711_acq_t* acq, hx711_t* hx, const hx711_rt_config_t* rt) {
+    memset(&acq->ring, 0, sizeof(acq->ring));
+    memset(&acq->aux_ring, 0, sizeof(acq->aux_ring));
+    acq->aux_main_gain = hx->gain;
+    acq->aux_state = AUX_MAIN;
+    acq->aux_count = 0;
+    acq->aux_left = 0;
+    acq->aux_lost = 0;
+    memset(&acq->stats, 0, sizeof(acq->stats));
+    memset(&acq->snap, 0, sizeof(acq->snap));
+    atomic_store(&acq->snap_seq, 0);
+    memset(&acq->rt, 0, sizeof(acq->rt));
+    if (rt) acq->rt = *rt;
+    acq->rt_error = 0;
+    acq->hx = hx;
+    atomic_store(&acq->running, true);
+
+    if (pthread_create(&acq->thread, NULL, acq_thread, acq) != 0) {
+        atomic_store(&acq->running, false);
+        return -1;
+    }
+    return 0;
+}
+
+void hx711_acq_stop(hx711_acq_t* acq) {
+    if (!atomic_exchange(&acq->running, false)) return;
+    pthread_join(acq->thread, NULL);
+}
+
+static void ring_reader_init(hx711_ring_t* ring, hx711_reader_t* reader) {
+    reader->next = atomic_load_explicit(&ring->head, memory_order_acquire);
+    reader->dropped = 0;
+}
+
+static int ring_poll(hx711_ring_t* ring, hx711_reader_t* reader, hx711_sample_t* out) {
+    for (;;) {
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (reader->next >= head) return 0;
+
+        // Lapped by the producer: skip to the oldest sample still in the ring
+        if (head - reader->next > HX711_RING_SIZE) {
+            reader->dropped += head - HX711_RING_SIZE - reader->next;
+            reader->next = head - HX711_RING_SIZE;
+        }
+
+        if (ring_copy(ring, reader->next, out)) {
+            reader->next++;
+            return 1;
+        }
+        reader->dropped++;
+        reader->next++;
+    }
+}
+
+void hx711_acq_reader_init(hx711_acq_t* acq, hx711_reader_t* reader) {
+    ring_reader_init(&acq->ring, reader);
+}
+
+int hx711_acq_poll(hx711_acq_t* acq, hx711_reader_t* reader, hx711_sample_t* out) {
+    return ring_poll(&acq->ring, reader, out);
+}
+
+void hx711_acq_aux_reader_init(hx711_acq_t* acq, hx711_reader_t* reader) {
+    ring_reader_init(&acq->aux_ring, reader);
+}
+
+int hx711_acq_aux_poll(hx711_acq_t* acq, hx711_reader_t* reader, hx711_sample_t* out) {
+    return ring_poll(&acq->aux_ring, reader, out);
+}
+
+int hx711_acq_wait(hx711_acq_t* acq, hx711_reader_t* reader, hx711_sample_t* out, int timeout_ms) {
+    uint64_t deadline = timeout_ms < 0 ? 0 : monotonic_ns() + (uint64_t)timeout_ms * 1000000ull;
+
+    for (;;) {
+        atomic_fetch_add(&acq->ring.waiters, 1);
+        uint32_t wake = atomic_load(&acq->ring.wake);
+        int got = hx711_acq_poll(acq, reader, out);
+
+        if (got) {
+            atomic_fetch_sub(&acq->ring.waiters, 1);
+            return 1;
+        }
+
+        struct timespec rel, *timeout = NULL;
+        if (timeout_ms >= 0) {
+            uint64_t now = monotonic_ns();
+            if (now >= deadline) {
+                atomic_fetch_sub(&acq->ring.waiters, 1);
+                return 0;
+            }
+            rel.tv_sec = (time_t)((deadline - now) / 1000000000ull);
+            rel.tv_nsec = (long)((deadline - now) % 1000000000ull);
+            timeout = &rel;
+        }
+        syscall(SYS_futex, &acq->ring.wake, FUTEX_WAIT_PRIVATE, wake, timeout, NULL, 0);
+        atomic_fetch_sub(&acq->ring.waiters, 1);
+    }
+}
+
+int hx711_acq_latest(hx711_acq_t* acq, hx711_sample_t* out, int count) {
+    if (count > HX711_RING_SIZE) count = HX711_RING_SIZE;
+
+    uint64_t head = atomic_load_explicit(&acq->ring.head, memory_order_acquire);
+    uint64_t first = head > (uint64_t)count ? head - (uint64_t)count : 0;
+    int n = 0;
+
+    for (uint64_t seq = first; seq < head; seq++) {
+        if (ring_copy(&acq->ring, seq, &out[n])) n++;
+    }
+    return n;
+}
+
+// A stopped chip or thread publishes nothing; a collection must not wait for it forever
+int hx711_acq_collect(hx711_acq_t* acq, uint32_t times, hx711_stat_t* st) {
+    hx711_reader_t reader;
+    hx711_sample_t sample;
+
+    uint32_t good = 0;
+    uint64_t budget = 2ull * times + HX711_REJECT_EXTRA;
+
+    hx711_acq_reader_init(acq, &reader);
+    for (uint64_t i = 0; i < budget && good < times; i++) {
+        if (!hx711_acq_wait(acq, &reader, &sample, HX711_COLLECT_TIMEOUT_MS)) return -1;
+        if (sample.flags & HX711_FLAGS_REJECT) continue;
+        hx711_stat_push(st, sample.value);
+        good++;
+    }
+    return 0;
+}
+
+int hx711_acq_collect_sem(hx711_acq_t* acq, double target_sem, uint32_t min_samples,
+                          uint32_t max_samples, hx711_stat_t* st) {
+    hx711_reader_t reader;
+    hx711_sample_t sample;
+    uint64_t budget = 2ull * max_samples + HX711_REJECT_EXTRA;
+
+    if (min_samples < 2) min_samples = 2;
+    if (max_samples < min_samples) max_samples = min_samples;
+
+    hx711_acq_reader_init(acq, &reader);
+    for (uint64_t i = 0; i < budget && hx711_stat_count(st) < max_samples; i++) {
+        if (!hx711_acq_wait(acq, &reader, &sample, HX711_COLLECT_TIMEOUT_MS)) return -1;
+        if (sample.flags & HX711_FLAGS_REJECT) continue;
+        hx711_stat_push(st, sample.value);
+        if (hx711_stat_count(st) >= min_samples && hx711_stat_sem(st) <= target_sem) break;
+    }
+    return 0;
+}
+
+int hx711_acq_read_average(hx711_acq_t* acq, uint8_t times, long* average) {
+    hx711_stat_t st;
+    hx711_stat_reset(&st);
+    if (hx711_acq_collect(acq, times, &st) != 0 || hx711_stat_count(&st) == 0) return -1;
+    *average = hx711_stat_mean(&st);
+    return 0;
+}
+
+void hx711_acq_tare(hx711_acq_t* acq, uint8_t times) {
+    hx711_stat_t st;
+    hx711_stat_reset(&st);
+
+    // Nothing but rejected conversions, or none at all: keep the old zero rather than a bad one
+    if (hx711_acq_collect(acq, times, &st) == 0 && hx711_stat_count(&st) > 0) {
+        hx711_set_offset(acq->hx, hx711_stat_mean(&st));
+    }
+}
+
+float hx711_acq_get_units(hx711_acq_t* acq, uint8_t times) {
+    hx711_sample_t recent[HX711_RING_SIZE];
+    int n = hx711_acq_latest(acq, recent, times);
+    hx711_stat_t st;
+
+    if (n == 0) return 0.0f;
+    hx711_stat_reset(&st);
+    for (int i = 0; i < n; i++) {
+        if (!(recent[i].flags & HX711_FLAGS_REJECT)) hx711_stat_push(&st, recent[i].value);
+    }
+    if (hx711_stat_count(&st) == 0) return 0.0f;
+    return hx711_raw_to_units(acq->hx, hx711_stat_mean(&st));
+}
+
+void hx711_acq_snapshot(hx711_acq_t* acq, hx711_acq_snapshot_t* out) {
+    for (;;) {
+        uint32_t seq = atomic_load_explicit(&acq->snap_seq, memory_order_acquire);
+        if (seq & 1) {
+            sched_yield();
+            continue;
+        }
+        *out = acq->snap;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&acq->snap_seq, memory_order_relaxed) == seq) return;
+    }
+}
+
+void hx711_acq_print_integrity(hx711_acq_t* acq, FILE* out) {
+    hx711_acq_snapshot_t snap;
+    hx711_acq_snapshot(acq, &snap);
+    print_integrity(&snap.integrity, out);
+}
+
+void hx711_acq_print_stats(hx711_acq_t* acq, FILE* out) {
+    hx711_acq_snapshot_t snap;
+    hx711_acq_snapshot(acq, &snap);
+    const hx711_acq_stats_t st = snap.stats;
+
+    if (st.samples == 0) {
+        fprintf(out, "HX711 acq: no samples yet\n");
+        return;
+    }
+
+    double mean = (double)st.read_ns_sum / (double)st.samples;
+    double var = st.read_ns_sq / (double)st.samples - mean * mean;
+    double jitter = var > 0 ? sqrt(var) : 0.0;
+
+    fprintf(out, "HX711 acq [%s%s]: %llu samples, read %.1f us avg (min %.1f, max %.1f, sd %.1f)",
+            acq->rt.enabled ? "rt" : "legacy",
+            acq->rt.enabled && acq->rt_error ? ", setup failed" : "",
+            (unsigned long long)st.samples, mean / 1000.0,
+            st.read_ns_min / 1000.0, st.read_ns_max / 1000.0, jitter / 1000.0);
+    if (st.periods) {
+        fprintf(out, ", period %.2f-%.2f ms", st.period_ns_min / 1e6, st.period_ns_max / 1e6);
+    }
+    if (acq->rate_write) {
+        fprintf(out, ", %u SPS (%llu rate switches)", (unsigned)snap.rate_cur,
+                (unsigned long long)snap.rate_switches);
+    }
+    if (acq->aux_every) {
+        fprintf(out, ", channel B 1/%u: %llu samples (%.1f%% of weight conversions)", (unsigned)acq->aux_every,
+                (unsigned long long)snap.aux_samples,
+                100.0 * (double)snap.aux_lost / (double)(st.samples + snap.aux_lost));
+    }
+    if (st.clockout_pulses) {
+        const hx711_pulse_timing_t* pt = &snap.timing;
+        fprintf(out, ", %u pulses in %.1f us (worst %.1f us), SCK high %.2f-%.2f us (worst %.2f us)",
+                (unsigned)st.clockout_pulses, pt->total_ns / 1000.0, st.clockout_ns_max / 1000.0,
+                pt->sck_high_min_ns / 1000.0, pt->sck_high_max_ns / 1000.0,
+                st.sck_high_ns_max / 1000.0);
+    }
+    fprintf(out, "\n");
+}
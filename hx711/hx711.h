@@ -13,12 +13,117 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <sched.h>
+#include <signal.h>
 
 // Define a function pointer type for GPIO operations and delays
 typedef void (*gpio_write_func)(int pin, int value);
-typedef int (*gpio_read_func)(int pin);
+typedef int (*gpio_read_func)(int pin); // 1/0, negative on a transport error
 typedef void (*delay_us_func)(unsigned int us);
 typedef void (*delay_ms_func)(unsigned int ms);
+typedef void (*delay_ns_func)(unsigned int ns);
+// Blocks until DOUT goes low: 1 = ready (ready_ns set), 0 = timeout, -1 = error
+typedef int (*wait_ready_func)(int pin, int timeout_ms, uint64_t* ready_ns);
+
+// Clocks out one whole conversion (24 data bits + gain_pulses) in one go; 0 on success
+typedef int (*read_sample_func)(uint8_t gain_pulses, uint32_t* raw);
+
+#define HX711_READY_TIMEOUT_MS 500 // Longer than one 10 SPS conversion
+#define HX711_ERROR_BACKOFF_MS 10  // Acquisition thread pause after a failed read
+
+// Measured SCK timing of the most recent read (see hx711_capture_timing)
+typedef struct {
+    uint8_t pulses;            // Clock pulses issued (24 data + 1..3 gain)
+    uint32_t total_ns;         // First rising edge to last falling edge
+    uint32_t sck_high_min_ns;
+    uint32_t sck_high_max_ns;  // Must stay well below the 60 us power-down limit
+    uint32_t sck_low_max_ns;
+    uint64_t first_rise_ns;
+    uint64_t last_fall_ns;
+} hx711_pulse_timing_t;
+
+// Hardware backend selected at init. Bit-bang backends fill the gpio/delay
+// functions; transports fill read_sample and only need gpio_read for DOUT.
+typedef struct {
+    gpio_write_func gpio_write;    // PD_SCK, may be NULL with a transport
+    gpio_read_func gpio_read;      // DOUT / data-ready; NULL if only wait_ready can tell (IIO)
+    delay_us_func delay_us;
+    delay_ms_func delay_ms;
+    wait_ready_func wait_ready;    // Optional; a failing wait falls back to polling gpio_read if set
+    read_sample_func read_sample;  // Optional
+    bool read_sample_rt;           // read_sample bit-bangs in user space (hx711_fast.h)
+} hx711_backend_t;
+
+// Scheduling state saved across the critical timing section
+typedef struct {
+    struct sched_param param;
+    int policy;
+    sigset_t mask;
+} hx711_rt_saved_t;
+
+// Streaming accumulator: push conversions one at a time, query in O(1).
+// 64-bit sum, so long windows cannot overflow a 32-bit long.
+typedef struct {
+    uint32_t count;
+    int64_t sum;
+    long first;        // Shift for the squared deviations (keeps them small)
+    double sum_sq;     // Sum of (value - first)^2
+    long min;
+    long max;
+} hx711_stat_t;
+
+// Quality flags of one conversion (hx711_t.last_flags, hx711_sample_t.flags)
+#define HX711_FLAG_SATURATED  0x01  // Rail value 0x7FFFFF / 0x800000
+#define HX711_FLAG_FROZEN     0x02  // Identical to the previous frozen_repeats - 1 conversions
+#define HX711_FLAG_OVERRUN    0x04  // An SCK-high phase passed 60 us (chip powers down)
+#define HX711_FLAG_JUMP       0x08  // Step beyond jump_limit from the value the recent trend predicts
+#define HX711_FLAG_STUCK_BIT  0x10  // A low-order bit did not toggle over the last window
+#define HX711_FLAG_READ_ERROR 0x20  // Transport failed; there is no value
+#define HX711_FLAGS_REJECT (HX711_FLAG_SATURATED | HX711_FLAG_FROZEN | HX711_FLAG_OVERRUN | \
+                            HX711_FLAG_JUMP | HX711_FLAG_READ_ERROR)
+
+#define HX711_SCK_POWER_DOWN_NS 60000
+#define HX711_FROZEN_REPEATS 8      // Default; quiet cells still differ within a few conversions
+#define HX711_STUCK_WINDOW 64       // Conversions per stuck-bit window
+#define HX711_STUCK_BITS 0x0Fu      // Bits below the noise floor, which must toggle
+#define HX711_REJECT_EXTRA 8        // Spare reads an average may use on top of 2x its count
+#define HX711_JUMP_CONFIRM 2        // Consistent jumped conversions that make a new level or ramp
+
+// Per-conversion checks and their counters, run inside every read
+typedef struct {
+    long jump_limit;            // Raw counts, 0 = no jump check
+    uint32_t frozen_repeats;    // 0 = no frozen check
+
+    uint64_t checked;
+    uint64_t rejected;          // Conversions with any HX711_FLAGS_REJECT flag
+    uint64_t saturated;
+    uint64_t frozen;
+    uint64_t overrun;
+    uint64_t jumps;
+    uint64_t read_errors;
+    uint32_t stuck_mask;        // Bits that stayed constant over the last full window
+
+    // Check state, main input only
+    long prev;
+    uint32_t repeats;
+    long ref;                   // Last value that passed the jump check
+    long trend;                 // Smoothed step per conversion; ref + trend predicts the next value
+    long pending;               // Latest jumped value
+    long pending_step;          // Its step from the jumped value before it
+    uint32_t pending_run;       // Jumped values in a row that follow each other's level or ramp
+    bool have_ref;
+    bool have_pending;
+    uint32_t sck_high_max_ns;   // Longest SCK-high phase of the latest bit-banged read
+    uint32_t bits_and;
+    uint32_t bits_or;
+    uint32_t window;
+} hx711_integrity_t;
+
+struct hx711_curve_s; // hx711_curve.h
 
 // Main struct to hold HX711 state and configuration
 typedef struct {
@@ -27,6 +132,11 @@ typedef struct {
     uint8_t gain;
     long offset;
     float scale;
+    const struct hx711_curve_s* curve;  // Optional multi-point calibration, replaces scale when set
+
+    // Set while a persistent RT thread owns the chip; skips the per-read
+    // SCHED_FIFO/signal-mask switching in hx711_read
+    bool rt_context;
 
     // Pointers to hardware-specific functions
     gpio_write_func gpio_write;
@@ -34,6 +144,28 @@ typedef struct {
     delay_us_func delay_us;
     delay_ms_func delay_ms;
 
+    // Optional sub-microsecond SCK hold; NULL uses delay_us(1)
+    delay_ns_func delay_ns;
+    unsigned int pulse_ns;
+
+    // Optional blocking data-ready wait (e.g. GPIO edge events); NULL polls DOUT
+    wait_ready_func wait_ready;
+    uint64_t last_ready_ns;   // When DOUT went low for the most recent read
+
+    // Optional whole-sample transport (spidev, IIO); NULL bit-bangs PD_SCK
+    read_sample_func read_sample;
+    bool read_sample_rt;      // read_sample is a specialized bit-bang loop that needs the RT section
+
+    // Pulse-width capture (costs two clock reads per pulse when enabled)
+    bool capture_timing;
+    hx711_pulse_timing_t last_timing;
+
+    // Integrity checks of every conversion
+    uint8_t input_gain;       // Gain pulses that selected the conversion being read
+    uint8_t main_gain;        // Input the frozen/jump/stuck state follows (set by hx711_set_gain)
+    uint8_t last_flags;       // HX711_FLAG_* of the most recent read
+    hx711_integrity_t integrity;
+
 } hx711_t;
 
 /**
@@ -51,6 +183,16 @@ void hx711_init(hx711_t* hx, int dout_pin, int sck_pin,
                 gpio_write_func write_func, gpio_read_func read_func,
                 delay_us_func us_func, delay_ms_func ms_func);
 
+/**
+ * @brief Initializes the HX711 struct against a backend (bit-bang GPIO, spidev, ...).
+ *
+ * @param hx Pointer to the hx711_t struct to initialize.
+ * @param dout_pin GPIO pin number for DOUT.
+ * @param sck_pin GPIO pin number for PD_SCK (ignored by transports).
+ * @param backend Functions implementing the hardware access; copied.
+ */
+void hx711_init_backend(hx711_t* hx, int dout_pin, int sck_pin, const hx711_backend_t* backend);
+
 /**
  * @brief Check if HX711 is ready.
  * @param hx Pointer to the initialized hx711_t struct.
@@ -67,24 +209,99 @@ void hx711_set_gain(hx711_t* hx, uint8_t gain);
 
 /**
  * @brief Waits for the chip to be ready and returns a reading.
+ *
+ * A failed transport read returns 0 with HX711_FLAG_READ_ERROR in
+ * hx->last_flags; use hx711_read_value() to tell it apart from a reading.
+ *
  * @param hx Pointer to the initialized hx711_t struct.
  * @return The raw 24-bit value from the HX711.
  */
 long hx711_read(hx711_t* hx);
 
 /**
- * @brief Returns an average of multiple readings.
+ * @brief Waits for the chip to be ready and reads one conversion.
+ * @param hx Pointer to the initialized hx711_t struct.
+ * @param value Receives the raw 24-bit value; untouched on error.
+ * @return 0 on success, -1 if the transport failed (HX711_FLAG_READ_ERROR set).
+ */
+int hx711_read_value(hx711_t* hx, long* value);
+
+/**
+ * @brief Returns an average of multiple readings; rejected conversions are left out.
  * @param hx Pointer to the initialized hx711_t struct.
  * @param times Number of readings to average.
- * @return The average raw value.
+ * @return The average raw value, 0 if no good conversion was read
+ *         (use hx711_read_average_value() to tell).
  */
 long hx711_read_average(hx711_t* hx, uint8_t times);
 
+/**
+ * @brief hx711_read_average() that reports when there was nothing to average.
+ * @param hx Pointer to the initialized hx711_t struct.
+ * @param times Number of readings to average.
+ * @param average Receives the average raw value.
+ * @return 0 on success, -1 if no good conversion was read (average is left unchanged).
+ */
+int hx711_read_average_value(hx711_t* hx, uint8_t times, long* average);
+
+/**
+ * @brief Clocks `times` consecutive conversions into an accumulator, no rests in between.
+ *
+ * Conversions flagged HX711_FLAGS_REJECT are left out and replaced by further
+ * reads, up to `times` + HX711_REJECT_EXTRA extra; check the count afterwards.
+ *
+ * @param hx Pointer to the initialized hx711_t struct.
+ * @param times Number of good conversions wanted.
+ * @param st Accumulator to push into (not reset).
+ */
+void hx711_read_stat(hx711_t* hx, uint32_t times, hx711_stat_t* st);
+
+/**
+ * @brief Opens a new accumulation window.
+ * @param st Pointer to the accumulator.
+ */
+void hx711_stat_reset(hx711_stat_t* st);
+
+/**
+ * @brief Adds one conversion.
+ * @param st Pointer to the accumulator.
+ * @param value Raw reading.
+ */
+void hx711_stat_push(hx711_stat_t* st, long value);
+
+/**
+ * @brief Number of conversions in the window.
+ * @param st Pointer to the accumulator.
+ * @return The sample count.
+ */
+uint32_t hx711_stat_count(const hx711_stat_t* st);
+
+/**
+ * @brief Mean of the window.
+ * @param st Pointer to the accumulator.
+ * @return The mean raw value, or 0 if the window is empty.
+ */
+long hx711_stat_mean(const hx711_stat_t* st);
+
+/**
+ * @brief Sample variance of the window.
+ * @param st Pointer to the accumulator.
+ * @return The variance in raw counts squared, or 0 with fewer than two samples.
+ */
+double hx711_stat_variance(const hx711_stat_t* st);
+
+/**
+ * @brief Standard error of the window's mean.
+ * @param st Pointer to the accumulator.
+ * @return sqrt(variance / count) in raw counts, or HUGE_VAL with fewer than two samples.
+ */
+double hx711_stat_sem(const hx711_stat_t* st);
+
 /**
  * @brief Get the current value minus the tare weight.
  * @param hx Pointer to the initialized hx711_t struct.
  * @param times Number of readings to average.
- * @return The value with offset subtracted.
+ * @return The value with offset subtracted, or NAN if no good conversion was read.
  */
 double hx711_get_value(hx711_t* hx, uint8_t times);
 
@@ -92,7 +309,7 @@ double hx711_get_value(hx711_t* hx, uint8_t times);
  * @brief Get the weight in calibrated units.
  * @param hx Pointer to the initialized hx711_t struct.
  * @param times Number of readings to average.
- * @return The calibrated weight.
+ * @return The calibrated weight, or NAN if no good conversion was read.
  */
 float hx711_get_units(hx711_t* hx, uint8_t times);
 
@@ -103,6 +320,64 @@ float hx711_get_units(hx711_t* hx, uint8_t times);
  */
 void hx711_tare(hx711_t* hx, uint8_t times);
 
+/**
+ * @brief Use a nanosecond delay for the SCK high/low holds.
+ * @param hx Pointer to the initialized hx711_t struct.
+ * @param ns_func Delay function (e.g. hx711_spin_delay_ns), or NULL for delay_us(1).
+ * @param pulse_ns Hold time for each SCK phase in nanoseconds.
+ */
+void hx711_set_pulse_ns(hx711_t* hx, delay_ns_func ns_func, unsigned int pulse_ns);
+
+/**
+ * @brief Sleep in a data-ready wait instead of polling DOUT.
+ * @param hx Pointer to the initialized hx711_t struct.
+ * @param wait_func Blocking wait (e.g. hx711_gpiod_wait_ready), or NULL to poll.
+ */
+void hx711_set_wait_ready(hx711_t* hx, wait_ready_func wait_func);
+
+/**
+ * @brief Enable or disable SCK pulse-width capture into hx->last_timing.
+ * @param hx Pointer to the initialized hx711_t struct.
+ * @param enable True to measure every pulse of every read.
+ */
+void hx711_capture_timing(hx711_t* hx, bool enable);
+
+/**
+ * @brief Sets the data-dependent integrity limits.
+ * @param hx Pointer to the initialized hx711_t struct.
+ * @param jump_limit Largest plausible single-conversion step in raw counts, 0 = no check.
+ * @param frozen_repeats Identical conversions in a row that count as frozen, 0 = no check.
+ */
+void hx711_set_integrity_limits(hx711_t* hx, long jump_limit, uint32_t frozen_repeats);
+
+/**
+ * @brief Prints the integrity counters.
+ * @param hx Pointer to the initialized hx711_t struct.
+ * @param out Stream to print to.
+ */
+void hx711_print_integrity(const hx711_t* hx, FILE* out);
+
+/**
+ * @brief Enters the bit-bang critical section (SCHED_FIFO, all signals blocked).
+ * @param rt_context True if a persistent RT thread already provides this; then a no-op.
+ * @param saved Receives the scheduling state to restore.
+ */
+void hx711_critical_enter(bool rt_context, hx711_rt_saved_t* saved);
+
+/**
+ * @brief Leaves the critical section entered with hx711_critical_enter().
+ * @param rt_context Same value as passed to hx711_critical_enter().
+ * @param saved State filled in by hx711_critical_enter().
+ */
+void hx711_critical_leave(bool rt_context, const hx711_rt_saved_t* saved);
+
+/**
+ * @brief Sign-extends a raw 24-bit two's complement conversion.
+ * @param raw 24 data bits, MSB first.
+ * @return The signed reading.
+ */
+long hx711_sign_extend24(uint32_t raw);
+
 /**
  * @brief Set the calibration scale factor.
  * @param hx Pointer to the initialized hx711_t struct.
@@ -110,6 +385,21 @@ void hx711_tare(hx711_t* hx, uint8_t times);
  */
 void hx711_set_scale(hx711_t* hx, float scale);
 
+/**
+ * @brief Use a multi-point calibration curve instead of the single scale factor.
+ * @param hx Pointer to the initialized hx711_t struct.
+ * @param curve Built curve (hx711_curve_build), or NULL for the scale factor. Not copied.
+ */
+void hx711_set_curve(hx711_t* hx, const struct hx711_curve_s* curve);
+
+/**
+ * @brief Converts a raw reading to calibrated units (offset, then curve or scale).
+ * @param hx Pointer to the initialized hx711_t struct.
+ * @param raw Raw or filtered reading.
+ * @return The weight in calibrated units.
+ */
+float hx711_raw_to_units(hx711_t* hx, long raw);
+
 /**
  * @brief Get the current scale factor.
  * @param hx Pointer to the initialized hx711_t struct.
@@ -143,4 +433,346 @@ void hx711_power_down(hx711_t* hx);
  */
 void hx711_power_up(hx711_t* hx);
 
+// --- Acquisition engine ---
+//
+// One thread owns the chip and publishes every conversion into a
+// single-producer/multi-consumer ring. Each consumer keeps its own
+// hx711_reader_t cursor, so the weighing loop, tare, calibration and the
+// tamper monitors all see the full sample stream without blocking each other
+// or the producer.
+
+#define HX711_RING_SIZE 256 // Must be a power of two
+
+// One timestamped conversion
+typedef struct {
+    long value;             // Raw sign-extended 24-bit reading
+    uint64_t timestamp_ns;  // CLOCK_MONOTONIC time the conversion was read
+    uint64_t ready_ns;      // When DOUT signalled data ready (kernel edge time if available)
+    uint64_t seq;           // Position in the stream (0, 1, 2, ...)
+    uint16_t sps;           // Output rate the conversion was taken at (10/80), 0 = RATE not controlled
+    uint8_t flags;          // HX711_FLAG_*; consumers skip HX711_FLAGS_REJECT
+} hx711_sample_t;
+
+// Ring slot guarded by a per-slot sequence lock
+typedef struct {
+    _Atomic uint64_t lock;  // 2*seq+1 while being written, 2*seq+2 when valid
+    hx711_sample_t sample;
+} hx711_slot_t;
+
+typedef struct {
+    _Atomic uint64_t head;     // Number of samples published so far
+    _Atomic uint32_t wake;     // Futex word, bumped on every publish
+    _Atomic uint32_t waiters;  // Consumers sleeping in hx711_acq_wait()
+    hx711_slot_t slots[HX711_RING_SIZE];
+} hx711_ring_t;
+
+// Called by the acquisition thread right after a weight sample is published
+typedef void (*hx711_sample_hook_func)(const hx711_sample_t* sample, void* ctx);
+
+// Per-consumer read cursor
+typedef struct {
+    uint64_t next;     // Next sequence number to read
+    uint64_t dropped;  // Samples overwritten before this reader got to them
+} hx711_reader_t;
+
+#define HX711_RT_STACK_PREFAULT (64 * 1024)
+
+#define HX711_SPS_SLOW 10
+#define HX711_SPS_FAST 80
+#define HX711_RATE_SETTLE_SAMPLES 4 // Conversions discarded after a RATE change (datasheet settling: 4 periods)
+#define HX711_RATE_NOISE_RATIO 1.8  // Input noise at 80 SPS over 10 SPS (datasheet: 90 vs 50 nV rms)
+#define HX711_COLLECT_TIMEOUT_MS 800 // 8 periods at 10 SPS: settling after a RATE change plus channel-B turns
+#ifndef HX711_AUX_SETTLE_SAMPLES
+#define HX711_AUX_SETTLE_SAMPLES 4  // Conversions discarded after a channel switch (datasheet settling: 4 periods)
+#endif
+
+// Opt-in real-time setup, applied once when the acquisition thread starts
+typedef struct {
+    bool enabled;
+    int priority;           // SCHED_FIFO priority, 0 = maximum
+    int cpu;                // CPU to pin the thread to, -1 = no pinning
+    size_t stack_prefault;  // Stack bytes to touch up front, 0 = HX711_RT_STACK_PREFAULT
+} hx711_rt_config_t;
+
+// Clock-out cost and sample period, written by the acquisition thread only
+typedef struct {
+    uint64_t samples;
+    uint64_t read_ns_min;
+    uint64_t read_ns_max;
+    uint64_t read_ns_sum;
+    double read_ns_sq;      // Sum of squares, for the jitter estimate
+    uint64_t periods;
+    uint64_t period_ns_min;
+    uint64_t period_ns_max;
+    uint32_t clockout_pulses;   // Pulses per read, when timing capture is on
+    uint32_t clockout_ns_max;   // Worst full clock-out
+    uint32_t sck_high_ns_max;   // Worst single SCK-high phase
+} hx711_acq_stats_t;
+
+// Engine counters as of the most recent conversion, published by the acquisition
+// thread under a sequence lock so other threads can read them consistently
+typedef struct {
+    hx711_acq_stats_t stats;
+    hx711_pulse_timing_t timing; // Most recent read, when timing capture is on
+    hx711_integrity_t integrity;
+    uint16_t rate_cur;
+    uint64_t rate_switches;
+    uint64_t aux_lost;
+    uint64_t aux_samples;
+} hx711_acq_snapshot_t;
+
+typedef struct {
+    hx711_t* hx;
+    hx711_ring_t ring;
+    pthread_t thread;
+    atomic_bool running;
+    hx711_rt_config_t rt;
+    int rt_error;           // errno of the first failed RT setup step, 0 if none
+    hx711_acq_stats_t stats;    // Acquisition thread only; others use hx711_acq_snapshot()
+    _Atomic uint32_t snap_seq;  // Odd while snap is being written
+    hx711_acq_snapshot_t snap;
+
+    // Optional RATE pin control, applied by the acquisition thread between conversions
+    // (zero-initialize the engine, or call hx711_acq_set_rate_pin(), before starting)
+    gpio_write_func rate_write;
+    int rate_pin;
+    _Atomic uint16_t rate_req;  // Requested SPS
+    uint16_t rate_cur;          // SPS the chip is running at, 0 = not controlled
+    uint32_t rate_discard;      // Conversions still to drop after a switch
+    uint64_t rate_switches;
+
+    // Optional channel-B interleave (hx711_acq_set_channel_b()), run by the acquisition thread
+    hx711_ring_t aux_ring;      // Channel-B series
+    uint32_t aux_every;         // Channel-A conversions between channel-B ones, 0 = off
+    uint8_t aux_main_gain;      // Gain pulses of the weight channel, taken from hx at start
+    uint8_t aux_state;          // Input of the conversion about to be read
+    uint32_t aux_count;
+    uint32_t aux_left;          // Settling conversions still to drop
+    uint64_t aux_lost;          // Channel-A slots spent on channel B and its settling
+
+    // Optional eventfd posted after every weight sample (hx711_acq_notify_fd()), for epoll loops
+    bool notify;
+    int notify_fd;
+
+    // Optional per-sample hook run by the acquisition thread (hx711_acq_set_sample_hook())
+    hx711_sample_hook_func hook;
+    void* hook_ctx;
+} hx711_acq_t;
+
+/**
+ * @brief Starts the acquisition thread. From now on only the thread may touch the chip.
+ * @param acq Pointer to the acquisition engine to start.
+ * @param hx Pointer to the initialized hx711_t struct.
+ * @return 0 on success, -1 if the thread could not be created.
+ */
+int hx711_acq_start(hx711_acq_t* acq, hx711_t* hx);
+
+/**
+ * @brief Starts the acquisition thread with an optional persistent real-time context.
+ *
+ * With rt->enabled the thread locks memory, pins itself to rt->cpu, switches to
+ * SCHED_FIFO, prefaults its stack and blocks all signals once. Every read after
+ * that runs without scheduler or signal-mask syscalls.
+ *
+ * @param acq Pointer to the acquisition engine to start.
+ * @param hx Pointer to the initialized hx711_t struct.
+ * @param rt Real-time settings, or NULL for the legacy per-read behaviour.
+ * @return 0 on success, -1 if the thread could not be created.
+ */
+int hx711_acq_start_rt(hx711_acq_t* acq, hx711_t* hx, const hx711_rt_config_t* rt);
+
+/**
+ * @brief Hands the RATE pin to the acquisition engine. Call before starting it.
+ * @param acq Pointer to the acquisition engine.
+ * @param write_func Drives RATE (high = 80 SPS), e.g. hx711_gpiod_write_rate.
+ * @param rate_pin GPIO pin number of RATE.
+ * @param sps Initial rate, HX711_SPS_SLOW or HX711_SPS_FAST.
+ */
+void hx711_acq_set_rate_pin(hx711_acq_t* acq, gpio_write_func write_func, int rate_pin, int sps);
+
+/**
+ * @brief Requests a new output rate from any thread.
+ *
+ * The acquisition thread switches RATE before its next conversion and drops
+ * the HX711_RATE_SETTLE_SAMPLES conversions that follow, so consumers (and
+ * their filter state) only ever see settled data. No-op without a RATE pin.
+ *
+ * @param acq Pointer to the acquisition engine.
+ * @param sps HX711_SPS_SLOW or HX711_SPS_FAST.
+ */
+void hx711_acq_request_rate(hx711_acq_t* acq, int sps);
+
+/**
+ * @brief Interleaves a channel-B (gain 32) conversion every `every` channel-A ones.
+ *
+ * Each switch costs HX711_AUX_SETTLE_SAMPLES dropped conversions in both
+ * directions, so one channel-B sample takes 1 + 2 * HX711_AUX_SETTLE_SAMPLES
+ * slots from the weight stream; hx711_acq_print_stats() reports the share.
+ * Channel-B samples go to a separate series (hx711_acq_aux_poll()). Needs a
+ * backend that clocks gain pulses (not IIO). Call before starting the engine.
+ *
+ * @param acq Pointer to the acquisition engine.
+ * @param every Channel-A conversions per channel-B conversion, 0 = off.
+ */
+void hx711_acq_set_channel_b(hx711_acq_t* acq, uint32_t every);
+
+/**
+ * @brief Returns an eventfd the acquisition thread posts after every weight sample.
+ *
+ * For consumers that sleep in epoll/poll instead of hx711_acq_wait(). The
+ * counter coalesces posts; drain the stream with hx711_acq_poll() on every
+ * wakeup (channel-B samples can be polled at the same time). Created on the
+ * first call, which must come before the engine is started; it stays open
+ * for the life of the process.
+ * @param acq Pointer to the acquisition engine.
+ * @return The non-blocking eventfd, or -1 if it could not be created.
+ */
+int hx711_acq_notify_fd(hx711_acq_t* acq);
+
+/**
+ * @brief Runs a callback on the acquisition thread for every weight sample.
+ *
+ * For control loops that must act on a conversion with fixed latency (a
+ * feeder valve cut-off), without waiting for a consumer thread to be
+ * scheduled. The hook runs with the thread's real-time priority, rejected
+ * samples included (check flags); it must not block, allocate or print.
+ * Call before starting the engine.
+ * @param acq Pointer to the acquisition engine.
+ * @param hook Callback, or NULL for none.
+ * @param ctx Passed through to the callback.
+ */
+void hx711_acq_set_sample_hook(hx711_acq_t* acq, hx711_sample_hook_func hook, void* ctx);
+
+/**
+ * @brief Attaches a reader to the channel-B series, positioned at the next new sample.
+ * @param acq Pointer to the acquisition engine.
+ * @param reader Pointer to the reader cursor to initialize.
+ */
+void hx711_acq_aux_reader_init(hx711_acq_t* acq, hx711_reader_t* reader);
+
+/**
+ * @brief Takes the next channel-B sample for this reader without blocking.
+ * @param acq Pointer to the acquisition engine.
+ * @param reader Pointer to the reader cursor.
+ * @param out Receives the sample.
+ * @return 1 if a sample was returned, 0 if the reader is up to date.
+ */
+int hx711_acq_aux_poll(hx711_acq_t* acq, hx711_reader_t* reader, hx711_sample_t* out);
+
+/**
+ * @brief Copies the engine counters from any thread.
+ * @param acq Pointer to the acquisition engine.
+ * @param out Receives the counters as of the most recent conversion.
+ */
+void hx711_acq_snapshot(hx711_acq_t* acq, hx711_acq_snapshot_t* out);
+
+/**
+ * @brief Prints per-sample clock-out overhead, jitter and period spread.
+ * @param acq Pointer to the acquisition engine.
+ * @param out Stream to print to.
+ */
+void hx711_acq_print_stats(hx711_acq_t* acq, FILE* out);
+
+/**
+ * @brief Prints the integrity counters of a running engine (see hx711_print_integrity()).
+ * @param acq Pointer to the acquisition engine.
+ * @param out Stream to print to.
+ */
+void hx711_acq_print_integrity(hx711_acq_t* acq, FILE* out);
+
+/**
+ * @brief Stops the acquisition thread and waits for it to exit.
+ * @param acq Pointer to a running acquisition engine.
+ */
+void hx711_acq_stop(hx711_acq_t* acq);
+
+/**
+ * @brief Attaches a reader to the stream, positioned at the next new sample.
+ * @param acq Pointer to the acquisition engine.
+ * @param reader Pointer to the reader cursor to initialize.
+ */
+void hx711_acq_reader_init(hx711_acq_t* acq, hx711_reader_t* reader);
+
+/**
+ * @brief Takes the next sample for this reader without blocking.
+ * @param acq Pointer to the acquisition engine.
+ * @param reader Pointer to the reader cursor.
+ * @param out Receives the sample.
+ * @return 1 if a sample was returned, 0 if the reader is up to date.
+ */
+int hx711_acq_poll(hx711_acq_t* acq, hx711_reader_t* reader, hx711_sample_t* out);
+
+/**
+ * @brief Takes the next sample for this reader, sleeping until one is published.
+ * @param acq Pointer to the acquisition engine.
+ * @param reader Pointer to the reader cursor.
+ * @param out Receives the sample.
+ * @param timeout_ms Maximum time to wait, or -1 to wait forever.
+ * @return 1 if a sample was returned, 0 on timeout.
+ */
+int hx711_acq_wait(hx711_acq_t* acq, hx711_reader_t* reader, hx711_sample_t* out, int timeout_ms);
+
+/**
+ * @brief Copies the most recent samples without blocking.
+ * @param acq Pointer to the acquisition engine.
+ * @param out Array receiving up to `count` samples, oldest first.
+ * @param count Number of samples wanted (at most HX711_RING_SIZE).
+ * @return Number of samples copied.
+ */
+int hx711_acq_latest(hx711_acq_t* acq, hx711_sample_t* out, int count);
+
+/**
+ * @brief Pushes the next `times` fresh conversions into an accumulator (blocks for them).
+ * @param acq Pointer to the acquisition engine.
+ * @param times Number of new good conversions; rejected ones are skipped as in hx711_read_stat().
+ * @param st Accumulator to push into (not reset).
+ * @return 0 when done, -1 if no conversion arrived for HX711_COLLECT_TIMEOUT_MS
+ *         (st keeps what came before).
+ */
+int hx711_acq_collect(hx711_acq_t* acq, uint32_t times, hx711_stat_t* st);
+
+/**
+ * @brief Pushes fresh conversions until the mean is known well enough (blocks for them).
+ *
+ * Stops once at least min_samples good conversions are in and the standard
+ * error of the mean is at or below target_sem, or after max_samples. Assumes
+ * independent conversions, which holds for the HX711's per-conversion filter.
+ *
+ * @param acq Pointer to the acquisition engine.
+ * @param target_sem Standard error of the mean to reach, raw counts.
+ * @param min_samples Fewest good conversions to take.
+ * @param max_samples Most good conversions to take.
+ * @param st Accumulator to push into (not reset); hx711_stat_sem() gives the
+ *           standard error achieved.
+ * @return 0 when done, -1 if no conversion arrived for HX711_COLLECT_TIMEOUT_MS
+ *         (st keeps what came before).
+ */
+int hx711_acq_collect_sem(hx711_acq_t* acq, double target_sem, uint32_t min_samples,
+                          uint32_t max_samples, hx711_stat_t* st);
+
+/**
+ * @brief Averages the next `times` fresh conversions (blocks for them).
+ * @param acq Pointer to the acquisition engine.
+ * @param times Number of new conversions to average.
+ * @param average Receives the average raw value.
+ * @return 0 on success, -1 if every conversion was rejected or none arrived in time
+ *         (average is left unchanged).
+ */
+int hx711_acq_read_average(hx711_acq_t* acq, uint8_t times, long* average);
+
+/**
+ * @brief Set the tare offset from the next `times` fresh conversions.
+ * @param acq Pointer to the acquisition engine.
+ * @param times Number of new conversions to average.
+ */
+void hx711_acq_tare(hx711_acq_t* acq, uint8_t times);
+
+/**
+ * @brief Weight in calibrated units from the most recent conversions (non-blocking).
+ * @param acq Pointer to the acquisition engine.
+ * @param times Number of most recent conversions to average.
+ * @return The calibrated weight, or 0 if nothing has been acquired yet.
+ */
+float hx711_acq_get_units(hx711_acq_t* acq, uint8_t times);
+
 #endif /* HX711_H */
@@ -0,0 +1,184 @@
+/**
+ *
+ * Dynamic check-weighing for the HX711 sample stream
+ *
+ */
+#include "hx711_checkweigh.h"
+#include <math.h>
+#include <string.h>
+
+#define OFF_FRACTION 0.5f   // Off level as a fraction of the on level
+#define BASELINE_SHIFT 16   // Empty-belt level moves at most resolution/16 per sample
+#define OUTLIER_K 3.0f      // Plateau band, robust standard deviations
+#define MAD_TO_SD 1.4826f   // MAD of a normal distribution -> standard deviation
+
+void hx711_checkweigh_init(hx711_checkweigh_t* cw, float on_level, float lower, float upper,
+                           float resolution, hx711_cw_func cb, void* ctx) {
+    memset(cw, 0, sizeof(*cw));
+    cw->on_level = fabsf(on_level);
+    cw->off_level = cw->on_level * OFF_FRACTION;
+    cw->lower = lower;
+    cw->upper = upper;
+    cw->resolution = fabsf(resolution);
+    cw->on_item = cb;
+    cw->ctx = ctx;
+    hx711_checkweigh_set_window(cw, 2, 4);
+}
+
+void hx711_checkweigh_set_window(hx711_checkweigh_t* cw, uint16_t edge, uint16_t min_plateau) {
+    cw->edge = edge;
+    cw->min_plateau = min_plateau ? min_plateau : 1;
+}
+
+void hx711_checkweigh_set_baseline_limit(hx711_checkweigh_t* cw, float limit) {
+    cw->baseline_limit = fabsf(limit);
+}
+
+void hx711_checkweigh_shift_baseline(hx711_checkweigh_t* cw, float delta) {
+    cw->baseline += delta;
+}
+
+void hx711_checkweigh_reset(hx711_checkweigh_t* cw) {
+    cw->have_baseline = false;
+    cw->on = false;
+    cw->n = 0;
+    cw->truncated = false;
+}
+
+// k-th smallest of x[0..n), reordering x (quickselect)
+static float select_kth(float* x, int n, int k) {
+    int lo = 0, hi = n - 1;
+    while (lo < hi) {
+        float pivot = x[(lo + hi) / 2];
+        int i = lo, j = hi;
+        while (i <= j) {
+            while (x[i] < pivot) i++;
+            while (x[j] > pivot) j--;
+            if (i <= j) {
+                float tmp = x[i];
+                x[i] = x[j];
+                x[j] = tmp;
+                i++;
+                j--;
+            }
+        }
+        if (k <= j) {
+            hi = j;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            break;
+        }
+    }
+    return x[k];
+}
+
+// Median and outlier-free mean of the trimmed window
+static void weigh_window(hx711_checkweigh_t* cw, hx711_cw_item_t* item) {
+    float scratch[HX711_CW_MAX_WINDOW];
+    int first = cw->edge;
+    int count = (int)cw->n - 2 * (int)cw->edge;
+
+    item->plateau = 0;
+    item->weight = 0.0f;
+    item->sd = 0.0f;
+    if (count <= 0) return;
+
+    memcpy(scratch, &cw->w[first], (size_t)count * sizeof(float));
+    float median = select_kth(scratch, count, count / 2);
+    for (int i = 0; i < count; i++) {
+        scratch[i] = fabsf(cw->w[first + i] - median);
+    }
+    float band = OUTLIER_K * MAD_TO_SD * select_kth(scratch, count, count / 2);
+    if (band < cw->resolution) band = cw->resolution;
+
+    double sum = 0.0, sum_sq = 0.0;
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        float d = cw->w[first + i] - median;
+        if (fabsf(d) > band) continue;
+        sum += d;
+        sum_sq += (double)d * d;
+        kept++;
+    }
+    if (kept == 0) return;
+
+    double mean = sum / kept;
+    double var = sum_sq / kept - mean * mean;
+    item->plateau = (uint16_t)kept;
+    item->weight = median + (float)mean;
+    item->sd = var > 0.0 ? (float)sqrt(var) : 0.0f;
+}
+
+static void finish_item(hx711_checkweigh_t* cw, uint64_t timestamp_ns) {
+    hx711_cw_item_t* item = &cw->last;
+
+    memset(item, 0, sizeof(*item));
+    item->index = ++cw->items;
+    item->start_ns = cw->start_ns;
+    item->end_ns = timestamp_ns;
+    item->samples = cw->n;
+    item->truncated = cw->truncated;
+    weigh_window(cw, item);
+
+    if (item->plateau < cw->min_plateau) {
+        item->verdict = HX711_CW_NO_PLATEAU;
+    } else if (item->weight < cw->lower) {
+        item->verdict = HX711_CW_UNDER;
+    } else if (cw->upper > 0.0f && item->weight > cw->upper) {
+        item->verdict = HX711_CW_OVER;
+    } else {
+        item->verdict = HX711_CW_ACCEPT;
+    }
+    cw->verdicts[item->verdict]++;
+
+    if (cw->on_item) cw->on_item(item, cw->ctx);
+}
+
+static void clamp_baseline(hx711_checkweigh_t* cw) {
+    if (cw->baseline_limit > 0.0f) {
+        cw->baseline = fminf(fmaxf(cw->baseline, -cw->baseline_limit), cw->baseline_limit);
+    }
+}
+
+bool hx711_checkweigh_push(hx711_checkweigh_t* cw, uint64_t timestamp_ns, float value) {
+    if (!cw->have_baseline) {
+        cw->baseline = value;
+        clamp_baseline(cw);
+        cw->have_baseline = true;
+    }
+    float net = value - cw->baseline;
+
+    if (!cw->on) {
+        if (net < cw->on_level) {
+            // Belt empty: follow its slow drift. Each step is clamped to the
+            // resolution, so ramp samples just below on_level barely move it
+            // and the level settles on the median of the idle samples.
+            float step = fminf(fmaxf(net, -cw->resolution), cw->resolution);
+            cw->baseline += step / BASELINE_SHIFT;
+            clamp_baseline(cw);
+            return false;
+        }
+        cw->on = true;
+        cw->start_ns = timestamp_ns;
+        cw->n = 0;
+        cw->truncated = false;
+    }
+
+    if (net >= cw->off_level) {
+        if (cw->n < HX711_CW_MAX_WINDOW) {
+            cw->w[cw->n++] = net;
+        } else {
+            cw->truncated = true;
+        }
+        return false;
+    }
+
+    cw->on = false;
+    finish_item(cw, timestamp_ns);
+    return true;
+}
+
+const hx711_cw_item_t* hx711_checkweigh_last(const hx711_checkweigh_t* cw) {
+    return &cw->last;
+}
@@ -0,0 +1,132 @@
+/**
+ *
+ * Dynamic check-weighing for the HX711 sample stream
+ *
+ * Segments a fast (80 SPS) stream from a scale under a conveyor into
+ * item-on/item-off windows with a hysteresis pair of levels above the
+ * empty-belt level, which is tracked between items (within an optional
+ * limit, so it cannot wander off the tare zero). When an item leaves,
+ * its window minus the entry/exit edges is reduced to a plateau: samples
+ * within 3 robust standard deviations (MAD) of the median, averaged. Each
+ * item is published with its weight, plateau quality and an accept/reject
+ * verdict against the configured limits.
+ *
+ * All state is fixed-size; one item may span HX711_CW_MAX_WINDOW samples.
+ *
+ */
+#ifndef HX711_CHECKWEIGH_H
+#define HX711_CHECKWEIGH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HX711_CW_MAX_WINDOW 256 // Samples per item; 3.2 s at 80 SPS
+
+typedef enum {
+    HX711_CW_ACCEPT,
+    HX711_CW_UNDER,
+    HX711_CW_OVER,
+    HX711_CW_NO_PLATEAU   // Too few settled samples to weigh (item too short or belt too fast)
+} hx711_cw_verdict_t;
+
+// One weighed item
+typedef struct {
+    uint32_t index;          // 1, 2, 3, ...
+    uint64_t start_ns;       // First sample above the on level
+    uint64_t end_ns;         // First sample back below the off level
+    float weight;            // Plateau mean above the empty-belt level, in the units fed in
+    float sd;                // Spread of the plateau samples
+    uint16_t samples;        // Samples in the window
+    uint16_t plateau;        // Samples left after edge trimming and outlier rejection
+    bool truncated;          // Window longer than HX711_CW_MAX_WINDOW; weighed on its start
+    hx711_cw_verdict_t verdict;
+} hx711_cw_item_t;
+
+typedef void (*hx711_cw_func)(const hx711_cw_item_t* item, void* ctx);
+
+typedef struct {
+    float on_level;          // Item present above baseline + on_level
+    float off_level;         // and gone again below baseline + off_level
+    float lower;             // Accept limits; upper 0 = no upper limit
+    float upper;
+    float resolution;        // Smallest outlier band (e.g. the division)
+    uint16_t edge;           // Samples dropped from each end of a window
+    uint16_t min_plateau;    // Fewest plateau samples for a verdict
+    hx711_cw_func on_item;
+    void* ctx;
+
+    float baseline_limit;    // Empty-belt level stays within +/- this, 0 = no limit
+    float baseline;          // Empty-belt level
+    bool have_baseline;
+    bool on;
+    uint64_t start_ns;
+    float w[HX711_CW_MAX_WINDOW];
+    uint16_t n;
+    bool truncated;
+
+    uint32_t items;
+    uint32_t verdicts[HX711_CW_NO_PLATEAU + 1];
+    hx711_cw_item_t last;
+} hx711_checkweigh_t;
+
+/**
+ * @brief Initializes the segmenter.
+ * @param cw Pointer to the check-weigher.
+ * @param on_level Rise above the empty-belt level that starts an item.
+ * @param lower Lower accept limit.
+ * @param upper Upper accept limit, 0 = none.
+ * @param resolution Smallest outlier band, normally the scale division.
+ * @param cb Called for every item, or NULL.
+ * @param ctx Passed through to the callback.
+ */
+void hx711_checkweigh_init(hx711_checkweigh_t* cw, float on_level, float lower, float upper,
+                           float resolution, hx711_cw_func cb, void* ctx);
+
+/**
+ * @brief Sets the entry/exit trimming and the plateau needed for a verdict.
+ * @param cw Pointer to the check-weigher.
+ * @param edge Samples dropped from each end of a window (default 2).
+ * @param min_plateau Fewest plateau samples (default 4).
+ */
+void hx711_checkweigh_set_window(hx711_checkweigh_t* cw, uint16_t edge, uint16_t min_plateau);
+
+/**
+ * @brief Limits how far the empty-belt level may move from zero.
+ *
+ * A caller that moves the scale zero itself (see hx711_zero_shift()) takes
+ * the level out with hx711_checkweigh_shift_baseline() after every sample.
+ * @param cw Pointer to the check-weigher.
+ * @param limit Largest |baseline| in the units fed in, 0 = no limit.
+ */
+void hx711_checkweigh_set_baseline_limit(hx711_checkweigh_t* cw, float limit);
+
+/**
+ * @brief Moves the empty-belt level, e.g. after the zero was moved by the same amount.
+ * @param cw Pointer to the check-weigher.
+ * @param delta Change in the units fed in.
+ */
+void hx711_checkweigh_shift_baseline(hx711_checkweigh_t* cw, float delta);
+
+/**
+ * @brief Forgets the empty-belt level and any item in progress (e.g. after a tare).
+ * @param cw Pointer to the check-weigher.
+ */
+void hx711_checkweigh_reset(hx711_checkweigh_t* cw);
+
+/**
+ * @brief Feeds one sample.
+ * @param cw Pointer to the check-weigher.
+ * @param timestamp_ns Sample time.
+ * @param value Load in calibrated units (unfiltered; the plateau does the averaging).
+ * @return True if the sample completed an item (then available from hx711_checkweigh_last()).
+ */
+bool hx711_checkweigh_push(hx711_checkweigh_t* cw, uint64_t timestamp_ns, float value);
+
+/**
+ * @brief Most recent item.
+ * @param cw Pointer to the check-weigher.
+ * @return The item, valid once the first one has completed.
+ */
+const hx711_cw_item_t* hx711_checkweigh_last(const hx711_checkweigh_t* cw);
+
+#endif /* HX711_CHECKWEIGH_H */
@@ -0,0 +1,163 @@
+/**
+ *
+ * Piece counting for the HX711 sample stream
+ *
+ */
+#include "hx711_count.h"
+#include <math.h>
+#include <string.h>
+
+#define SQRT_2 1.41421356
+#define Z95 1.96f
+#define PRIOR_WEIGHT 2.0 // The assumed cv counts as this many refinements
+
+void hx711_count_init(hx711_count_t* c, uint16_t window, float stable_sd, float cv, float refine_confidence) {
+    memset(c, 0, sizeof(*c));
+    if (window < 2) window = 2;
+    if (window > HX711_COUNT_MAX_WINDOW) window = HX711_COUNT_MAX_WINDOW;
+    c->window = window;
+    c->stable_sd = fabsf(stable_sd);
+    c->cv = fabsf(cv);
+    c->refine_confidence = refine_confidence;
+}
+
+void hx711_count_flush(hx711_count_t* c) {
+    c->head = 0;
+    c->n = 0;
+    c->stable_run = 0;
+    c->sum = 0.0;
+    c->sq = 0.0;
+}
+
+void hx711_count_clear_reference(hx711_count_t* c) {
+    c->have_ref = false;
+    c->ref_pieces = 0;
+    c->apw = 0.0f;
+    c->apw_var = 0.0f;
+    c->piece_var = 0.0f;
+    c->resid_sum = 0.0;
+    c->refinements = 0;
+}
+
+static float window_mean(const hx711_count_t* c) {
+    return (float)(c->sum / c->n);
+}
+
+static float window_var(const hx711_count_t* c) {
+    if (c->n < 2) return 0.0f;
+    double var = (c->sq - c->sum * c->sum / c->n) / (c->n - 1);
+    return var > 0.0 ? (float)var : 0.0f;
+}
+
+static bool window_stable(const hx711_count_t* c) {
+    return c->n == c->window && window_var(c) <= c->stable_sd * c->stable_sd;
+}
+
+// APW variance for a reference of `pieces` weighed with mean variance sem2
+static float apw_variance(const hx711_count_t* c, uint32_t pieces, float sem2) {
+    return c->piece_var / pieces + sem2 / ((float)pieces * pieces);
+}
+
+int hx711_count_set_reference(hx711_count_t* c, uint32_t pieces) {
+    if (pieces == 0 || !window_stable(c)) return -1;
+    float mean = window_mean(c);
+    float sem2 = window_var(c) / c->n;
+    if (mean <= 3.0f * c->stable_sd) return -1;
+
+    c->have_ref = true;
+    c->ref_pieces = pieces;
+    c->apw = mean / pieces;
+    c->piece_var = (c->cv * c->apw) * (c->cv * c->apw);
+    c->resid_sum = 0.0;
+    c->refinements = 0;
+    c->apw_var = apw_variance(c, pieces, sem2);
+    return 0;
+}
+
+// Count of `mean` with its standard deviation in pieces. The first `kept`
+// pieces are known to be the reference ones, whose weights the APW already
+// holds; only the rest add piece and APW error.
+static void count_of(const hx711_count_t* c, float mean, float sem2, uint32_t kept, hx711_count_result_t* out) {
+    out->exact = mean / c->apw;
+    out->count = lroundf(out->exact);
+    if (out->count < 0) out->count = 0;
+
+    float m = (float)out->count - (float)kept;
+    if (m < 0.0f) m = -m;
+    float var = (m * c->piece_var + m * m * c->apw_var + sem2) / (c->apw * c->apw);
+    out->sd = sqrtf(var);
+    out->bound = Z95 * out->sd;
+    out->confidence = out->sd > 0.0f ? (float)erf(0.5 / (out->sd * SQRT_2)) : 1.0f;
+}
+
+int hx711_count_get(const hx711_count_t* c, hx711_count_result_t* out) {
+    if (!c->have_ref || c->n == 0) return -1;
+    // Nothing says the reference pieces are still there: full error
+    count_of(c, window_mean(c), window_var(c) / c->n, 0, out);
+    out->stable = window_stable(c);
+    return 0;
+}
+
+// A settled, larger count that is almost surely exact becomes the reference
+static bool try_refine(hx711_count_t* c) {
+    hx711_count_result_t r;
+    float mean = window_mean(c);
+    float sem2 = window_var(c) / c->n;
+
+    // Refining means adding pieces to the reference, so only the added
+    // ones are uncertain; swapped pieces show up as a large residual below
+    count_of(c, mean, sem2, c->ref_pieces, &r);
+    if (r.count <= (long)c->ref_pieces || r.confidence < c->refine_confidence) return false;
+
+    // What the residual says about the pieces. With the m pieces added on
+    // top of the reference its variance is m piece_var + m^2 apw_var + sem2;
+    // the excess over the known terms, per piece, is one observation of
+    // piece_var. (Pieces swapped rather than added only inflate it.)
+    float n = (float)r.count;
+    float m = n - (float)c->ref_pieces;
+    float resid = mean - n * c->apw;
+    float excess = (resid * resid - m * m * c->apw_var - sem2) / m;
+    c->resid_sum += excess > 0.0f ? excess : 0.0f;
+    c->refinements++;
+    float prior = (c->cv * c->apw) * (c->cv * c->apw);
+    c->piece_var = (float)((PRIOR_WEIGHT * prior + c->resid_sum) / (PRIOR_WEIGHT + c->refinements));
+
+    c->ref_pieces = (uint32_t)r.count;
+    c->apw = mean / n;
+    c->apw_var = apw_variance(c, c->ref_pieces, sem2);
+    return true;
+}
+
+bool hx711_count_push(hx711_count_t* c, float value) {
+    if (c->n == c->window) {
+        float old = c->ring[c->head];
+        c->sum -= old;
+        c->sq -= (double)old * old;
+    } else {
+        c->n++;
+    }
+    c->ring[c->head] = value;
+    c->sum += value;
+    c->sq += (double)value * value;
+    c->head = (uint16_t)((c->head + 1) % c->window);
+
+    // Re-sum once per lap so the sliding sums do not drift
+    if (c->head == 0 && c->n == c->window) {
+        c->sum = 0.0;
+        c->sq = 0.0;
+        for (int i = 0; i < c->n; i++) {
+            c->sum += c->ring[i];
+            c->sq += (double)c->ring[i] * c->ring[i];
+        }
+    }
+
+    // Refine only on a weight that has stayed settled for another full
+    // window, so the tail of a drop transient cannot bias the new APW
+    if (!window_stable(c)) {
+        c->stable_run = 0;
+        return false;
+    }
+    if (c->stable_run < c->window) c->stable_run++;
+    if (!c->have_ref || c->refine_confidence <= 0.0f || c->stable_run < c->window) return false;
+    return try_refine(c);
+}
@@ -0,0 +1,117 @@
+/**
+ *
+ * Piece counting for the HX711 sample stream
+ *
+ * A reference quantity sets the average piece weight (APW); every count is
+ * then the settled weight divided by it. Counting error has three sources:
+ * pieces differ from each other (sd = cv x APW), the APW itself is only
+ * known to sd_apw, and the weight reading is noisy. For a count of n:
+ *
+ *     var(count) = (n sd_piece^2 + n^2 sd_apw^2 + sem^2) / APW^2
+ *
+ * The n^2 term dominates as the count grows, which is why a small reference
+ * sample miscounts large quantities. The counter refines the APW as pieces
+ * are added on top of the reference: then only the m added pieces carry
+ * piece and APW error, and once a settled count is more than the reference
+ * and its probability of being exact (with m in place of n) reaches the
+ * refine level, that count becomes the new reference and the APW is
+ * re-taken from its weight. Each refinement also checks the residual
+ * against the expected spread and updates the piece-to-piece variation, so
+ * a batch more uneven than the assumed cv slows further refinement down.
+ * Reported counts always carry the full error above, since nothing says
+ * the reference pieces are still on the platform.
+ *
+ * Samples go in at full rate; the settled weight is the mean of a sliding
+ * window, and "settled" means the window's spread is within stable_sd.
+ *
+ */
+#ifndef HX711_COUNT_H
+#define HX711_COUNT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HX711_COUNT_MAX_WINDOW 64 // Samples in the settling window, at most
+
+// A count
+typedef struct {
+    long count;              // Nearest whole count
+    float exact;             // Weight / APW
+    float sd;                // Standard deviation of the count, pieces
+    float bound;             // 95% bound, +/- pieces
+    float confidence;        // Probability the count is exact, 0..1
+    bool stable;             // Weight settled; otherwise a live, unqualified count
+} hx711_count_result_t;
+
+typedef struct {
+    // Settings
+    uint16_t window;         // Samples averaged for the settled weight
+    float stable_sd;         // Window spread below this counts as settled
+    float cv;                // Assumed piece-to-piece variation (sd / APW)
+    float refine_confidence; // Refine once a larger count is this likely exact, 0 = never
+
+    // Settling window
+    float ring[HX711_COUNT_MAX_WINDOW];
+    uint16_t head;
+    uint16_t n;
+    double sum;
+    double sq;
+    uint16_t stable_run;     // Consecutive settled samples, up to `window`
+
+    // Reference
+    bool have_ref;
+    uint32_t ref_pieces;     // Pieces the APW was last taken from
+    float apw;               // Average piece weight
+    float apw_var;           // Its variance
+    float piece_var;         // Piece-to-piece variance
+    double resid_sum;        // Piece variance seen at refinements, summed
+    uint32_t refinements;
+} hx711_count_t;
+
+/**
+ * @brief Initializes the counter with no reference.
+ * @param c Pointer to the counter.
+ * @param window Samples averaged for the settled weight (e.g. 16 = 200 ms at 80 SPS).
+ * @param stable_sd Largest sample spread that counts as settled, in the units fed in.
+ * @param cv Expected piece-to-piece variation as a fraction of the piece weight (e.g. 0.02).
+ * @param refine_confidence Confidence at which a larger count refines the APW (e.g. 0.999), 0 = off.
+ */
+void hx711_count_init(hx711_count_t* c, uint16_t window, float stable_sd, float cv, float refine_confidence);
+
+/**
+ * @brief Feeds one sample; refines the APW when a settled count allows it.
+ * @param c Pointer to the counter.
+ * @param value Net weight, unfiltered.
+ * @return True if the sample refined the APW.
+ */
+bool hx711_count_push(hx711_count_t* c, float value);
+
+/**
+ * @brief Drops the settling window (e.g. after a tare); the reference stays.
+ * @param c Pointer to the counter.
+ */
+void hx711_count_flush(hx711_count_t* c);
+
+/**
+ * @brief Takes the settled weight as `pieces` pieces.
+ * @param c Pointer to the counter.
+ * @param pieces Pieces on the platform.
+ * @return 0 on success, -1 if the weight is not settled or not above the noise.
+ */
+int hx711_count_set_reference(hx711_count_t* c, uint32_t pieces);
+
+/**
+ * @brief Forgets the reference.
+ * @param c Pointer to the counter.
+ */
+void hx711_count_clear_reference(hx711_count_t* c);
+
+/**
+ * @brief Counts the current weight.
+ * @param c Pointer to the counter.
+ * @param out Receives the count.
+ * @return 0 on success, -1 without a reference or before the window has a sample.
+ */
+int hx711_count_get(const hx711_count_t* c, hx711_count_result_t* out);
+
+#endif /* HX711_COUNT_H */
@@ -0,0 +1,105 @@
+/**
+ *
+ * Multi-point calibration curve for the HX711 library
+ *
+ */
+#include "hx711_curve.h"
+#include <math.h>
+#include <string.h>
+
+void hx711_curve_init(hx711_curve_t* curve) {
+    memset(curve, 0, sizeof(*curve));
+}
+
+int hx711_curve_add_point(hx711_curve_t* curve, long net, float units) {
+    if (curve->count >= HX711_CURVE_MAX_POINTS) return -1;
+
+    // Keep the breakpoints sorted for the binary search
+    int i = curve->count;
+    while (i > 0 && curve->net[i - 1] > net) {
+        curve->net[i] = curve->net[i - 1];
+        curve->units[i] = curve->units[i - 1];
+        i--;
+    }
+    if (i > 0 && curve->net[i - 1] == net) {
+        // Undo the shift
+        for (int k = i; k < curve->count; k++) {
+            curve->net[k] = curve->net[k + 1];
+            curve->units[k] = curve->units[k + 1];
+        }
+        return -1;
+    }
+    curve->net[i] = net;
+    curve->units[i] = units;
+    curve->count++;
+    curve->built = false;
+    return 0;
+}
+
+int hx711_curve_build(hx711_curve_t* curve) {
+    curve->built = false;
+    if (curve->count < 2) return -1;
+
+    // Load must rise (or fall) with the reading throughout
+    float dir = curve->units[1] - curve->units[0];
+    for (int i = 0; i < curve->count - 1; i++) {
+        float du = curve->units[i + 1] - curve->units[i];
+        if (du == 0.0f || (du > 0.0f) != (dir > 0.0f)) return -1;
+
+        double slope = (double)du / (double)(curve->net[i + 1] - curve->net[i]);
+        curve->slope[i] = (float)slope;
+        curve->base[i] = (float)(curve->units[i] - slope * (double)curve->net[i]);
+    }
+    curve->segments = curve->count - 1;
+
+    // Narrowest power-of-two bucket that still covers the curve in the table;
+    // a bucket then rarely holds more than one breakpoint
+    uint64_t span = (uint64_t)(curve->net[curve->count - 1] - curve->net[0]);
+    curve->bucket_shift = 0;
+    while ((span >> curve->bucket_shift) >= HX711_CURVE_BUCKETS) curve->bucket_shift++;
+
+    int seg = 0;
+    for (int b = 0; b < HX711_CURVE_BUCKETS; b++) {
+        long start = curve->net[0] + (long)((uint64_t)b << curve->bucket_shift);
+        while (seg < curve->segments - 1 && start >= curve->net[seg + 1]) seg++;
+        curve->bucket_seg[b] = (uint8_t)seg;
+    }
+    curve->built = true;
+    return 0;
+}
+
+int hx711_curve_from_factor(hx711_curve_t* curve, float factor) {
+    if (factor == 0.0f) return -1;
+    hx711_curve_init(curve);
+    hx711_curve_add_point(curve, 0, 0.0f);
+    hx711_curve_add_point(curve, lroundf(factor * 1000.0f), 1000.0f);
+    return hx711_curve_build(curve);
+}
+
+float hx711_curve_eval(const hx711_curve_t* curve, long net) {
+    // Below the first breakpoint the first segment extends outwards, past the
+    // last bucket the last segment does
+    long rel = net - curve->net[0];
+    unsigned long b = rel < 0 ? 0 : (unsigned long)rel >> curve->bucket_shift;
+    if (b >= HX711_CURVE_BUCKETS) b = HX711_CURVE_BUCKETS - 1;
+
+    int seg = curve->bucket_seg[b];
+    while (seg < curve->segments - 1 && net >= curve->net[seg + 1]) seg++;
+    return curve->base[seg] + curve->slope[seg] * (float)net;
+}
+
+float hx711_curve_nonlinearity(const hx711_curve_t* curve) {
+    int last = curve->count - 1;
+    if (last < 2) return 0.0f;
+
+    double span_u = curve->units[last] - curve->units[0];
+    double span_n = (double)(curve->net[last] - curve->net[0]);
+    float worst = 0.0f;
+
+    for (int i = 1; i < last; i++) {
+        double line = curve->units[0] + span_u * (double)(curve->net[i] - curve->net[0]) / span_n;
+        float dev = (float)fabs((curve->units[i] - line) / span_u);
+        if (dev > worst) worst = dev;
+    }
+    return worst;
+}
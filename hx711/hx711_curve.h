@@ -0,0 +1,82 @@
+/**
+ *
+ * Multi-point calibration curve for the HX711 library
+ *
+ * Up to HX711_CURVE_MAX_POINTS calibration points (net raw counts -> units)
+ * joined piecewise-linearly, to correct a load cell's real non-linearity.
+ * hx711_curve_build() precomputes an intercept and slope per segment and a
+ * table mapping power-of-two wide buckets of the reading to segments, so
+ * evaluating a sample is a shift, a table load, usually one compare and one
+ * multiply-add; cheaper than the divide of a single factor.
+ * Beyond the outermost points the end segments are extended.
+ *
+ */
+#ifndef HX711_CURVE_H
+#define HX711_CURVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HX711_CURVE_MAX_POINTS 16
+#define HX711_CURVE_BUCKETS 64
+
+typedef struct hx711_curve_s {
+    int count;
+    long net[HX711_CURVE_MAX_POINTS];      // Breakpoints, net raw counts, ascending
+    float units[HX711_CURVE_MAX_POINTS];   // Known load at each breakpoint
+
+    // Segment table from hx711_curve_build(): units = base[i] + slope[i] * net
+    int segments;
+    float base[HX711_CURVE_MAX_POINTS - 1];
+    float slope[HX711_CURVE_MAX_POINTS - 1];
+    unsigned int bucket_shift;                 // Bucket = (net - net[0]) >> bucket_shift
+    uint8_t bucket_seg[HX711_CURVE_BUCKETS];   // First segment overlapping each bucket
+    bool built;
+} hx711_curve_t;
+
+/**
+ * @brief Initializes an empty curve.
+ * @param curve Pointer to the curve.
+ */
+void hx711_curve_init(hx711_curve_t* curve);
+
+/**
+ * @brief Adds a calibration point; points may be added in any order.
+ * @param curve Pointer to the curve.
+ * @param net Net reading (raw minus tare offset) under the load.
+ * @param units Known load in calibrated units.
+ * @return 0 on success, -1 if the curve is full or the reading is already a point.
+ */
+int hx711_curve_add_point(hx711_curve_t* curve, long net, float units);
+
+/**
+ * @brief Builds the segment table.
+ * @param curve Pointer to the curve.
+ * @return 0 on success, -1 with fewer than two points or a non-monotonic curve.
+ */
+int hx711_curve_build(hx711_curve_t* curve);
+
+/**
+ * @brief Curve equivalent to a single calibration factor (counts per unit).
+ * @param curve Pointer to the curve.
+ * @param factor The calibration factor.
+ * @return 0 on success, -1 for a zero factor.
+ */
+int hx711_curve_from_factor(hx711_curve_t* curve, float factor);
+
+/**
+ * @brief Converts a net reading to units through the segment table.
+ * @param curve Pointer to a built curve.
+ * @param net Net reading (raw minus tare offset).
+ * @return The load in calibrated units.
+ */
+float hx711_curve_eval(const hx711_curve_t* curve, long net);
+
+/**
+ * @brief Largest deviation of a point from the straight line through the end points.
+ * @param curve Pointer to a built curve.
+ * @return The deviation as a fraction of the end-point load (0.001 = 0.1%).
+ */
+float hx711_curve_nonlinearity(const hx711_curve_t* curve);
+
+#endif /* HX711_CURVE_H */
@@ -0,0 +1,240 @@
+/**
+ *
+ * Closed-loop filling/dosing controller for the HX711 sample stream
+ *
+ */
+#include "hx711_dosing.h"
+#include <string.h>
+
+static float clamp_preact(const hx711_dosing_t* d, float preact) {
+    return preact < 0.0f ? 0.0f : preact > d->preact_max ? d->preact_max : preact;
+}
+
+void hx711_dosing_init(hx711_dosing_t* d, float fine_band, hx711_dose_output_func output, void* ctx) {
+    memset(d, 0, sizeof(*d));
+    d->fine_band = fine_band > 0.0f ? fine_band : 0.0f;
+    d->output = output;
+    d->ctx = ctx;
+    atomic_store(&d->state, HX711_DOSE_IDLE);
+    hx711_dosing_set_learning(d, 0.5f, 10.0f * d->fine_band);
+    hx711_dosing_set_timing(d, 2, 8, 300000000ull, 500000000ull, 60000000000ull);
+    if (d->output) d->output(false, false, d->ctx);
+}
+
+void hx711_dosing_set_learning(hx711_dosing_t* d, float learn, float preact_max) {
+    d->learn = learn < 0.0f ? 0.0f : learn > 1.0f ? 1.0f : learn;
+    d->preact_max = preact_max > 0.0f ? preact_max : 0.0f;
+    d->preact = clamp_preact(d, d->preact);
+    d->coarse_preact = clamp_preact(d, d->coarse_preact);
+}
+
+void hx711_dosing_set_preact(hx711_dosing_t* d, float preact, float coarse_preact) {
+    d->preact = clamp_preact(d, preact);
+    d->coarse_preact = clamp_preact(d, coarse_preact);
+}
+
+void hx711_dosing_set_timing(hx711_dosing_t* d, uint16_t avg, uint16_t tare_samples, uint64_t blank_ns,
+                             uint64_t settle_ns, uint64_t timeout_ns) {
+    if (avg < 1) avg = 1;
+    if (avg > HX711_DOSE_MAX_AVG) avg = HX711_DOSE_MAX_AVG;
+    if (tare_samples < 1) tare_samples = 1;
+    d->avg = avg;
+    d->tare_samples = tare_samples;
+    d->blank_ns = blank_ns;
+    d->settle_ns = settle_ns;
+    d->timeout_ns = timeout_ns;
+}
+
+void hx711_dosing_start(hx711_dosing_t* d, float target) {
+    atomic_store_explicit(&d->req_target, target, memory_order_relaxed);
+    atomic_fetch_add_explicit(&d->req_start, 1, memory_order_release);
+}
+
+void hx711_dosing_abort(hx711_dosing_t* d) {
+    atomic_fetch_add_explicit(&d->req_abort, 1, memory_order_release);
+}
+
+hx711_dose_state_t hx711_dosing_state(const hx711_dosing_t* d) {
+    return (hx711_dose_state_t)atomic_load_explicit(&d->state, memory_order_relaxed);
+}
+
+float hx711_dosing_net(const hx711_dosing_t* d) {
+    return atomic_load_explicit(&d->net, memory_order_relaxed);
+}
+
+static void set_state(hx711_dosing_t* d, hx711_dose_state_t state) {
+    atomic_store_explicit(&d->state, state, memory_order_relaxed);
+}
+
+// Moving average of the last `avg` net readings
+static float window_push(hx711_dosing_t* d, float net) {
+    if (d->win_n == d->avg) d->win_sum -= d->win[d->win_head];
+    else d->win_n++;
+    d->win[d->win_head] = net;
+    d->win_sum += net;
+    d->win_head = (uint16_t)((d->win_head + 1) % d->avg);
+    return d->win_sum / d->win_n;
+}
+
+// Closes both feeds, records the cycle and learns from its overshoot
+static void finish(hx711_dosing_t* d, uint64_t timestamp_ns, float actual, bool fault) {
+    hx711_dose_cycle_t c;
+
+    if (d->output) d->output(false, false, d->ctx);
+
+    uint32_t seq = atomic_load_explicit(&d->cycles, memory_order_relaxed);
+    c.index = seq / 2 + 1;
+    c.target = d->target;
+    c.actual = actual;
+    c.overshoot = actual - d->target;
+    c.coarse_cut = d->coarse_cut;
+    c.coarse_inflight = d->coarse_inflight;
+    c.cut_weight = d->cut_weight;
+    c.preact = d->preact;
+    c.coarse_preact = d->coarse_preact;
+    c.fill_ns = d->cut_ns ? d->cut_ns - d->start_ns : timestamp_ns - d->start_ns;
+    c.cycle_ns = timestamp_ns - d->start_ns;
+    c.fault = fault;
+
+    // The overshoot is what the preact missed by; moving part way there
+    // keeps one odd cycle from swinging it. The coarse preact moves the same
+    // way towards the in-flight measured this cycle.
+    if (!fault) {
+        d->preact = clamp_preact(d, d->preact + d->learn * c.overshoot);
+        if (d->coarse_inflight >= 0.0f) {
+            d->coarse_preact = clamp_preact(d, d->coarse_preact + d->learn * (d->coarse_inflight - d->coarse_preact));
+        }
+    }
+
+    atomic_store_explicit(&d->cycles, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    d->last = c;
+    atomic_store_explicit(&d->cycles, seq + 2, memory_order_release);
+
+    set_state(d, fault ? HX711_DOSE_FAULT : HX711_DOSE_IDLE);
+}
+
+// Fine cut-off reached: everything closes, the rest is in the air
+static void cut_off(hx711_dosing_t* d, uint64_t timestamp_ns, float net) {
+    if (d->output) d->output(false, false, d->ctx);
+    d->cut_ns = timestamp_ns;
+    d->cut_weight = net;
+    d->acc = 0.0;
+    d->acc_n = 0;
+    set_state(d, HX711_DOSE_SETTLE);
+}
+
+bool hx711_dosing_push(hx711_dosing_t* d, uint64_t timestamp_ns, float grams) {
+    hx711_dose_state_t state = hx711_dosing_state(d);
+
+    d->rejects = 0;
+
+    uint32_t abort_req = atomic_load_explicit(&d->req_abort, memory_order_acquire);
+    if (abort_req != d->seen_abort) {
+        d->seen_abort = abort_req;
+        if (state != HX711_DOSE_IDLE && state != HX711_DOSE_FAULT) {
+            finish(d, timestamp_ns, state == HX711_DOSE_TARE ? 0.0f : grams - d->zero, true);
+            return true;
+        }
+    }
+
+    uint32_t start_req = atomic_load_explicit(&d->req_start, memory_order_acquire);
+    if (start_req != d->seen_start) {
+        d->seen_start = start_req;
+        if (state == HX711_DOSE_IDLE || state == HX711_DOSE_FAULT) {
+            d->target = atomic_load_explicit(&d->req_target, memory_order_relaxed);
+            d->acc = 0.0;
+            d->acc_n = 0;
+            d->start_ns = timestamp_ns;
+            d->cut_ns = 0;
+            d->coarse_cut = -1.0f;
+            d->coarse_inflight = -1.0f;
+            d->cut_weight = 0.0f;
+            state = HX711_DOSE_TARE;
+            set_state(d, state);
+        }
+    }
+
+    switch (state) {
+    case HX711_DOSE_TARE:
+        d->acc += grams;
+        if (++d->acc_n < d->tare_samples) return false;
+        d->zero = (float)(d->acc / d->acc_n);
+        atomic_store_explicit(&d->net, 0.0f, memory_order_relaxed);
+        d->win_sum = 0.0f;
+        d->win_head = 0;
+        d->win_n = 0;
+        d->start_ns = timestamp_ns;
+        if (d->target - d->preact <= 0.0f) {
+            cut_off(d, timestamp_ns, 0.0f);
+        } else if (d->target - d->preact - d->fine_band - d->coarse_preact <= 0.0f) {
+            if (d->output) d->output(false, true, d->ctx);
+            set_state(d, HX711_DOSE_FINE);
+        } else {
+            if (d->output) d->output(true, true, d->ctx);
+            set_state(d, HX711_DOSE_COARSE);
+        }
+        return false;
+
+    case HX711_DOSE_COARSE:
+    case HX711_DOSE_FINE: {
+        float net = window_push(d, grams - d->zero);
+        atomic_store_explicit(&d->net, net, memory_order_relaxed);
+        if (d->coarse_cut >= 0.0f && d->coarse_inflight < 0.0f) {
+            // Coarse column still landing: only the timeout may end the cycle
+            if (timestamp_ns - d->coarse_ns < d->blank_ns) {
+                if (timestamp_ns - d->start_ns <= d->timeout_ns) return false;
+                finish(d, timestamp_ns, net, true);
+                return true;
+            }
+            d->coarse_inflight = net - d->coarse_cut;
+        }
+        if (net >= d->target - d->preact) {
+            cut_off(d, timestamp_ns, net);
+        } else if (state == HX711_DOSE_COARSE &&
+                   net >= d->target - d->preact - d->fine_band - d->coarse_preact) {
+            if (d->output) d->output(false, true, d->ctx);
+            d->coarse_ns = timestamp_ns;
+            d->coarse_cut = net;
+            set_state(d, HX711_DOSE_FINE);
+        } else if (timestamp_ns - d->start_ns > d->timeout_ns) {
+            finish(d, timestamp_ns, net, true);
+            return true;
+        }
+        return false;
+    }
+
+    case HX711_DOSE_SETTLE:
+        if (timestamp_ns - d->cut_ns < d->settle_ns) return false;
+        d->acc += grams - d->zero;
+        if (++d->acc_n < d->tare_samples) return false;
+        finish(d, timestamp_ns, (float)(d->acc / d->acc_n), false);
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool hx711_dosing_reject(hx711_dosing_t* d, uint64_t timestamp_ns) {
+    hx711_dose_state_t state = hx711_dosing_state(d);
+
+    if (state == HX711_DOSE_IDLE || state == HX711_DOSE_FAULT) return false;
+    if (++d->rejects < HX711_DOSE_MAX_REJECTS) return false;
+    finish(d, timestamp_ns, state == HX711_DOSE_TARE ? 0.0f : hx711_dosing_net(d), true);
+    return true;
+}
+
+bool hx711_dosing_poll_cycle(hx711_dosing_t* d, uint32_t* seen, hx711_dose_cycle_t* out) {
+    for (int tries = 0; tries < 4; tries++) {
+        uint32_t seq = atomic_load_explicit(&d->cycles, memory_order_acquire);
+        if (seq & 1) continue;
+        if (seq / 2 == *seen) return false;
+        *out = d->last;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&d->cycles, memory_order_relaxed) != seq) continue;
+        *seen = seq / 2;
+        return true;
+    }
+    return false;
+}
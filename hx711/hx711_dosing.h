@@ -0,0 +1,212 @@
+/**
+ *
+ * Closed-loop filling/dosing controller for the HX711 sample stream
+ *
+ * Drives a two-speed feeder (coarse + fine outputs) to a target net weight.
+ * A cycle nets out the container, runs both feeds, then the fine feed
+ * alone until the target minus the preact, and waits for the material still
+ * in flight to land before weighing the result.
+ *
+ * Both cut-offs learn their in-flight compensation. For blank_ns after the
+ * coarse cut-off the coarse column is still landing: no fine decision is
+ * taken, and what arrives in that time is the coarse in-flight the coarse
+ * preact moves towards. With the coarse feed cut that much early the fine
+ * feed alone adds the last fine_band grams, and the fine cut-off only has to
+ * account for its own small column. The preact moves by a fraction of each
+ * cycle's overshoot.
+ *
+ * hx711_dosing_push() is O(1), never blocks and calls the output function
+ * directly, so it can run on the acquisition thread through
+ * hx711_acq_set_sample_hook() and cut the feed within one conversion.
+ * Start/abort requests, the state, the net weight and finished cycles
+ * cross threads through atomics; everything else is owned by the thread
+ * that pushes.
+ *
+ */
+#ifndef HX711_DOSING_H
+#define HX711_DOSING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define HX711_DOSE_MAX_AVG 16    // Samples averaged for cut-off decisions, at most
+#define HX711_DOSE_MAX_REJECTS 3 // Rejected conversions in a row that fault a running cycle
+
+typedef enum {
+    HX711_DOSE_IDLE,
+    HX711_DOSE_TARE,      // Averaging the container before feeding
+    HX711_DOSE_COARSE,    // Both feeds open
+    HX711_DOSE_FINE,      // Fine feed only
+    HX711_DOSE_SETTLE,    // Feeds closed, material in flight landing
+    HX711_DOSE_FAULT      // Timed out, aborted or rejected samples; feeds closed
+} hx711_dose_state_t;
+
+// Sets the feeder outputs; called from the pushing thread
+typedef void (*hx711_dose_output_func)(bool coarse, bool fine, void* ctx);
+
+// One finished cycle
+typedef struct {
+    uint32_t index;
+    float target;
+    float actual;            // Settled net weight
+    float overshoot;         // actual - target
+    float coarse_cut;        // Net weight when the coarse feed was cut
+    float coarse_inflight;   // Coarse material that landed during the blanking time
+    float cut_weight;        // Net weight when the fine feed was cut
+    float preact;            // Preact used for this cycle
+    float coarse_preact;     // Coarse preact used for this cycle
+    uint64_t fill_ns;        // Start of feeding to the fine cut-off
+    uint64_t cycle_ns;       // Start of feeding to the settled weight
+    bool fault;              // Timed out, aborted or rejected samples; actual is the last reading
+} hx711_dose_cycle_t;
+
+typedef struct {
+    // Settings (set before the first cycle)
+    float fine_band;         // Grams the fine feed alone should add
+    float preact;            // Fine in-flight compensation, learned
+    float coarse_preact;     // Coarse in-flight compensation, learned
+    float preact_max;
+    float learn;             // Share of each cycle's error folded into the preacts (0..1)
+    uint16_t avg;            // Samples averaged for cut-off decisions
+    uint16_t tare_samples;   // Samples averaged for the container and the result
+    uint64_t blank_ns;       // No fine cut-off this long after the coarse one
+    uint64_t settle_ns;      // Wait after the cut-off before weighing the result
+    uint64_t timeout_ns;     // Longest feeding time before the cycle faults
+    hx711_dose_output_func output;
+    void* ctx;
+
+    // Requests from other threads
+    _Atomic float req_target;
+    _Atomic uint32_t req_start;
+    _Atomic uint32_t req_abort;
+    uint32_t seen_start;
+    uint32_t seen_abort;
+
+    // Cycle state (pushing thread)
+    _Atomic int state;
+    float target;
+    float zero;
+    double acc;
+    uint16_t acc_n;
+    float win[HX711_DOSE_MAX_AVG];
+    float win_sum;
+    uint16_t win_head;
+    uint16_t win_n;
+    uint64_t start_ns;
+    uint64_t cut_ns;
+    uint64_t coarse_ns;      // Time of the coarse cut-off
+    float coarse_cut;        // Negative if the cycle had no coarse phase
+    float coarse_inflight;   // Negative until the blanking time has passed
+    float cut_weight;
+    uint16_t rejects;        // Rejected conversions since the last good one
+    _Atomic float net;       // Latest averaged net weight; read from any thread
+
+    // Latest finished cycle; seqlock, odd while `last` is written, 2 x cycles finished
+    _Atomic uint32_t cycles;
+    hx711_dose_cycle_t last;
+} hx711_dosing_t;
+
+/**
+ * @brief Initializes the controller, idle with both feeds closed.
+ * @param d Pointer to the controller.
+ * @param fine_band Grams the fine feed alone should add.
+ * @param output Sets the coarse/fine outputs.
+ * @param ctx Passed through to the output function.
+ */
+void hx711_dosing_init(hx711_dosing_t* d, float fine_band, hx711_dose_output_func output, void* ctx);
+
+/**
+ * @brief Sets the in-flight compensation, e.g. the values saved after the last run.
+ * @param d Pointer to the controller.
+ * @param preact Fine cut-off this many grams before the target.
+ * @param coarse_preact Coarse cut-off this many grams before the fine band.
+ */
+void hx711_dosing_set_preact(hx711_dosing_t* d, float preact, float coarse_preact);
+
+/**
+ * @brief Sets the learning rate and preact limit.
+ * @param d Pointer to the controller.
+ * @param learn Share of each cycle's error added to the preacts (default 0.5, 0 = fixed).
+ * @param preact_max Largest preact in grams, either one (default 10 x fine_band).
+ */
+void hx711_dosing_set_learning(hx711_dosing_t* d, float learn, float preact_max);
+
+/**
+ * @brief Sets decision averaging and cycle timing.
+ * @param d Pointer to the controller.
+ * @param avg Samples averaged for cut-off decisions (default 2).
+ * @param tare_samples Samples averaged for the container and the result (default 8).
+ * @param blank_ns Coarse column landing time: valve delay plus fall (default 300 ms).
+ * @param settle_ns Wait after the cut-off before weighing (default 500 ms).
+ * @param timeout_ns Longest feeding time (default 60 s).
+ */
+void hx711_dosing_set_timing(hx711_dosing_t* d, uint16_t avg, uint16_t tare_samples, uint64_t blank_ns,
+                             uint64_t settle_ns, uint64_t timeout_ns);
+
+/**
+ * @brief Requests a cycle; taken up by the next pushed sample. Any thread.
+ * @param d Pointer to the controller.
+ * @param target Net weight to fill, in grams.
+ */
+void hx711_dosing_start(hx711_dosing_t* d, float target);
+
+/**
+ * @brief Requests the running cycle to stop with both feeds closed. Any thread.
+ *
+ * The request is taken up by the next pushed sample; a caller that cannot
+ * wait for one (the sample stream may be what failed) closes the outputs
+ * itself as well.
+ *
+ * @param d Pointer to the controller.
+ */
+void hx711_dosing_abort(hx711_dosing_t* d);
+
+/**
+ * @brief Feeds one sample, advancing the cycle and switching the outputs.
+ * @param d Pointer to the controller.
+ * @param timestamp_ns Sample time.
+ * @param grams Gross weight.
+ * @return True if the sample finished a cycle.
+ */
+bool hx711_dosing_push(hx711_dosing_t* d, uint64_t timestamp_ns, float grams);
+
+/**
+ * @brief Reports a conversion that failed the integrity checks.
+ *
+ * The sample is skipped and the outputs stay as they are: one missing
+ * conversion only delays the next decision by a sample period. After
+ * HX711_DOSE_MAX_REJECTS in a row the weight is unknown, and a running
+ * cycle stops as a fault with both feeds closed. Call it from the pushing
+ * thread, in place of the push.
+ *
+ * @param d Pointer to the controller.
+ * @param timestamp_ns Sample time.
+ * @return True if it ended a cycle.
+ */
+bool hx711_dosing_reject(hx711_dosing_t* d, uint64_t timestamp_ns);
+
+/**
+ * @brief Current state. Any thread.
+ * @param d Pointer to the controller.
+ * @return The state.
+ */
+hx711_dose_state_t hx711_dosing_state(const hx711_dosing_t* d);
+
+/**
+ * @brief Latest averaged net weight of the running cycle. Any thread.
+ * @param d Pointer to the controller.
+ * @return Grams.
+ */
+float hx711_dosing_net(const hx711_dosing_t* d);
+
+/**
+ * @brief Takes the latest finished cycle if it is newer than `seen`. Any thread.
+ * @param d Pointer to the controller.
+ * @param seen Cycle count the caller has seen; updated.
+ * @param out Receives the cycle.
+ * @return True if a new cycle was copied.
+ */
+bool hx711_dosing_poll_cycle(hx711_dosing_t* d, uint32_t* seen, hx711_dose_cycle_t* out);
+
+#endif /* HX711_DOSING_H */
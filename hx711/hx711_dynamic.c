@@ -0,0 +1,246 @@
+/**
+ *
+ * Dynamic weighing with hold for the HX711 sample stream
+ *
+ */
+#define _GNU_SOURCE // M_PI
+#include "hx711_dynamic.h"
+#include <math.h>
+#include <string.h>
+
+#define TRIM_FRACTION 0.25f  // Dropped from each end of a block
+#define GATE_K 3.5f          // Block means further than this many robust sd from the median are gated out
+#define MAD_TO_SD 1.4826f    // MAD of a normal distribution -> standard deviation
+#define MIN_BATCHES 4        // Batches before a confidence is given
+#define SPREAD_Z 0.6745      // Normal quantile of the spread bound: upper quartile
+
+// P(|T| < t) for Student's t with df degrees of freedom, by the finite
+// series for integer df (Abramowitz & Stegun 26.7.3 and 26.7.4)
+static double t_within(double t, int df) {
+    double theta = atan(t / sqrt((double)df));
+    double c2 = cos(theta) * cos(theta);
+    double term = 1.0, sum = 1.0;
+
+    if (df % 2 == 0) {
+        for (int k = 2; k <= df - 2; k += 2) {
+            term *= c2 * (k - 1) / k;
+            sum += term;
+        }
+        return sin(theta) * sum;
+    }
+    if (df == 1) return 2.0 * theta / M_PI;
+    for (int k = 3; k <= df - 2; k += 2) {
+        term *= c2 * (k - 1) / k;
+        sum += term;
+    }
+    return 2.0 / M_PI * (theta + sin(theta) * cos(theta) * sum);
+}
+
+// Factor from a standard error with df degrees of freedom to its upper
+// quartile bound, sqrt(df / chi2), with the chi-square lower quartile from
+// the Wilson-Hilferty cube
+static double spread_bound(int df) {
+    double a = 2.0 / (9.0 * df);
+    double q = 1.0 - a - SPREAD_Z * sqrt(a);
+    return sqrt(1.0 / (q * q * q));
+}
+
+void hx711_dynamic_init(hx711_dynamic_t* dyn, float min_load, float tolerance, float lock_confidence,
+                        hx711_dyn_func cb, void* ctx) {
+    memset(dyn, 0, sizeof(*dyn));
+    dyn->min_load = fabsf(min_load);
+    dyn->tolerance = fabsf(tolerance);
+    dyn->lock_confidence = lock_confidence;
+    dyn->on_event = cb;
+    dyn->ctx = ctx;
+    hx711_dynamic_set_window(dyn, 10, 6);
+}
+
+void hx711_dynamic_set_window(hx711_dynamic_t* dyn, uint16_t block_len, uint16_t min_blocks) {
+    if (block_len < 4) block_len = 4;
+    if (block_len > HX711_DYN_MAX_BLOCK) block_len = HX711_DYN_MAX_BLOCK;
+    if (min_blocks < 4) min_blocks = 4;
+    if (min_blocks > HX711_DYN_MAX_BLOCKS / MIN_BATCHES) min_blocks = HX711_DYN_MAX_BLOCKS / MIN_BATCHES;
+    dyn->block_len = block_len;
+    dyn->min_blocks = min_blocks;
+    dyn->block_n = 0;
+}
+
+static void clear_window(hx711_dynamic_t* dyn) {
+    dyn->block_n = 0;
+    dyn->head = 0;
+    dyn->count = 0;
+    dyn->estimate = 0.0f;
+    dyn->sem = 0.0f;
+    dyn->confidence = 0.0f;
+    dyn->confident = 0;
+}
+
+void hx711_dynamic_reset(hx711_dynamic_t* dyn) {
+    clear_window(dyn);
+    dyn->present = false;
+    dyn->held = false;
+}
+
+static void sort_floats(float* x, int n) {
+    for (int i = 1; i < n; i++) {
+        float v = x[i];
+        int j = i - 1;
+        while (j >= 0 && x[j] > v) {
+            x[j + 1] = x[j];
+            j--;
+        }
+        x[j + 1] = v;
+    }
+}
+
+// Trimmed mean of the completed block (sorts it in place)
+static float block_mean(float* x, int n) {
+    int trim = (int)(n * TRIM_FRACTION);
+    double sum = 0.0;
+
+    sort_floats(x, n);
+    for (int i = trim; i < n - trim; i++) sum += x[i];
+    return (float)(sum / (n - 2 * trim));
+}
+
+// Block mean `age` blocks back from the newest
+static float block_at(const hx711_dynamic_t* dyn, int age) {
+    return dyn->means[(dyn->head + HX711_DYN_MAX_BLOCKS - 1 - age) % HX711_DYN_MAX_BLOCKS];
+}
+
+// Median and outlier gate of the block means in the window
+static void window_gate(const hx711_dynamic_t* dyn, float* median, float* gate) {
+    float sorted[HX711_DYN_MAX_BLOCKS];
+    float dev[HX711_DYN_MAX_BLOCKS];
+    int n = dyn->count;
+
+    for (int i = 0; i < n; i++) sorted[i] = block_at(dyn, i);
+    sort_floats(sorted, n);
+    *median = n & 1 ? sorted[n / 2] : 0.5f * (sorted[n / 2 - 1] + sorted[n / 2]);
+    for (int i = 0; i < n; i++) dev[i] = fabsf(sorted[i] - *median);
+    sort_floats(dev, n);
+    *gate = GATE_K * MAD_TO_SD * dev[n / 2];
+}
+
+// Estimate, standard error and confidence from the block means in the window
+static void update_estimate(hx711_dynamic_t* dyn) {
+    float median, gate;
+
+    // Adaptive start: while the oldest block is an outlier (the arrival
+    // transient, an animal still stepping on) the window begins after it
+    window_gate(dyn, &median, &gate);
+    while (dyn->count > dyn->min_blocks && gate > 0.0f && fabsf(block_at(dyn, dyn->count - 1) - median) > gate) {
+        dyn->count--;
+        window_gate(dyn, &median, &gate);
+    }
+
+    // Batch means: the window is split into batches of at least min_blocks
+    // consecutive blocks, so more batches come in as the window grows. Swing
+    // and movement average out inside a batch and the spread of the batch
+    // means follows them down; a plain per-block spread would not.
+    int batches = dyn->count / dyn->min_blocks;
+    if (batches < 1) batches = 1;
+    double batch_sum[HX711_DYN_MAX_BLOCKS] = {0.0};
+    int batch_n[HX711_DYN_MAX_BLOCKS] = {0};
+    double sum = 0.0;
+    int kept = 0;
+    for (int i = 0; i < dyn->count; i++) {
+        float d = block_at(dyn, i) - median;
+        if (gate > 0.0f && fabsf(d) > gate) continue;
+        int b = i * batches / dyn->count;
+        batch_sum[b] += d;
+        batch_n[b]++;
+        sum += d;
+        kept++;
+    }
+    dyn->estimate = median + (float)(sum / kept);
+
+    double mean_b = 0.0, sq_b = 0.0;
+    int used = 0;
+    for (int b = 0; b < batches; b++) {
+        if (batch_n[b] == 0) continue;
+        double m = batch_sum[b] / batch_n[b];
+        mean_b += m;
+        sq_b += m * m;
+        used++;
+    }
+    mean_b /= used;
+    double var = used > 1 ? (sq_b - used * mean_b * mean_b) / (used - 1) : 0.0;
+    dyn->sem = var > 0.0 ? (float)sqrt(var / used) : 0.0f;
+
+    // The spread comes from a handful of batches, so the error is Student-t
+    // with used - 1 degrees of freedom, not normal. The confidence is looked
+    // at after every block and the first look at the lock level holds, so the
+    // looks that lock are the ones whose spread came out low; the spread is
+    // therefore taken at its upper quartile bound rather than at its estimate.
+    if (used < MIN_BATCHES) {
+        dyn->confidence = 0.0f;
+    } else if (dyn->sem <= 0.0f) {
+        dyn->confidence = 1.0f;
+    } else {
+        double sem = dyn->sem * spread_bound(used - 1);
+        dyn->confidence = (float)t_within(dyn->tolerance / sem, used - 1);
+    }
+}
+
+static void publish(hx711_dynamic_t* dyn, bool held, uint64_t timestamp_ns) {
+    hx711_dyn_event_t* ev = &dyn->last;
+
+    dyn->held = held;
+    ev->held = held;
+    ev->value = dyn->estimate;
+    ev->confidence = dyn->confidence;
+    ev->sem = dyn->sem;
+    ev->timestamp_ns = timestamp_ns;
+    ev->elapsed_ns = held ? timestamp_ns - dyn->arrive_ns : 0;
+    if (dyn->on_event) dyn->on_event(ev, dyn->ctx);
+}
+
+bool hx711_dynamic_push(hx711_dynamic_t* dyn, uint64_t timestamp_ns, float value) {
+    if (!dyn->present) {
+        if (value < dyn->min_load) return false;
+        dyn->present = true;
+        dyn->arrive_ns = timestamp_ns;
+        clear_window(dyn);
+    } else if (value < 0.5f * dyn->min_load) {
+        // Load gone: the hold ends, the next load starts a new window
+        dyn->present = false;
+        if (dyn->held) {
+            publish(dyn, false, timestamp_ns);
+            return true;
+        }
+        return false;
+    }
+
+    if (dyn->held) return false;
+
+    dyn->block[dyn->block_n++] = value;
+    if (dyn->block_n < dyn->block_len) return false;
+
+    // Block complete: into the window, oldest block out once it is full
+    dyn->means[dyn->head] = block_mean(dyn->block, dyn->block_n);
+    dyn->head = (uint16_t)((dyn->head + 1) % HX711_DYN_MAX_BLOCKS);
+    if (dyn->count < HX711_DYN_MAX_BLOCKS) dyn->count++;
+    dyn->block_n = 0;
+
+    update_estimate(dyn);
+    if (dyn->confidence < dyn->lock_confidence) {
+        dyn->confident = 0;
+        return false;
+    }
+    // One look at a lucky spread is not enough: the level must hold for
+    // min_blocks blocks, by when a batch's worth of new data has come in
+    if (++dyn->confident < dyn->min_blocks) return false;
+
+    publish(dyn, true, timestamp_ns);
+    return true;
+}
+
+bool hx711_dynamic_is_held(const hx711_dynamic_t* dyn) {
+    return dyn->held;
+}
+
+const hx711_dyn_event_t* hx711_dynamic_last(const hx711_dynamic_t* dyn) {
+    return &dyn->last;
+}
@@ -0,0 +1,131 @@
+/**
+ *
+ * Dynamic weighing with hold for the HX711 sample stream
+ *
+ * For loads that never come to rest: livestock, swinging sacks. The stream
+ * is cut into short blocks; each block is reduced to a trimmed mean, which
+ * drops knocks shorter than the trim. The estimate is the mean of the block
+ * means inside an adaptive window: it starts when the load arrives, drops
+ * leading blocks that are still outliers (the animal stepping on), grows up
+ * to HX711_DYN_MAX_BLOCKS and slides after that. Blocks far from the median
+ * (robust 3.5 sd) are gated out.
+ *
+ * The standard error comes from batch means: the window is split into
+ * batches of min_blocks consecutive blocks or more, so a periodic swing
+ * averages out of the error estimate as well as out of the value, and the
+ * batch count grows with the window. Confidence is the probability that the
+ * estimate is within the tolerance of the true load, from Student's t with
+ * one degree of freedom fewer than the batches, at least four. As the
+ * confidence is checked after every block and holds at the first look that
+ * reaches the lock level, the looks that lock are those whose spread came out
+ * low; the spread is taken at its upper quartile bound, and the confidence
+ * must stay at the lock level for min_blocks blocks in a row. The value is
+ * then held until the load leaves the platform.
+ *
+ * How soon a load holds depends on its movement against the tolerance: on
+ * the synthetic loads of dynamic_bench the median is about 7 s for a
+ * swinging sack to 0.5 % and 6 s for a sheep to 0.8 %, while a restless calf
+ * to 1 % needs about 9 s and holds on fewer than half of its 12 s visits. A
+ * tolerance the movement does not allow is no hold, not a hold outside it.
+ *
+ * All state is fixed-size; the work per sample is one add, plus a sort of
+ * one block when a block completes.
+ *
+ */
+#ifndef HX711_DYNAMIC_H
+#define HX711_DYNAMIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HX711_DYN_MAX_BLOCK 64    // Samples per block
+#define HX711_DYN_MAX_BLOCKS 64   // Blocks per window; 8 s with 10-sample blocks at 80 SPS
+
+// A lock or release
+typedef struct {
+    bool held;
+    float value;             // Held value (lock) or last estimate (release)
+    float confidence;        // 0..1
+    float sem;               // Standard error of the estimate
+    uint64_t timestamp_ns;
+    uint64_t elapsed_ns;     // Lock only: from load arrival to lock
+} hx711_dyn_event_t;
+
+typedef void (*hx711_dyn_func)(const hx711_dyn_event_t* ev, void* ctx);
+
+typedef struct {
+    float min_load;          // Load present above this, gone below half of it
+    float tolerance;         // Error the confidence refers to (e.g. the division)
+    float lock_confidence;   // Hold once confidence reaches this (0..1)
+    uint16_t block_len;      // Samples per block
+    uint16_t min_blocks;     // Blocks per batch of the error estimate
+    hx711_dyn_func on_event;
+    void* ctx;
+
+    bool present;
+    uint64_t arrive_ns;
+    float block[HX711_DYN_MAX_BLOCK];
+    uint16_t block_n;
+    float means[HX711_DYN_MAX_BLOCKS]; // Block means, ring
+    uint16_t head;
+    uint16_t count;
+
+    float estimate;          // Latest estimate, valid once count >= min_blocks
+    float sem;
+    float confidence;
+    uint16_t confident;      // Successive blocks at the lock level
+    bool held;
+    hx711_dyn_event_t last;
+} hx711_dynamic_t;
+
+/**
+ * @brief Initializes the estimator with no load present.
+ * @param dyn Pointer to the estimator.
+ * @param min_load Load that counts as present, in the units fed in.
+ * @param tolerance Error the confidence is quoted against, in the units fed in.
+ * @param lock_confidence Confidence (0..1) at which the value is held, e.g. 0.95.
+ * @param cb Called on every lock and release, or NULL.
+ * @param ctx Passed through to the callback.
+ */
+void hx711_dynamic_init(hx711_dynamic_t* dyn, float min_load, float tolerance, float lock_confidence,
+                        hx711_dyn_func cb, void* ctx);
+
+/**
+ * @brief Sets the block length and the blocks per batch of the error estimate.
+ * @param dyn Pointer to the estimator.
+ * @param block_len Samples per block, 4 to HX711_DYN_MAX_BLOCK (default 10).
+ * @param min_blocks Blocks per batch, 4 to HX711_DYN_MAX_BLOCKS / 4 (default 6);
+ *        a confidence needs four batches, and a hold min_blocks more blocks.
+ */
+void hx711_dynamic_set_window(hx711_dynamic_t* dyn, uint16_t block_len, uint16_t min_blocks);
+
+/**
+ * @brief Drops the window and any hold (e.g. after a tare).
+ * @param dyn Pointer to the estimator.
+ */
+void hx711_dynamic_reset(hx711_dynamic_t* dyn);
+
+/**
+ * @brief Feeds one sample.
+ * @param dyn Pointer to the estimator.
+ * @param timestamp_ns Sample time.
+ * @param value Load in calibrated units, unfiltered.
+ * @return True if the sample locked or released the hold.
+ */
+bool hx711_dynamic_push(hx711_dynamic_t* dyn, uint64_t timestamp_ns, float value);
+
+/**
+ * @brief Whether a value is being held.
+ * @param dyn Pointer to the estimator.
+ * @return True between a lock and the load leaving.
+ */
+bool hx711_dynamic_is_held(const hx711_dynamic_t* dyn);
+
+/**
+ * @brief Most recent lock or release.
+ * @param dyn Pointer to the estimator.
+ * @return The event; while held, its value is the held weight.
+ */
+const hx711_dyn_event_t* hx711_dynamic_last(const hx711_dynamic_t* dyn);
+
+#endif /* HX711_DYNAMIC_H */
@@ -0,0 +1,88 @@
+/**
+ *
+ * Compile-time specialized HX711 clock-out for the HX711 library
+ *
+ * The runtime path in hx711.c makes four indirect calls per data bit
+ * (gpio_write, delay, gpio_read, gpio_write), over 100 per conversion, none of
+ * which can be inlined. HX711_DEFINE_FAST_READ() instead expands a backend's
+ * pin accessors in place and produces a read_sample_func whose loop the
+ * compiler unrolls into straight-line code. Plug the result into
+ * hx711_backend_t.read_sample with read_sample_rt set, so hx711_read() still
+ * wraps it in the real-time section when no RT thread owns the chip.
+ *
+ * Each backend defines its own specialization next to its line/register
+ * state (hx711_gpiod_read_sample, hx711_sim_read_sample, ...). The
+ * runtime-pluggable hx711_init() path is unchanged.
+ *
+ * Every SCK-high phase is timed (two vDSO clock reads per pulse) and the
+ * longest left in hx711_fast_high_max_ns, which hx711_read() checks against
+ * the 60 us power-down limit.
+ *
+ */
+#ifndef HX711_FAST_H
+#define HX711_FAST_H
+
+#include <stdint.h>
+#include "hx711_timing.h"
+
+// SCK phase hold of the specialized loops, fixed at build time
+#ifndef HX711_FAST_PULSE_NS
+#define HX711_FAST_PULSE_NS 500 // Datasheet minimum is 200 ns per SCK phase
+#endif
+
+#if HX711_FAST_PULSE_NS > 0
+#define HX711_FAST_HOLD() hx711_spin_delay_ns(HX711_FAST_PULSE_NS)
+#else
+#define HX711_FAST_HOLD() ((void)0) // Bus/register latency alone sets the pulse width
+#endif
+#define HX711_FAST_NO_HOLD() ((void)0)
+
+// Longest SCK-high phase of this thread's latest specialized read (hx711_timing.c)
+extern _Thread_local uint32_t hx711_fast_high_max_ns;
+
+// Times one SCK-high phase from before the rising write to after the falling write
+#define HX711_FAST_HIGH_END(t_rise)                                       \
+    do {                                                                 \
+        uint32_t high_ = (uint32_t)(hx711_time_ns() - (t_rise));         \
+        if (high_ > high_max) high_max = high_;                          \
+    } while (0)
+
+/**
+ * Defines `int name(uint8_t gain_pulses, uint32_t* raw)`.
+ *
+ * SCK_WRITE(level) drives PD_SCK, DOUT_READ() samples DOUT (1/0, negative on a
+ * transport error) and HOLD() waits one SCK phase. All three are expanded
+ * inline, so they should be macros or static inline functions visible at the
+ * point of definition. A failed bit still gets its clock pulse so the chip
+ * ends the train in step; the conversion is then dropped with -1.
+ */
+#define HX711_DEFINE_FAST_READ(name, SCK_WRITE, DOUT_READ, HOLD)          \
+    int name(uint8_t gain_pulses, uint32_t* raw) {                       \
+        uint32_t value = 0, high_max = 0;                                \
+        int failed = 0;                                                  \
+        _Pragma("GCC unroll 24")                                         \
+        for (int i = 0; i < 24; i++) {                                   \
+            uint64_t t_rise = hx711_time_ns();                           \
+            SCK_WRITE(1);                                                \
+            HOLD();                                                      \
+            int bit = DOUT_READ();                                       \
+            failed |= bit < 0;                                           \
+            value = (value << 1) | (bit > 0 ? 1u : 0u);                  \
+            SCK_WRITE(0);                                                \
+            HX711_FAST_HIGH_END(t_rise);                                 \
+            HOLD();                                                      \
+        }                                                                \
+        for (uint8_t i = 0; i < gain_pulses; i++) {                      \
+            uint64_t t_rise = hx711_time_ns();                           \
+            SCK_WRITE(1);                                                \
+            HOLD();                                                      \
+            SCK_WRITE(0);                                                \
+            HX711_FAST_HIGH_END(t_rise);                                 \
+            HOLD();                                                      \
+        }                                                                \
+        hx711_fast_high_max_ns = high_max;                               \
+        *raw = value;                                                    \
+        return failed ? -1 : 0;                                          \
+    }
+
+#endif /* HX711_FAST_H */
@@ -0,0 +1,246 @@
+/**
+ *
+ * Fixed-point filter pipeline for raw HX711 samples
+ *
+ */
+#include "hx711_filter.h"
+#include <string.h>
+#include <limits.h>
+
+#define ONE_Q8 (1 << HX711_FILTER_Q)
+#define KALMAN_GAIN_Q 16
+#define KALMAN_P_MAX (1ll << 46)  // Keeps (1 - K) * P inside 64 bits
+
+void hx711_filter_init(hx711_filter_chain_t* chain) {
+    memset(chain, 0, sizeof(*chain));
+}
+
+static hx711_filter_stage_t* add_stage(hx711_filter_chain_t* chain, hx711_filter_type_t type) {
+    if (chain->count >= HX711_FILTER_MAX_STAGES) return NULL;
+    hx711_filter_stage_t* st = &chain->stages[chain->count++];
+    memset(st, 0, sizeof(*st));
+    st->type = type;
+    return st;
+}
+
+static bool odd_window(int window) {
+    return window >= 3 && window <= HX711_FILTER_MAX_WINDOW && (window & 1);
+}
+
+int hx711_filter_add_median(hx711_filter_chain_t* chain, int window) {
+    if (!odd_window(window)) return -1;
+    hx711_filter_stage_t* st = add_stage(chain, HX711_FILTER_MEDIAN);
+    if (!st) return -1;
+    st->window = (uint8_t)window;
+    return 0;
+}
+
+int hx711_filter_add_hampel(hx711_filter_chain_t* chain, int window, float k) {
+    if (!odd_window(window) || k <= 0.0f) return -1;
+    hx711_filter_stage_t* st = add_stage(chain, HX711_FILTER_HAMPEL);
+    if (!st) return -1;
+    st->window = (uint8_t)window;
+    st->k_q8 = (int32_t)(k * 1.4826f * ONE_Q8 + 0.5f); // MAD -> sd for Gaussian noise
+    return 0;
+}
+
+int hx711_filter_add_moving_average(hx711_filter_chain_t* chain, int window) {
+    if (window < 1 || window > HX711_FILTER_MAX_WINDOW) return -1;
+    hx711_filter_stage_t* st = add_stage(chain, HX711_FILTER_MOVING_AVERAGE);
+    if (!st) return -1;
+    st->window = (uint8_t)window;
+    return 0;
+}
+
+int hx711_filter_add_iir(hx711_filter_chain_t* chain, int shift) {
+    if (shift < 1 || shift > 15) return -1;
+    hx711_filter_stage_t* st = add_stage(chain, HX711_FILTER_IIR);
+    if (!st) return -1;
+    st->shift = (uint8_t)shift;
+    return 0;
+}
+
+int hx711_filter_add_kalman(hx711_filter_chain_t* chain, float noise_counts, float drift_counts) {
+    if (noise_counts <= 0.0f || drift_counts < 0.0f) return -1;
+    hx711_filter_stage_t* st = add_stage(chain, HX711_FILTER_KALMAN);
+    if (!st) return -1;
+    st->r = (int64_t)(noise_counts * noise_counts) + 1;
+    st->q = (int64_t)(drift_counts * drift_counts);
+    return 0;
+}
+
+int hx711_filter_add_named(hx711_filter_chain_t* chain, const char* type,
+                           int window, float k, int shift, float noise, float drift) {
+    if (strcmp(type, "median") == 0) return hx711_filter_add_median(chain, window);
+    if (strcmp(type, "hampel") == 0) return hx711_filter_add_hampel(chain, window, k);
+    if (strcmp(type, "moving_average") == 0) return hx711_filter_add_moving_average(chain, window);
+    if (strcmp(type, "iir") == 0) return hx711_filter_add_iir(chain, shift);
+    if (strcmp(type, "kalman") == 0) return hx711_filter_add_kalman(chain, noise, drift);
+    return -1;
+}
+
+void hx711_filter_reset(hx711_filter_chain_t* chain) {
+    for (int i = 0; i < chain->count; i++) {
+        hx711_filter_stage_t* st = &chain->stages[i];
+        st->count = 0;
+        st->pos = 0;
+        st->sum = 0;
+        st->state = 0;
+        st->p = 0;
+        st->primed = false;
+    }
+    chain->out = 0;
+    chain->primed = false;
+}
+
+// --- Stages ---
+
+static void window_put(hx711_filter_stage_t* st, int32_t x) {
+    st->buf[st->pos] = x;
+    st->pos = (uint8_t)((st->pos + 1) % st->window);
+    if (st->count < st->window) st->count++;
+}
+
+// First index in v[0..n) holding a value >= x
+static int lower_bound(const int32_t* v, int n, int32_t x) {
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (v[mid] < x) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+// Ring buffer plus sorted copy: the sample leaving the window is removed and
+// the new one inserted with one memmove each, O(window) instead of a sort
+static void sorted_put(hx711_filter_stage_t* st, int32_t x) {
+    int n = st->count;
+
+    if (n == st->window) {
+        int out = lower_bound(st->sorted, n, st->buf[st->pos]);
+        memmove(&st->sorted[out], &st->sorted[out + 1], (size_t)(n - 1 - out) * sizeof(int32_t));
+        n--;
+    }
+    int at = lower_bound(st->sorted, n, x);
+    memmove(&st->sorted[at + 1], &st->sorted[at], (size_t)(n - at) * sizeof(int32_t));
+    st->sorted[at] = x;
+    window_put(st, x);
+}
+
+static int32_t mid_of(int32_t lo, int32_t hi) {
+    return (int32_t)(((int64_t)lo + hi) / 2);
+}
+
+static int32_t sorted_median(const hx711_filter_stage_t* st) {
+    int n = st->count;
+    return (n & 1) ? st->sorted[n / 2] : mid_of(st->sorted[n / 2 - 1], st->sorted[n / 2]);
+}
+
+// |a - b| without int32 overflow, saturated to INT32_MAX
+static int32_t abs_diff(int32_t a, int32_t b) {
+    int64_t d = (int64_t)a - b;
+    if (d < 0) d = -d;
+    return d > INT32_MAX ? INT32_MAX : (int32_t)d;
+}
+
+// Median absolute deviation of the sorted window from med. Distances grow
+// outward from med on both sides, so merging the two runs yields them in
+// order and the middle one is reached after n / 2 steps.
+static int32_t sorted_mad(const hx711_filter_stage_t* st, int32_t med) {
+    const int32_t* v = st->sorted;
+    int n = st->count;
+    int right = lower_bound(v, n, med), left = right - 1;
+    int32_t prev = 0, cur = 0;
+
+    for (int i = 0; i <= n / 2; i++) {
+        prev = cur;
+        if (left < 0 || (right < n && abs_diff(v[right], med) < abs_diff(med, v[left]))) {
+            cur = abs_diff(v[right++], med);
+        } else {
+            cur = abs_diff(med, v[left--]);
+        }
+    }
+    return (n & 1) ? cur : mid_of(prev, cur);
+}
+
+static int32_t stage_median(hx711_filter_stage_t* st, int32_t x) {
+    sorted_put(st, x);
+    return sorted_median(st);
+}
+
+static int32_t stage_hampel(hx711_filter_stage_t* st, int32_t x) {
+    sorted_put(st, x);
+    if (st->count < 3) return x;
+
+    int32_t med = sorted_median(st);
+    int64_t mad = sorted_mad(st, med);
+
+    // Flat window (MAD 0): anything off the median by more than one count is an outlier
+    int64_t limit = mad ? (mad * st->k_q8) >> HX711_FILTER_Q : ONE_Q8;
+    return abs_diff(x, med) > limit ? med : x;
+}
+
+static int32_t stage_moving_average(hx711_filter_stage_t* st, int32_t x) {
+    if (st->count == st->window) st->sum -= st->buf[st->pos];
+    st->sum += x;
+    window_put(st, x);
+    return (int32_t)(st->sum / st->count);
+}
+
+static int32_t stage_iir(hx711_filter_stage_t* st, int32_t x) {
+    if (!st->primed) {
+        st->state = x;
+        st->primed = true;
+    } else {
+        st->state += (int32_t)(((int64_t)x - st->state) >> st->shift);
+    }
+    return st->state;
+}
+
+static int32_t stage_kalman(hx711_filter_stage_t* st, int32_t x) {
+    if (!st->primed) {
+        st->state = x;
+        st->p = st->r;
+        st->primed = true;
+        return x;
+    }
+
+    int64_t e = (int64_t)x - st->state;       // Q8
+    int64_t e_counts = e >> HX711_FILTER_Q;
+    int64_t e_sq = e_counts * e_counts;
+
+    st->p += st->q;
+    // Innovation beyond 3 sd of its expected spread: the load moved, reopen the gain
+    if (e_sq > 9 * (st->p + st->r)) st->p += e_sq;
+    if (st->p > KALMAN_P_MAX) st->p = KALMAN_P_MAX;
+
+    int64_t gain = (st->p << KALMAN_GAIN_Q) / (st->p + st->r);   // Q16, 0..1
+    st->state += (int32_t)((gain * e) >> KALMAN_GAIN_Q);
+    st->p = (((1ll << KALMAN_GAIN_Q) - gain) * st->p) >> KALMAN_GAIN_Q;
+    return st->state;
+}
+
+long hx711_filter_push(hx711_filter_chain_t* chain, long raw) {
+    int32_t x = (int32_t)((uint32_t)raw << HX711_FILTER_Q);
+
+    for (int i = 0; i < chain->count; i++) {
+        hx711_filter_stage_t* st = &chain->stages[i];
+        switch (st->type) {
+            case HX711_FILTER_MEDIAN:         x = stage_median(st, x); break;
+            case HX711_FILTER_HAMPEL:         x = stage_hampel(st, x); break;
+            case HX711_FILTER_MOVING_AVERAGE: x = stage_moving_average(st, x); break;
+            case HX711_FILTER_IIR:            x = stage_iir(st, x); break;
+            case HX711_FILTER_KALMAN:         x = stage_kalman(st, x); break;
+        }
+    }
+    chain->out = x;
+    chain->primed = true;
+    return hx711_filter_value(chain);
+}
+
+long hx711_filter_value(const hx711_filter_chain_t* chain) {
+    // Round half away from zero back to raw counts
+    int32_t half = ONE_Q8 / 2;
+    return chain->out >= 0 ? (long)((chain->out + half) >> HX711_FILTER_Q)
+                           : -(long)((-(int64_t)chain->out + half) >> HX711_FILTER_Q);
+}
@@ -0,0 +1,144 @@
+/**
+ *
+ * Fixed-point filter pipeline for raw HX711 samples
+ *
+ * A chain of up to HX711_FILTER_MAX_STAGES stages, fed one conversion at a
+ * time from the sample stream. Values travel between stages as Q8 raw
+ * counts in an int32_t (24-bit reading << 8). Every stage works in fixed
+ * point with bounded per-sample cost and state held inline, so pushing a
+ * sample never allocates.
+ *
+ *   median          running median over `window` samples, O(window) per sample
+ *   hampel          replaces outliers (> k * 1.4826 * MAD from the median)
+ *   moving_average  box average over `window` samples, running 64-bit sum
+ *   iir             single pole, y += (x - y) >> shift
+ *   kalman          1-D constant-value filter that reopens its gain on steps
+ *
+ */
+#ifndef HX711_FILTER_H
+#define HX711_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HX711_FILTER_MAX_STAGES 8
+#define HX711_FILTER_MAX_WINDOW 32
+#define HX711_FILTER_Q 8  // Fractional bits of the values passed between stages
+
+typedef enum {
+    HX711_FILTER_MEDIAN,
+    HX711_FILTER_HAMPEL,
+    HX711_FILTER_MOVING_AVERAGE,
+    HX711_FILTER_IIR,
+    HX711_FILTER_KALMAN,
+} hx711_filter_type_t;
+
+typedef struct {
+    hx711_filter_type_t type;
+    uint8_t window;        // median, hampel, moving_average
+    uint8_t count;         // Samples in the window so far
+    uint8_t pos;           // Next slot to overwrite
+    int32_t buf[HX711_FILTER_MAX_WINDOW];
+    int32_t sorted[HX711_FILTER_MAX_WINDOW]; // median, hampel: the window in ascending order
+    int64_t sum;           // moving_average
+    int32_t k_q8;          // hampel threshold in MADs, Q8, with the 1.4826 factor folded in
+    uint8_t shift;         // iir
+    int32_t state;         // iir / kalman estimate
+    int64_t p;             // kalman estimate variance (counts^2)
+    int64_t q;             // kalman process noise (counts^2 per sample)
+    int64_t r;             // kalman measurement noise (counts^2)
+    bool primed;
+} hx711_filter_stage_t;
+
+typedef struct {
+    int count;
+    hx711_filter_stage_t stages[HX711_FILTER_MAX_STAGES];
+    int32_t out;           // Last output, Q8
+    bool primed;
+} hx711_filter_chain_t;
+
+/**
+ * @brief Initializes an empty chain (an empty chain passes samples through).
+ * @param chain Pointer to the chain.
+ */
+void hx711_filter_init(hx711_filter_chain_t* chain);
+
+/**
+ * @brief Appends a running-median stage.
+ * @param chain Pointer to the chain.
+ * @param window Samples in the window (odd, 3..HX711_FILTER_MAX_WINDOW).
+ * @return 0 on success, -1 if the chain is full or the window is invalid.
+ */
+int hx711_filter_add_median(hx711_filter_chain_t* chain, int window);
+
+/**
+ * @brief Appends a Hampel outlier-rejection stage.
+ * @param chain Pointer to the chain.
+ * @param window Samples in the window (odd, 3..HX711_FILTER_MAX_WINDOW).
+ * @param k Threshold in scaled MADs (3 is the usual choice).
+ * @return 0 on success, -1 if the chain is full or a parameter is invalid.
+ */
+int hx711_filter_add_hampel(hx711_filter_chain_t* chain, int window, float k);
+
+/**
+ * @brief Appends a moving-average stage.
+ * @param chain Pointer to the chain.
+ * @param window Samples in the window (1..HX711_FILTER_MAX_WINDOW).
+ * @return 0 on success, -1 if the chain is full or the window is invalid.
+ */
+int hx711_filter_add_moving_average(hx711_filter_chain_t* chain, int window);
+
+/**
+ * @brief Appends a single-pole IIR stage with coefficient 2^-shift.
+ * @param chain Pointer to the chain.
+ * @param shift 1..15; the time constant is about 2^shift samples.
+ * @return 0 on success, -1 if the chain is full or the shift is invalid.
+ */
+int hx711_filter_add_iir(hx711_filter_chain_t* chain, int shift);
+
+/**
+ * @brief Appends an adaptive Kalman stage.
+ *
+ * Innovations beyond three standard deviations are taken as a load change;
+ * the gain then reopens so the estimate follows the step at once.
+ *
+ * @param chain Pointer to the chain.
+ * @param noise_counts Measurement noise standard deviation in raw counts.
+ * @param drift_counts Expected change per sample (process noise sd) in raw counts.
+ * @return 0 on success, -1 if the chain is full or a parameter is invalid.
+ */
+int hx711_filter_add_kalman(hx711_filter_chain_t* chain, float noise_counts, float drift_counts);
+
+/**
+ * @brief Adds a stage by its name ("median", "hampel", "moving_average", "iir", "kalman").
+ *
+ * Parameters by type: median/moving_average use `window`; hampel uses `window`
+ * and `k`; iir uses `shift`; kalman uses `noise` and `drift`.
+ *
+ * @return 0 on success, -1 for an unknown name or invalid parameters.
+ */
+int hx711_filter_add_named(hx711_filter_chain_t* chain, const char* type,
+                           int window, float k, int shift, float noise, float drift);
+
+/**
+ * @brief Clears the state of every stage; the configuration is kept.
+ * @param chain Pointer to the chain.
+ */
+void hx711_filter_reset(hx711_filter_chain_t* chain);
+
+/**
+ * @brief Runs one conversion through the chain.
+ * @param chain Pointer to the chain.
+ * @param raw Raw 24-bit reading.
+ * @return The filtered value, rounded to raw counts.
+ */
+long hx711_filter_push(hx711_filter_chain_t* chain, long raw);
+
+/**
+ * @brief Last output of the chain.
+ * @param chain Pointer to the chain.
+ * @return The filtered value in raw counts, or 0 before the first sample.
+ */
+long hx711_filter_value(const hx711_filter_chain_t* chain);
+
+#endif /* HX711_FILTER_H */
@@ -0,0 +1,189 @@
+/**
+ *
+ * libgpiod (v1) backend for the HX711 library
+ *
+ */
+#include "hx711_gpiod.h"
+#include "hx711_timing.h"
+#include "hx711_fast.h"
+#include <gpiod.h>
+#include <stdio.h>
+#include <time.h>
+
+#define EVENT_BATCH 16
+
+static struct gpiod_chip* chip;
+static struct gpiod_line* dout_line;
+static struct gpiod_line* sck_line;
+static bool edge_events;
+
+int hx711_gpiod_open(const char* chipname, int dout_pin, int sck_pin, bool edge_wait) {
+    chip = gpiod_chip_open_by_name(chipname);
+    if (!chip) return -1;
+
+    dout_line = gpiod_chip_get_line(chip, dout_pin);
+    sck_line = sck_pin >= 0 ? gpiod_chip_get_line(chip, sck_pin) : NULL;
+    if (!dout_line || (sck_pin >= 0 && !sck_line)) goto fail;
+
+    if (sck_line && gpiod_line_request_output(sck_line, "hx711_sck", 0) < 0) goto fail;
+
+    edge_events = false;
+    if (edge_wait) {
+        if (gpiod_line_request_falling_edge_events(dout_line, "hx711_dout") == 0) {
+            edge_events = true;
+        } else {
+            perror("HX711 DOUT edge events unavailable, polling instead");
+        }
+    }
+    if (!edge_events && gpiod_line_request_input(dout_line, "hx711_dout") < 0) goto fail;
+    return 0;
+
+fail:
+    gpiod_chip_close(chip);
+    chip = NULL;
+    return -1;
+}
+
+void hx711_gpiod_close(void) {
+    if (!chip) return;
+    gpiod_line_release(dout_line);
+    if (sck_line) gpiod_line_release(sck_line);
+    gpiod_chip_close(chip);
+    chip = NULL;
+}
+
+bool hx711_gpiod_has_events(void) {
+    return edge_events;
+}
+
+void hx711_gpiod_write(int pin, int value) {
+    (void)pin;
+    gpiod_line_set_value(sck_line, value);
+}
+
+int hx711_gpiod_read(int pin) {
+    (void)pin;
+    return gpiod_line_get_value(dout_line);
+}
+
+// Specialized clock-out: the line accessors are called directly, not through hx711_t
+#define GPIOD_SCK(level) gpiod_line_set_value(sck_line, (level))
+#define GPIOD_DOUT() gpiod_line_get_value(dout_line)
+HX711_DEFINE_FAST_READ(hx711_gpiod_read_sample, GPIOD_SCK, GPIOD_DOUT, HX711_FAST_HOLD)
+
+// --- RATE pin ---
+
+static struct gpiod_chip* rate_chip;
+static struct gpiod_line* rate_line;
+
+int hx711_gpiod_open_rate(const char* chipname, int rate_pin, int level) {
+    rate_chip = gpiod_chip_open_by_name(chipname);
+    if (!rate_chip) return -1;
+
+    rate_line = gpiod_chip_get_line(rate_chip, (unsigned int)rate_pin);
+    if (!rate_line || gpiod_line_request_output(rate_line, "hx711_rate", level) < 0) {
+        gpiod_chip_close(rate_chip);
+        rate_chip = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void hx711_gpiod_close_rate(void) {
+    if (!rate_chip) return;
+    gpiod_line_release(rate_line);
+    gpiod_chip_close(rate_chip);
+    rate_chip = NULL;
+}
+
+void hx711_gpiod_write_rate(int pin, int value) {
+    (void)pin;
+    gpiod_line_set_value(rate_line, value);
+}
+
+// --- Shared-clock group (hx711_multi) ---
+
+static struct gpiod_chip* bulk_chip;
+static struct gpiod_line_bulk bulk_dout;
+static struct gpiod_line* bulk_sck;
+
+int hx711_gpiod_open_bulk(const char* chipname, const int* dout_pins, int count, int sck_pin) {
+    unsigned int offsets[GPIOD_LINE_BULK_MAX_LINES];
+
+    if (count < 1 || count > 32 || count > GPIOD_LINE_BULK_MAX_LINES) return -1;
+    for (int i = 0; i < count; i++) offsets[i] = (unsigned int)dout_pins[i];
+
+    bulk_chip = gpiod_chip_open_by_name(chipname);
+    if (!bulk_chip) return -1;
+
+    bulk_sck = gpiod_chip_get_line(bulk_chip, (unsigned int)sck_pin);
+    if (!bulk_sck || gpiod_line_request_output(bulk_sck, "hx711_sck", 0) < 0) goto fail;
+    if (gpiod_chip_get_lines(bulk_chip, offsets, (unsigned int)count, &bulk_dout) < 0) goto fail;
+    if (gpiod_line_request_bulk_input(&bulk_dout, "hx711_dout") < 0) goto fail;
+    return 0;
+
+fail:
+    gpiod_chip_close(bulk_chip);
+    bulk_chip = NULL;
+    return -1;
+}
+
+void hx711_gpiod_close_bulk(void) {
+    if (!bulk_chip) return;
+    gpiod_line_release_bulk(&bulk_dout);
+    gpiod_line_release(bulk_sck);
+    gpiod_chip_close(bulk_chip);
+    bulk_chip = NULL;
+}
+
+void hx711_gpiod_write_bulk_sck(int pin, int value) {
+    (void)pin;
+    gpiod_line_set_value(bulk_sck, value);
+}
+
+int hx711_gpiod_read_bulk(uint32_t* bits) {
+    int values[GPIOD_LINE_BULK_MAX_LINES];
+    uint32_t levels = 0;
+
+    // One ioctl samples every DOUT line
+    if (gpiod_line_get_value_bulk(&bulk_dout, values) < 0) return -1;
+    for (unsigned int i = 0; i < bulk_dout.num_lines; i++) {
+        if (values[i]) levels |= 1u << i;
+    }
+    *bits = levels;
+    return 0;
+}
+
+static uint64_t event_ns(const struct gpiod_line_event* ev) {
+    return (uint64_t)ev->ts.tv_sec * 1000000000ull + (uint64_t)ev->ts.tv_nsec;
+}
+
+int hx711_gpiod_wait_ready(int pin, int timeout_ms, uint64_t* ready_ns) {
+    (void)pin;
+    struct gpiod_line_event events[EVENT_BATCH];
+    struct timespec zero = { 0, 0 };
+
+    if (!edge_events) return -1;
+
+    // The data bits of the last clock-out also produced falling edges
+    while (gpiod_line_event_wait(dout_line, &zero) == 1) {
+        if (gpiod_line_event_read_multiple(dout_line, events, EVENT_BATCH) < 0) return -1;
+    }
+
+    // The conversion may already have finished while we were busy
+    if (gpiod_line_get_value(dout_line) == 0) {
+        *ready_ns = hx711_time_ns();
+        return 1;
+    }
+
+    struct timespec timeout = { timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000L };
+    int ret = gpiod_line_event_wait(dout_line, &timeout);
+    if (ret <= 0) return ret;
+
+    struct gpiod_line_event ev;
+    if (gpiod_line_event_read(dout_line, &ev) < 0) return -1;
+
+    // Kernel timestamp; CLOCK_MONOTONIC on kernels >= 5.7
+    *ready_ns = event_ns(&ev);
+    return 1;
+}
@@ -0,0 +1,130 @@
+/**
+ *
+ * libgpiod (v1) backend for the HX711 library
+ *
+ * Owns the DOUT and PD_SCK lines of one chip. The functions match the
+ * hx711_t function pointer types, so they plug straight into hx711_init().
+ *
+ */
+#ifndef HX711_GPIOD_H
+#define HX711_GPIOD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Requests the DOUT and PD_SCK lines.
+ *
+ * With edge_wait, DOUT is requested for falling-edge events so that
+ * hx711_gpiod_wait_ready() can sleep on the event fd. If the kernel refuses
+ * (no IRQ on that pin) DOUT falls back to a plain input and
+ * hx711_gpiod_has_events() reports false.
+ *
+ * @param chipname GPIO chip name, e.g. "gpiochip2".
+ * @param dout_pin Line offset of DOUT.
+ * @param sck_pin Line offset of PD_SCK, or -1 when a transport (spidev) owns the clock.
+ * @param edge_wait True to request DOUT falling-edge events.
+ * @return 0 on success, -1 on failure.
+ */
+int hx711_gpiod_open(const char* chipname, int dout_pin, int sck_pin, bool edge_wait);
+
+/**
+ * @brief Releases the lines and closes the chip.
+ */
+void hx711_gpiod_close(void);
+
+/**
+ * @brief True if DOUT was requested for edge events.
+ * @return True if hx711_gpiod_wait_ready() can be used.
+ */
+bool hx711_gpiod_has_events(void);
+
+/**
+ * @brief Drives PD_SCK. Matches gpio_write_func.
+ * @param pin Ignored; the line was bound in hx711_gpiod_open().
+ * @param value Level to drive.
+ */
+void hx711_gpiod_write(int pin, int value);
+
+/**
+ * @brief Samples DOUT. Matches gpio_read_func.
+ * @param pin Ignored; the line was bound in hx711_gpiod_open().
+ * @return Line level.
+ */
+int hx711_gpiod_read(int pin);
+
+/**
+ * @brief Specialized bit-bang clock-out (hx711_fast.h). Matches read_sample_func.
+ *
+ * Use with hx711_backend_t.read_sample_rt set; SCK holds are HX711_FAST_PULSE_NS.
+ *
+ * @param gain_pulses Extra pulses selecting the next channel/gain (1..3).
+ * @param raw Receives the 24 data bits, MSB first.
+ * @return 0.
+ */
+int hx711_gpiod_read_sample(uint8_t gain_pulses, uint32_t* raw);
+
+/**
+ * @brief Sleeps on the DOUT event fd until data is ready. Matches wait_ready_func.
+ *
+ * Edges left over from the previous clock-out are discarded first; if DOUT is
+ * already low the call returns immediately with the current time.
+ *
+ * @param pin Ignored; the line was bound in hx711_gpiod_open().
+ * @param timeout_ms Maximum time to sleep.
+ * @param ready_ns Receives the kernel timestamp of the falling edge.
+ * @return 1 when ready, 0 on timeout, -1 on error.
+ */
+int hx711_gpiod_wait_ready(int pin, int timeout_ms, uint64_t* ready_ns);
+
+/**
+ * @brief Requests the RATE line as an output (high = 80 SPS, low = 10 SPS).
+ * @param chipname GPIO chip name, e.g. "gpiochip2".
+ * @param rate_pin Line offset of RATE.
+ * @param level Initial level.
+ * @return 0 on success, -1 on failure.
+ */
+int hx711_gpiod_open_rate(const char* chipname, int rate_pin, int level);
+
+/**
+ * @brief Releases the RATE line.
+ */
+void hx711_gpiod_close_rate(void);
+
+/**
+ * @brief Drives RATE. Matches gpio_write_func.
+ * @param pin Ignored; the line was bound in hx711_gpiod_open_rate().
+ * @param value 1 for 80 SPS, 0 for 10 SPS.
+ */
+void hx711_gpiod_write_rate(int pin, int value);
+
+/**
+ * @brief Requests a shared PD_SCK line and several DOUT lines as one bulk (hx711_multi).
+ * @param chipname GPIO chip name, e.g. "gpiochip2".
+ * @param dout_pins Line offsets of the DOUT lines, in channel order.
+ * @param count Number of DOUT lines.
+ * @param sck_pin Line offset of the shared PD_SCK.
+ * @return 0 on success, -1 on failure.
+ */
+int hx711_gpiod_open_bulk(const char* chipname, const int* dout_pins, int count, int sck_pin);
+
+/**
+ * @brief Releases the bulk lines and closes their chip.
+ */
+void hx711_gpiod_close_bulk(void);
+
+/**
+ * @brief Drives the shared PD_SCK. Matches gpio_write_func.
+ * @param pin Ignored; the line was bound in hx711_gpiod_open_bulk().
+ * @param value Level to drive.
+ */
+void hx711_gpiod_write_bulk_sck(int pin, int value);
+
+/**
+ * @brief Samples every DOUT line in one ioctl. Matches gpio_read_bulk_func.
+ * @param bits Receives bit i = level on DOUT line i.
+ * @return 0 on success, -1 if the ioctl failed.
+ */
+int hx711_gpiod_read_bulk(uint32_t* bits);
+
+#endif /* HX711_GPIOD_H */
@@ -0,0 +1,303 @@
+/**
+ *
+ * Linux IIO backend for the HX711 library
+ *
+ */
+#include "hx711_iio.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define IIO_BATCH 32
+#define IIO_MAX_RECORD 32
+
+// Layout of one scan element inside a buffer record
+typedef struct {
+    int index;
+    unsigned int offset;     // Byte offset in the record
+    unsigned int bytes;      // Storage bytes
+    unsigned int realbits;
+    unsigned int shift;
+    bool is_signed;
+    bool big_endian;
+} scan_elem_t;
+
+static char dev_dir[256];
+static int iio_fd = -1;
+static scan_elem_t volt;
+static scan_elem_t stamp;
+static unsigned int record_size;
+
+static uint8_t batch[IIO_BATCH * IIO_MAX_RECORD];
+static unsigned int batch_count;
+static unsigned int batch_pos;
+static bool pending;
+
+// --- sysfs helpers ---
+
+static int sysfs_write(const char* rel, const char* value) {
+    char path[384];
+    snprintf(path, sizeof(path), "%s/%s", dev_dir, rel);
+    FILE* fp = fopen(path, "w");
+    if (!fp) return -1;
+    int ret = fputs(value, fp) < 0 ? -1 : 0;
+    if (fclose(fp) != 0) ret = -1;
+    return ret;
+}
+
+static int sysfs_read(const char* rel, char* buf, size_t len) {
+    char path[384];
+    snprintf(path, sizeof(path), "%s/%s", dev_dir, rel);
+    FILE* fp = fopen(path, "r");
+    if (!fp) return -1;
+    if (!fgets(buf, (int)len, fp)) {
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
+// Enables one scan element and reads back its index and "le:s24/32>>0" type
+static int scan_elem_setup(const char* name, scan_elem_t* el) {
+    char rel[128], buf[64];
+    char endian[3], sign;
+
+    snprintf(rel, sizeof(rel), "scan_elements/%s_en", name);
+    if (sysfs_write(rel, "1") != 0) return -1;
+
+    snprintf(rel, sizeof(rel), "scan_elements/%s_index", name);
+    if (sysfs_read(rel, buf, sizeof(buf)) != 0) return -1;
+    el->index = atoi(buf);
+
+    snprintf(rel, sizeof(rel), "scan_elements/%s_type", name);
+    if (sysfs_read(rel, buf, sizeof(buf)) != 0) return -1;
+
+    unsigned int storage;
+    if (sscanf(buf, "%2[bl]e:%c%u/%u>>%u", endian, &sign, &el->realbits, &storage, &el->shift) != 5) {
+        return -1;
+    }
+    el->is_signed = sign == 's';
+    el->big_endian = endian[0] == 'b';
+    el->bytes = storage / 8;
+    return el->bytes == 0 || el->bytes > 8 ? -1 : 0;
+}
+
+// Elements appear in index order, each aligned to its own storage size
+static void layout_record(void) {
+    scan_elem_t* order[2] = { &volt, &stamp };
+    if (stamp.index < volt.index) {
+        order[0] = &stamp;
+        order[1] = &volt;
+    }
+
+    unsigned int off = 0, align = 1;
+    for (int i = 0; i < 2; i++) {
+        unsigned int b = order[i]->bytes;
+        off = (off + b - 1) / b * b;
+        order[i]->offset = off;
+        off += b;
+        if (b > align) align = b;
+    }
+    record_size = (off + align - 1) / align * align;
+}
+
+static uint64_t elem_raw(const uint8_t* rec, const scan_elem_t* el) {
+    uint64_t v = 0;
+    for (unsigned int i = 0; i < el->bytes; i++) {
+        unsigned int k = el->big_endian ? i : el->bytes - 1 - i;
+        v = (v << 8) | rec[el->offset + k];
+    }
+    v >>= el->shift;
+    if (el->realbits < 64) v &= (1ull << el->realbits) - 1;
+    return v;
+}
+
+int hx711_iio_open(const hx711_iio_config_t* cfg) {
+    const char* sysfs_root = cfg->sysfs_root ? cfg->sysfs_root : HX711_IIO_SYSFS_ROOT;
+    const char* dev_root = cfg->dev_root ? cfg->dev_root : HX711_IIO_DEV_ROOT;
+    char path[256], buf[32];
+
+    snprintf(dev_dir, sizeof(dev_dir), "%s/iio:device%d", sysfs_root, cfg->device);
+
+    // The buffer must be off while it is being configured
+    sysfs_write("buffer/enable", "0");
+
+    // Only one channel per record; the other may still be enabled from a previous user
+    snprintf(buf, sizeof(buf), "scan_elements/in_voltage%d_en", !cfg->channel);
+    sysfs_write(buf, "0");
+
+    snprintf(buf, sizeof(buf), "in_voltage%d", cfg->channel);
+    if (scan_elem_setup(buf, &volt) != 0 || scan_elem_setup("in_timestamp", &stamp) != 0) {
+        fprintf(stderr, "HX711 IIO: scan elements not usable in %s\n", dev_dir);
+        return -1;
+    }
+    layout_record();
+    if (record_size > IIO_MAX_RECORD) return -1;
+
+    // Timestamps on the same clock as the rest of the sample stream
+    sysfs_write("current_timestamp_clock", "monotonic");
+
+    if (cfg->trigger && sysfs_write("trigger/current_trigger", cfg->trigger) != 0) {
+        fprintf(stderr, "HX711 IIO: cannot select trigger %s\n", cfg->trigger);
+        return -1;
+    }
+    if (cfg->buffer_length) {
+        snprintf(buf, sizeof(buf), "%u", cfg->buffer_length);
+        sysfs_write("buffer/length", buf);
+    }
+    if (sysfs_write("buffer/enable", "1") != 0) return -1;
+
+    snprintf(path, sizeof(path), "%s/iio:device%d", dev_root, cfg->device);
+    iio_fd = open(path, O_RDONLY | O_NONBLOCK);
+    if (iio_fd < 0) {
+        perror("HX711 IIO open");
+        sysfs_write("buffer/enable", "0");
+        return -1;
+    }
+
+    batch_count = batch_pos = 0;
+    pending = false;
+    return 0;
+}
+
+void hx711_iio_close(void) {
+    if (iio_fd < 0) return;
+    close(iio_fd);
+    iio_fd = -1;
+    sysfs_write("buffer/enable", "0");
+}
+
+int hx711_iio_wait_ready(int pin, int timeout_ms, uint64_t* ready_ns) {
+    (void)pin;
+    if (iio_fd < 0) return -1;
+
+    if (batch_pos >= batch_count) {
+        struct pollfd pfd = { .fd = iio_fd, .events = POLLIN };
+        int ret = poll(&pfd, 1, timeout_ms);
+        if (ret <= 0) return ret < 0 && errno != EINTR ? -1 : 0;
+
+        ssize_t n = read(iio_fd, batch, sizeof(batch) / record_size * record_size);
+        if (n < 0) return errno == EAGAIN ? 0 : -1;
+        if ((size_t)n < record_size) {
+            // A file stand-in at its end behaves like an idle device
+            if (timeout_ms > 0) usleep((useconds_t)timeout_ms * 1000);
+            return 0;
+        }
+        batch_count = (unsigned int)((size_t)n / record_size);
+        batch_pos = 0;
+    }
+
+    *ready_ns = elem_raw(&batch[batch_pos * record_size], &stamp);
+    pending = true;
+    return 1;
+}
+
+int hx711_iio_read_sample(uint8_t gain_pulses, uint32_t* raw) {
+    (void)gain_pulses;
+    if (!pending) return -1;
+
+    uint32_t v = (uint32_t)elem_raw(&batch[batch_pos * record_size], &volt);
+    batch_pos++;
+    pending = false;
+
+    // The driver reports offset binary (sign 'u'); undo it for 24-bit two's complement
+    if (!volt.is_signed && volt.realbits == 24) v ^= 0x800000;
+    *raw = v & 0xFFFFFF;
+    return 0;
+}
+
+int hx711_iio_ready(int pin) {
+    (void)pin;
+    return batch_pos < batch_count ? 0 : 1;
+}
+
+// --- File-backed stand-in ---
+
+// Attribute values as the mainline driver exposes them
+static const struct {
+    const char* rel;
+    const char* value;
+} standin_attrs[] = {
+    { "scan_elements/in_voltage0_en", "0" },
+    { "scan_elements/in_voltage0_index", "0" },
+    { "scan_elements/in_voltage0_type", "le:u24/32>>0" },
+    { "scan_elements/in_voltage1_en", "0" },
+    { "scan_elements/in_voltage1_index", "1" },
+    { "scan_elements/in_voltage1_type", "le:u24/32>>0" },
+    { "scan_elements/in_timestamp_en", "0" },
+    { "scan_elements/in_timestamp_index", "2" },
+    { "scan_elements/in_timestamp_type", "le:s64/64>>0" },
+    { "buffer/enable", "0" },
+    { "buffer/length", "64" },
+    { "trigger/current_trigger", "" },
+    { "current_timestamp_clock", "realtime" },
+};
+
+static int standin_file(const char* path, const char* value, const char* mode) {
+    FILE* fp = fopen(path, mode);
+    if (!fp) return -1;
+    fprintf(fp, "%s\n", value);
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+int hx711_iio_standin_create(const char* root, int device, hx711_iio_config_t* cfg) {
+    static const char* dirs[] = { "", "/sys", "/dev" };
+    static const char* subdirs[] = { "", "/scan_elements", "/buffer", "/trigger" };
+    static char sysfs_root[256], dev_root[256];
+    char path[384];
+
+    for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+        snprintf(path, sizeof(path), "%s%s", root, dirs[i]);
+        if (mkdir(path, 0755) != 0 && errno != EEXIST) return -1;
+    }
+    for (size_t i = 0; i < sizeof(subdirs) / sizeof(subdirs[0]); i++) {
+        snprintf(path, sizeof(path), "%s/sys/iio:device%d%s", root, device, subdirs[i]);
+        if (mkdir(path, 0755) != 0 && errno != EEXIST) return -1;
+    }
+    for (size_t i = 0; i < sizeof(standin_attrs) / sizeof(standin_attrs[0]); i++) {
+        snprintf(path, sizeof(path), "%s/sys/iio:device%d/%s", root, device, standin_attrs[i].rel);
+        if (standin_file(path, standin_attrs[i].value, "w") != 0) return -1;
+    }
+
+    // The chardev is a regular file of records, empty until samples are appended
+    snprintf(path, sizeof(path), "%s/dev/iio:device%d", root, device);
+    FILE* fp = fopen(path, "w");
+    if (!fp) return -1;
+    fclose(fp);
+
+    if (cfg) {
+        snprintf(sysfs_root, sizeof(sysfs_root), "%s/sys", root);
+        snprintf(dev_root, sizeof(dev_root), "%s/dev", root);
+        memset(cfg, 0, sizeof(*cfg));
+        cfg->sysfs_root = sysfs_root;
+        cfg->dev_root = dev_root;
+        cfg->device = device;
+    }
+    return 0;
+}
+
+int hx711_iio_standin_append(const char* root, int device, long value, uint64_t timestamp_ns) {
+    char path[384];
+    uint8_t rec[16];
+
+    // Default layout: u24 offset binary in a le32 slot, then the le64 timestamp
+    uint32_t v = ((uint32_t)value & 0xFFFFFF) ^ 0x800000;
+    memset(rec, 0, sizeof(rec));
+    for (int i = 0; i < 4; i++) rec[i] = (uint8_t)(v >> (8 * i));
+    for (int i = 0; i < 8; i++) rec[8 + i] = (uint8_t)(timestamp_ns >> (8 * i));
+
+    snprintf(path, sizeof(path), "%s/dev/iio:device%d", root, device);
+    FILE* fp = fopen(path, "ab");
+    if (!fp) return -1;
+    size_t n = fwrite(rec, sizeof(rec), 1, fp);
+    if (fclose(fp) != 0 || n != 1) return -1;
+    return 0;
+}
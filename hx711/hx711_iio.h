@@ -0,0 +1,111 @@
+/**
+ *
+ * Linux IIO backend for the HX711 library
+ *
+ * Uses the mainline hx711 IIO driver with a triggered buffer, so the clock
+ * train is generated in the kernel and user space only reads timestamped
+ * records from /dev/iio:deviceN, several at a time. Plugs into hx711_t as a
+ * wait_ready/read_sample pair, so hx711_read_average(), hx711_get_units()
+ * and the acquisition engine work unchanged.
+ *
+ * The sysfs and /dev roots are configurable. A directory with the same
+ * layout (plain files for the attributes, a regular file of records for the
+ * chardev) works as a stand-in for the kernel; hx711_iio_standin_create()
+ * builds one:
+ *
+ *   <sysfs_root>/iio:deviceN/scan_elements/in_voltage0_{en,index,type}
+ *   <sysfs_root>/iio:deviceN/scan_elements/in_timestamp_{en,index,type}
+ *   <sysfs_root>/iio:deviceN/buffer/{enable,length}
+ *   <sysfs_root>/iio:deviceN/trigger/current_trigger
+ *   <sysfs_root>/iio:deviceN/current_timestamp_clock
+ *   <dev_root>/iio:deviceN
+ *
+ */
+#ifndef HX711_IIO_H
+#define HX711_IIO_H
+
+#include <stdint.h>
+
+#define HX711_IIO_SYSFS_ROOT "/sys/bus/iio/devices"
+#define HX711_IIO_DEV_ROOT   "/dev"
+
+typedef struct {
+    const char* sysfs_root;     // NULL = HX711_IIO_SYSFS_ROOT
+    const char* dev_root;       // NULL = HX711_IIO_DEV_ROOT
+    int device;                 // N in iio:deviceN
+    int channel;                // 0 = A (gain 128/64), 1 = B (gain 32)
+    const char* trigger;        // Written to trigger/current_trigger, NULL leaves it alone
+    unsigned int buffer_length; // Kernel buffer depth in records, 0 = leave default
+} hx711_iio_config_t;
+
+/**
+ * @brief Configures the scan elements and trigger, then enables the buffer.
+ * @param cfg Device, channel and trigger selection.
+ * @return 0 on success, -1 on failure.
+ */
+int hx711_iio_open(const hx711_iio_config_t* cfg);
+
+/**
+ * @brief Disables the buffer and closes the chardev.
+ */
+void hx711_iio_close(void);
+
+/**
+ * @brief Waits for the next record. Matches wait_ready_func.
+ *
+ * Reads as many records as are available in one read() and serves the
+ * following calls from that batch.
+ *
+ * @param pin Ignored.
+ * @param timeout_ms Maximum time to wait.
+ * @param ready_ns Receives the record's kernel timestamp.
+ * @return 1 when a record is available, 0 on timeout, -1 on error.
+ */
+int hx711_iio_wait_ready(int pin, int timeout_ms, uint64_t* ready_ns);
+
+/**
+ * @brief Returns the record found by the last wait. Matches read_sample_func.
+ *
+ * Gain/channel are fixed by hx711_iio_open(); gain_pulses is ignored.
+ *
+ * @param gain_pulses Ignored.
+ * @param raw Receives the 24-bit two's complement conversion.
+ * @return 0 on success, -1 if no record is pending.
+ */
+int hx711_iio_read_sample(uint8_t gain_pulses, uint32_t* raw);
+
+/**
+ * @brief Reports whether a record is already buffered. Matches gpio_read_func.
+ *
+ * Not a data-ready line: leave hx711_backend_t.gpio_read NULL with this
+ * backend, so a failing hx711_iio_wait_ready() backs off instead of polling.
+ *
+ * @param pin Ignored.
+ * @return 0 if a record is buffered, 1 otherwise.
+ */
+int hx711_iio_ready(int pin);
+
+/**
+ * @brief Creates a file-backed stand-in for the sysfs/chardev layout.
+ *
+ * Builds <root>/sys/iio:deviceN with the attributes of the mainline driver
+ * and an empty <root>/dev/iio:deviceN record file.
+ *
+ * @param root Existing or new directory to build the layout in.
+ * @param device N in iio:deviceN.
+ * @param cfg Optional; receives roots and device for hx711_iio_open() (channel 0).
+ * @return 0 on success, -1 on failure.
+ */
+int hx711_iio_standin_create(const char* root, int device, hx711_iio_config_t* cfg);
+
+/**
+ * @brief Appends one buffer record to the stand-in chardev.
+ * @param root Directory passed to hx711_iio_standin_create().
+ * @param device N in iio:deviceN.
+ * @param value Conversion result (24-bit signed).
+ * @param timestamp_ns Record timestamp.
+ * @return 0 on success, -1 on failure.
+ */
+int hx711_iio_standin_append(const char* root, int device, long value, uint64_t timestamp_ns);
+
+#endif /* HX711_IIO_H */
@@ -0,0 +1,145 @@
+/**
+ *
+ * Memory-mapped GPIO register backend for the HX711 library
+ *
+ */
+#include "hx711_mmio.h"
+#include "hx711_fast.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define MAP_SIZE 0x1000
+
+static volatile uint32_t* regs;
+static void* map_base;
+static size_t map_len;
+static volatile uint32_t* sck_dr;    // DR_L or DR_H word holding PD_SCK
+static uint32_t sck_set;              // Write-enable mask | level 1
+static uint32_t sck_clear;            // Write-enable mask | level 0
+static volatile uint32_t* ext_port;
+static int dout_bit;
+
+// Sets one pin in a masked _L/_H register pair
+static void masked_write(uint32_t reg_l, int pin, int level) {
+    volatile uint32_t* reg = &regs[reg_l / 4 + (pin >= 16)];
+    uint32_t bit = 1u << (pin & 15);
+    *reg = (bit << 16) | (level ? bit : 0);
+}
+
+static void bind_pins(int dout_pin, int sck_pin) {
+    uint32_t bit = 1u << (sck_pin & 15);
+
+    sck_dr = &regs[HX711_MMIO_DR_L / 4 + (sck_pin >= 16)];
+    sck_set = (bit << 16) | bit;
+    sck_clear = bit << 16;
+    ext_port = &regs[HX711_MMIO_EXT_PORT / 4];
+    dout_bit = dout_pin;
+
+    masked_write(HX711_MMIO_DR_L, sck_pin, 0);
+    masked_write(HX711_MMIO_DDR_L, sck_pin, 1);
+    masked_write(HX711_MMIO_DDR_L, dout_pin, 0);
+}
+
+int hx711_mmio_open(uint32_t bank_base, int dout_pin, int sck_pin) {
+    long page = sysconf(_SC_PAGESIZE);
+    off_t page_base = (off_t)(bank_base & ~(uint32_t)(page - 1));
+    size_t page_off = bank_base - (uint32_t)page_base;
+
+    if (dout_pin < 0 || dout_pin > 31 || sck_pin < 0 || sck_pin > 31) return -1;
+
+    int fd = open("/dev/mem", O_RDWR | O_SYNC);
+    if (fd < 0) {
+        perror("HX711 MMIO open /dev/mem");
+        return -1;
+    }
+    map_len = MAP_SIZE + page_off;
+    map_base = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, page_base);
+    close(fd);
+    if (map_base == MAP_FAILED) {
+        perror("HX711 MMIO mmap");
+        map_base = NULL;
+        return -1;
+    }
+
+    regs = (volatile uint32_t*)((uint8_t*)map_base + page_off);
+    bind_pins(dout_pin, sck_pin);
+    return 0;
+}
+
+int hx711_mmio_open_fake(hx711_mmio_fake_t* fake, int dout_pin, int sck_pin) {
+    memset((void*)fake->regs, 0, sizeof(fake->regs));
+    map_base = NULL;
+    regs = fake->regs;
+    bind_pins(dout_pin, sck_pin);
+    return 0;
+}
+
+void hx711_mmio_close(void) {
+    if (map_base) munmap(map_base, map_len);
+    map_base = NULL;
+    regs = NULL;
+}
+
+static inline void mmio_sck(int level) {
+    *sck_dr = level ? sck_set : sck_clear;
+}
+
+static inline int mmio_dout(void) {
+    return (int)((*ext_port >> dout_bit) & 1u);
+}
+
+void hx711_mmio_write(int pin, int value) {
+    (void)pin;
+    mmio_sck(value);
+}
+
+int hx711_mmio_read(int pin) {
+    (void)pin;
+    return mmio_dout();
+}
+
+#define MMIO_DOUT() mmio_dout()
+HX711_DEFINE_FAST_READ(hx711_mmio_read_sample, mmio_sck, MMIO_DOUT, HX711_FAST_HOLD)
+
+// --- Shared-clock group (hx711_multi) ---
+
+static int bulk_pins[32];
+static int bulk_count;
+
+int hx711_mmio_bind_bulk(const int* dout_pins, int count) {
+    if (!regs || count < 1 || count > 32) return -1;
+    for (int i = 0; i < count; i++) {
+        if (dout_pins[i] < 0 || dout_pins[i] > 31) return -1;
+        bulk_pins[i] = dout_pins[i];
+        masked_write(HX711_MMIO_DDR_L, dout_pins[i], 0);
+    }
+    bulk_count = count;
+    return 0;
+}
+
+int hx711_mmio_read_bulk(uint32_t* bits) {
+    uint32_t port = *ext_port; // One load samples the whole bank
+    uint32_t levels = 0;
+
+    for (int i = 0; i < bulk_count; i++) {
+        levels |= ((port >> bulk_pins[i]) & 1u) << i;
+    }
+    *bits = levels;
+    return 0;
+}
+
+// --- Fake register file ---
+
+int hx711_mmio_fake_output(const hx711_mmio_fake_t* fake, int pin) {
+    uint32_t word = fake->regs[HX711_MMIO_DR_L / 4 + (pin >= 16)];
+    return (int)((word >> (pin & 15)) & 1u);
+}
+
+void hx711_mmio_fake_input(hx711_mmio_fake_t* fake, int pin, int level) {
+    uint32_t bit = 1u << pin;
+    uint32_t v = fake->regs[HX711_MMIO_EXT_PORT / 4];
+    fake->regs[HX711_MMIO_EXT_PORT / 4] = level ? (v | bit) : (v & ~bit);
+}
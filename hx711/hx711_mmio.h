@@ -0,0 +1,125 @@
+/**
+ *
+ * Memory-mapped GPIO register backend for the HX711 library
+ *
+ * Maps one Rockchip GPIO bank once and toggles PD_SCK / samples DOUT with
+ * plain stores and loads, so the clock train makes no syscalls at all.
+ * Plugs into hx711_init() as a gpio_write_func/gpio_read_func pair, or as
+ * the specialized hx711_mmio_read_sample() loop (hx711_fast.h).
+ *
+ * Register layout (RV1103/RV1106 and other "v2" Rockchip GPIO banks):
+ *   0x00 SWPORT_DR_L / 0x04 SWPORT_DR_H    output level, pins 0-15 / 16-31
+ *   0x08 SWPORT_DDR_L / 0x0C SWPORT_DDR_H  direction, 1 = output
+ *   0x70 EXT_PORT                          input level, pins 0-31
+ * The _L/_H registers take a write-enable mask in their upper 16 bits, so a
+ * single store changes one pin without a read-modify-write.
+ *
+ * The kernel GPIO driver still owns the pins (e.g. hx711_gpiod_open() for
+ * DOUT edge events); this backend only bypasses it for the clock-out.
+ *
+ */
+#ifndef HX711_MMIO_H
+#define HX711_MMIO_H
+
+#include <stdint.h>
+
+#define HX711_MMIO_RV1106_GPIO0_BASE 0xFF380000u
+#define HX711_MMIO_RV1106_GPIO1_BASE 0xFF530000u
+#define HX711_MMIO_RV1106_GPIO2_BASE 0xFF540000u
+#define HX711_MMIO_RV1106_GPIO3_BASE 0xFF550000u
+#define HX711_MMIO_RV1106_GPIO4_BASE 0xFF560000u
+
+#define HX711_MMIO_DR_L     0x00
+#define HX711_MMIO_DR_H     0x04
+#define HX711_MMIO_DDR_L    0x08
+#define HX711_MMIO_DDR_H    0x0C
+#define HX711_MMIO_EXT_PORT 0x70
+
+#define HX711_MMIO_REG_WORDS (HX711_MMIO_EXT_PORT / 4 + 1)
+
+// In-memory register file standing in for a GPIO bank. Stores land as-is
+// (no write-mask merge), so each _L/_H word holds the last masked store.
+typedef struct {
+    volatile uint32_t regs[HX711_MMIO_REG_WORDS];
+} hx711_mmio_fake_t;
+
+/**
+ * @brief Maps a GPIO bank through /dev/mem and sets the pin directions.
+ * @param bank_base Physical base address of the bank, e.g. HX711_MMIO_RV1106_GPIO2_BASE.
+ * @param dout_pin DOUT pin within the bank (0-31), same as the gpiochip line offset.
+ * @param sck_pin PD_SCK pin within the bank (0-31).
+ * @return 0 on success, -1 on failure.
+ */
+int hx711_mmio_open(uint32_t bank_base, int dout_pin, int sck_pin);
+
+/**
+ * @brief Uses an in-memory register file instead of the hardware bank.
+ * @param fake Register file; zeroed, then set up like the real bank.
+ * @param dout_pin DOUT pin within the bank (0-31).
+ * @param sck_pin PD_SCK pin within the bank (0-31).
+ * @return 0.
+ */
+int hx711_mmio_open_fake(hx711_mmio_fake_t* fake, int dout_pin, int sck_pin);
+
+/**
+ * @brief Unmaps the bank.
+ */
+void hx711_mmio_close(void);
+
+/**
+ * @brief Drives PD_SCK with one masked store. Matches gpio_write_func.
+ * @param pin Ignored; the pin was bound in hx711_mmio_open().
+ * @param value Level to drive.
+ */
+void hx711_mmio_write(int pin, int value);
+
+/**
+ * @brief Samples DOUT with one load. Matches gpio_read_func.
+ * @param pin Ignored; the pin was bound in hx711_mmio_open().
+ * @return Pin level.
+ */
+int hx711_mmio_read(int pin);
+
+/**
+ * @brief Specialized clock-out with inlined register accesses. Matches read_sample_func.
+ *
+ * Use with hx711_backend_t.read_sample_rt set; SCK holds are HX711_FAST_PULSE_NS.
+ *
+ * @param gain_pulses Extra pulses selecting the next channel/gain (1..3).
+ * @param raw Receives the 24 data bits, MSB first.
+ * @return 0.
+ */
+int hx711_mmio_read_sample(uint8_t gain_pulses, uint32_t* raw);
+
+/**
+ * @brief Binds the DOUT pins of a shared-clock group (hx711_multi), same bank as PD_SCK.
+ * @param dout_pins DOUT pins within the bank (0-31), in channel order.
+ * @param count Number of DOUT pins.
+ * @return 0 on success, -1 if the bank is not open or a pin is out of range.
+ */
+int hx711_mmio_bind_bulk(const int* dout_pins, int count);
+
+/**
+ * @brief Samples every bound DOUT pin with one load. Matches gpio_read_bulk_func.
+ * @param bits Receives bit i = level on DOUT pin i.
+ * @return 0 (a register load cannot fail).
+ */
+int hx711_mmio_read_bulk(uint32_t* bits);
+
+/**
+ * @brief Level last driven on a pin of the fake register file.
+ * @param fake Register file passed to hx711_mmio_open_fake().
+ * @param pin Pin within the bank (0-31).
+ * @return 1 or 0.
+ */
+int hx711_mmio_fake_output(const hx711_mmio_fake_t* fake, int pin);
+
+/**
+ * @brief Sets the input level the fake bank reports on a pin.
+ * @param fake Register file passed to hx711_mmio_open_fake().
+ * @param pin Pin within the bank (0-31).
+ * @param level Level to report.
+ */
+void hx711_mmio_fake_input(hx711_mmio_fake_t* fake, int pin, int level);
+
+#endif /* HX711_MMIO_H */
@@ -0,0 +1,155 @@
+/**
+ *
+ * Shared-clock multi-HX711 reader for the HX711 library
+ *
+ */
+#include "hx711_multi.h"
+#include <math.h>
+
+int hx711_multi_init(hx711_multi_t* m, int count, int sck_pin,
+                     gpio_write_func write_func, gpio_read_bulk_func read_bulk_func,
+                     delay_ns_func ns_func, unsigned int pulse_ns, delay_ms_func ms_func) {
+    if (count < 1 || count > HX711_MULTI_MAX) return -1;
+
+    m->count = count;
+    m->sck_pin = sck_pin;
+    m->rt_context = false;
+    m->gpio_write = write_func;
+    m->gpio_read_bulk = read_bulk_func;
+    m->delay_ns = ns_func;
+    m->pulse_ns = pulse_ns;
+    m->delay_ms = ms_func;
+    for (int i = 0; i < HX711_MULTI_MAX; i++) {
+        m->offset[i] = 0;
+        m->scale[i] = 1.0f;
+    }
+
+    m->gpio_write(m->sck_pin, 0); // Start with clock low
+    hx711_multi_set_gain(m, 128);
+    return 0;
+}
+
+void hx711_multi_set_gain(hx711_multi_t* m, uint8_t gain) {
+    switch (gain) {
+        case 128: m->gain = 1; break;
+        case 64:  m->gain = 3; break;
+        case 32:  m->gain = 2; break;
+    }
+}
+
+// 1 = every DOUT low, 0 = some chip still converting, -1 = bulk read failed
+static int multi_ready(hx711_multi_t* m) {
+    uint32_t bits;
+    if (m->gpio_read_bulk(&bits) < 0) return -1;
+    return (bits & ((1u << m->count) - 1u)) == 0;
+}
+
+bool hx711_multi_is_ready(hx711_multi_t* m) {
+    return multi_ready(m) == 1;
+}
+
+static inline void multi_hold(hx711_multi_t* m) {
+    if (m->delay_ns) m->delay_ns(m->pulse_ns);
+}
+
+int hx711_multi_read(hx711_multi_t* m, long* raw) {
+    uint32_t value[HX711_MULTI_MAX] = { 0 };
+    bool failed = false;
+    hx711_rt_saved_t saved;
+    int ready;
+
+    // Chips run off their own oscillators; the slowest one gates the read
+    while ((ready = multi_ready(m)) == 0) {
+        m->delay_ms(0);
+    }
+    if (ready < 0) {
+        m->delay_ms(HX711_ERROR_BACKOFF_MS);
+        return -1;
+    }
+
+    hx711_critical_enter(m->rt_context, &saved);
+    for (int i = 0; i < 24; ++i) {
+        uint32_t bits = 0;
+        m->gpio_write(m->sck_pin, 1);
+        multi_hold(m);
+        if (m->gpio_read_bulk(&bits) < 0) {
+            failed = true; // Keep clocking so every chip finishes the train
+        }
+        m->gpio_write(m->sck_pin, 0);
+        multi_hold(m);
+
+        for (int c = 0; c < m->count; c++) {
+            value[c] = (value[c] << 1) | ((bits >> c) & 1u);
+        }
+    }
+
+    // Set gain for the next reading
+    for (unsigned int i = 0; i < m->gain; i++) {
+        m->gpio_write(m->sck_pin, 1);
+        multi_hold(m);
+        m->gpio_write(m->sck_pin, 0);
+        multi_hold(m);
+    }
+    hx711_critical_leave(m->rt_context, &saved);
+    if (failed) return -1;
+
+    for (int c = 0; c < m->count; c++) {
+        raw[c] = hx711_sign_extend24(value[c]);
+    }
+    return 0;
+}
+
+int hx711_multi_read_average(hx711_multi_t* m, uint8_t times, long* avg) {
+    int64_t sum[HX711_MULTI_MAX] = { 0 };
+    long raw[HX711_MULTI_MAX];
+
+    if (times == 0) times = 1;
+    for (uint8_t i = 0; i < times; i++) {
+        if (hx711_multi_read(m, raw) < 0) return -1;
+        for (int c = 0; c < m->count; c++) sum[c] += raw[c];
+    }
+    for (int c = 0; c < m->count; c++) {
+        avg[c] = (long)(sum[c] / times);
+    }
+    return 0;
+}
+
+int hx711_multi_tare(hx711_multi_t* m, uint8_t times) {
+    return hx711_multi_read_average(m, times, m->offset);
+}
+
+void hx711_multi_set_scale(hx711_multi_t* m, int channel, float scale) {
+    if (channel >= 0 && channel < m->count) m->scale[channel] = scale;
+}
+
+void hx711_multi_set_offset(hx711_multi_t* m, int channel, long offset) {
+    if (channel >= 0 && channel < m->count) m->offset[channel] = offset;
+}
+
+float hx711_multi_get_units(hx711_multi_t* m, uint8_t times, float* units) {
+    long avg[HX711_MULTI_MAX];
+    float total = 0.0f;
+
+    if (hx711_multi_read_average(m, times, avg) < 0) return NAN;
+    for (int c = 0; c < m->count; c++) {
+        float u = (float)(avg[c] - m->offset[c]) / m->scale[c];
+        if (units) units[c] = u;
+        total += u;
+    }
+    return total;
+}
+
+float hx711_multi_corner_imbalance(const float* units, int count, float* share) {
+    float total = 0.0f, worst = 0.0f;
+
+    for (int c = 0; c < count; c++) total += units[c];
+    if (count <= 0 || fabsf(total) < 1e-6f) return 0.0f;
+
+    for (int c = 0; c < count; c++) {
+        float s = units[c] / total;
+        if (share) share[c] = s;
+        float dev = fabsf(s - 1.0f / (float)count);
+        if (dev > worst) worst = dev;
+    }
+    return worst;
+}
@@ -0,0 +1,128 @@
+/**
+ *
+ * Shared-clock multi-HX711 reader for the HX711 library
+ *
+ * Up to HX711_MULTI_MAX chips (e.g. the four corners of a platform scale)
+ * share one PD_SCK line. Their DOUT lines are sampled together on every
+ * clock edge with one bulk read (gpiod bulk or a GPIO bank register), so N
+ * simultaneous conversions cost the time of one. Each corner keeps its own
+ * offset and scale; the summed weight and corner shares come from one read.
+ *
+ */
+#ifndef HX711_MULTI_H
+#define HX711_MULTI_H
+
+#include "hx711.h"
+
+#define HX711_MULTI_MAX 8
+
+// Samples every DOUT at once into bits (bit i = level on channel i's DOUT).
+// Returns 0, or -1 if the transport failed and bits holds nothing.
+typedef int (*gpio_read_bulk_func)(uint32_t* bits);
+
+typedef struct {
+    int count;
+    int sck_pin;
+    uint8_t gain;             // Gain pulses, as in hx711_t
+    bool rt_context;          // Set while a persistent RT thread owns the chips
+
+    gpio_write_func gpio_write;
+    gpio_read_bulk_func gpio_read_bulk;
+    delay_ns_func delay_ns;
+    unsigned int pulse_ns;
+    delay_ms_func delay_ms;
+
+    long offset[HX711_MULTI_MAX];
+    float scale[HX711_MULTI_MAX];
+} hx711_multi_t;
+
+/**
+ * @brief Initializes a group of chips sharing one PD_SCK line.
+ * @param m Pointer to the hx711_multi_t struct to initialize.
+ * @param count Number of chips (1..HX711_MULTI_MAX).
+ * @param sck_pin GPIO pin number of the shared PD_SCK.
+ * @param write_func Drives PD_SCK.
+ * @param read_bulk_func Samples all DOUT lines at once.
+ * @param ns_func SCK hold delay (e.g. hx711_spin_delay_ns).
+ * @param pulse_ns Hold time for each SCK phase in nanoseconds.
+ * @param ms_func Millisecond delay used while polling for data ready.
+ * @return 0 on success, -1 if count is out of range.
+ */
+int hx711_multi_init(hx711_multi_t* m, int count, int sck_pin,
+                     gpio_write_func write_func, gpio_read_bulk_func read_bulk_func,
+                     delay_ns_func ns_func, unsigned int pulse_ns, delay_ms_func ms_func);
+
+/**
+ * @brief Set the gain factor of every chip.
+ * @param m Pointer to the initialized hx711_multi_t struct.
+ * @param gain Gain factor. Can be 128, 64, or 32.
+ */
+void hx711_multi_set_gain(hx711_multi_t* m, uint8_t gain);
+
+/**
+ * @brief Check if every chip has a conversion ready.
+ * @param m Pointer to the initialized hx711_multi_t struct.
+ * @return True if all DOUT lines are low; false if any is high or the bulk read failed.
+ */
+bool hx711_multi_is_ready(hx711_multi_t* m);
+
+/**
+ * @brief Waits for all chips and clocks out one conversion from each.
+ * @param m Pointer to the initialized hx711_multi_t struct.
+ * @param raw Receives `count` raw 24-bit values.
+ * @return 0 on success, -1 if a bulk read failed (raw is left unchanged).
+ */
+int hx711_multi_read(hx711_multi_t* m, long* raw);
+
+/**
+ * @brief Averages consecutive conversions per corner (64-bit sums).
+ * @param m Pointer to the initialized hx711_multi_t struct.
+ * @param times Number of readings to average.
+ * @param avg Receives `count` average raw values.
+ * @return 0 on success, -1 if a read failed (avg is left unchanged).
+ */
+int hx711_multi_read_average(hx711_multi_t* m, uint8_t times, long* avg);
+
+/**
+ * @brief Sets every corner's offset from the current readings.
+ * @param m Pointer to the initialized hx711_multi_t struct.
+ * @param times Number of readings to average.
+ * @return 0 on success, -1 if a read failed (offsets are kept).
+ */
+int hx711_multi_tare(hx711_multi_t* m, uint8_t times);
+
+/**
+ * @brief Set one corner's calibration scale factor.
+ * @param m Pointer to the initialized hx711_multi_t struct.
+ * @param channel Corner index.
+ * @param scale The scale factor.
+ */
+void hx711_multi_set_scale(hx711_multi_t* m, int channel, float scale);
+
+/**
+ * @brief Set one corner's offset manually.
+ * @param m Pointer to the initialized hx711_multi_t struct.
+ * @param channel Corner index.
+ * @param offset The offset value.
+ */
+void hx711_multi_set_offset(hx711_multi_t* m, int channel, long offset);
+
+/**
+ * @brief Weight in calibrated units, per corner and summed.
+ * @param m Pointer to the initialized hx711_multi_t struct.
+ * @param times Number of readings to average.
+ * @param units Optional; receives `count` per-corner weights.
+ * @return The summed weight, or NAN if a read failed.
+ */
+float hx711_multi_get_units(hx711_multi_t* m, uint8_t times, float* units);
+
+/**
+ * @brief Corner-load diagnostics: each corner's share of the total.
+ * @param units Per-corner weights from hx711_multi_get_units().
+ * @param count Number of corners.
+ * @param share Optional; receives `count` fractions of the total.
+ * @return Largest deviation of a share from 1/count (0 = load centred), or 0 with no load.
+ */
+float hx711_multi_corner_imbalance(const float* units, int count, float* share);
+
+#endif /* HX711_MULTI_H */
@@ -0,0 +1,124 @@
+/**
+ *
+ * Behavioural HX711 model
+ *
+ */
+#include "hx711_sim.h"
+#include "hx711_timing.h"
+#include "hx711_fast.h"
+#include <stddef.h>
+
+static hx711_sim_t* attached;
+static hx711_sim_t* bulk_sims;
+static int bulk_count;
+
+void hx711_sim_init(hx711_sim_t* sim, long value, uint32_t period_ns) {
+    sim->value = value;
+    sim->source = NULL;
+    sim->source_ctx = NULL;
+    sim->period_ns = period_ns;
+    sim->shift = 0;
+    sim->pulses = 0;
+    sim->gain_pulses = 1;
+    sim->channel = 1;
+    sim->settle_conversions = HX711_SIM_SETTLE_CONVERSIONS;
+    sim->settle_left = 0;
+    sim->sck = false;
+    sim->ready = false;
+    sim->ready_at_ns = hx711_time_ns() + period_ns;
+    sim->conversions = 0;
+}
+
+void hx711_sim_set_source(hx711_sim_t* sim, hx711_sim_source_func source, void* ctx) {
+    sim->source = source;
+    sim->source_ctx = ctx;
+}
+
+// Latches the next conversion once its period has elapsed
+static void sim_update(hx711_sim_t* sim) {
+    if (sim->ready || sim->pulses != 0) return;
+    if (sim->period_ns && hx711_time_ns() < sim->ready_at_ns) return;
+
+    long v = sim->source ? sim->source(sim->source_ctx, sim->gain_pulses) : sim->value;
+
+    // Input or gain changed: the first conversions land between the two inputs
+    if (sim->gain_pulses != sim->channel) {
+        sim->settle_left = sim->settle_conversions;
+        sim->prev_value = sim->source ? sim->source(sim->source_ctx, sim->channel) : sim->value;
+        sim->channel = sim->gain_pulses;
+    }
+    if (sim->settle_left) {
+        sim->settle_left--;
+        v = (v + sim->prev_value) / 2;
+    }
+    if (v > 0x7FFFFF) v = 0x7FFFFF;
+    if (v < -0x800000) v = -0x800000;
+    sim->shift = (uint32_t)v & 0xFFFFFF;
+    sim->ready = true;
+    sim->conversions++;
+}
+
+// A read-out ends at the first DOUT sample after the 25th..27th pulse
+static void sim_finish(hx711_sim_t* sim) {
+    sim->gain_pulses = (uint8_t)(sim->pulses - 24);
+    if (sim->gain_pulses > 3) sim->gain_pulses = 3;
+    sim->pulses = 0;
+    sim->ready = false;
+    sim->ready_at_ns = hx711_time_ns() + sim->period_ns;
+}
+
+void hx711_sim_sck(hx711_sim_t* sim, int level) {
+    if (level && !sim->sck) {
+        sim_update(sim);
+        if (sim->ready && sim->pulses < 27) sim->pulses++;
+    }
+    sim->sck = level != 0;
+}
+
+int hx711_sim_dout(hx711_sim_t* sim) {
+    if (sim->pulses >= 25 && !sim->sck) sim_finish(sim);
+    if (sim->pulses == 0) {
+        sim_update(sim);
+        return sim->ready ? 0 : 1;
+    }
+    if (sim->pulses <= 24) return (int)((sim->shift >> (24 - sim->pulses)) & 1);
+    return 1;
+}
+
+void hx711_sim_attach(hx711_sim_t* sim) {
+    attached = sim;
+}
+
+void hx711_sim_gpio_write(int pin, int value) {
+    (void)pin;
+    hx711_sim_sck(attached, value);
+}
+
+int hx711_sim_gpio_read(int pin) {
+    (void)pin;
+    return hx711_sim_dout(attached);
+}
+
+void hx711_sim_attach_bulk(hx711_sim_t* sims, int count) {
+    bulk_sims = sims;
+    bulk_count = count;
+}
+
+void hx711_sim_bulk_write(int pin, int value) {
+    (void)pin;
+    for (int i = 0; i < bulk_count; i++) hx711_sim_sck(&bulk_sims[i], value);
+}
+
+int hx711_sim_bulk_read(uint32_t* bits) {
+    uint32_t levels = 0;
+    for (int i = 0; i < bulk_count; i++) {
+        if (hx711_sim_dout(&bulk_sims[i])) levels |= 1u << i;
+    }
+    *bits = levels;
+    return 0;
+}
+
+// The model has no pulse-width limits, so the specialized loop needs no holds
+#define SIM_SCK(level) hx711_sim_sck(attached, (level))
+#define SIM_DOUT() hx711_sim_dout(attached)
+HX711_DEFINE_FAST_READ(hx711_sim_read_sample, SIM_SCK, SIM_DOUT, HX711_FAST_NO_HOLD)
@@ -0,0 +1,128 @@
+/**
+ *
+ * Behavioural HX711 model
+ *
+ * Emulates the chip at the pin level (PD_SCK in, DOUT out) with a
+ * configurable conversion period, so backends and the acquisition engine can
+ * run without hardware. The stand-in spidev device drives it one clock at a
+ * time; the gpio functions let the bit-bang path drive it directly.
+ *
+ */
+#ifndef HX711_SIM_H
+#define HX711_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Supplies the next conversion. Channel: 1 = A/128, 2 = B/32, 3 = A/64
+// (the number of gain pulses that selected it).
+typedef long (*hx711_sim_source_func)(void* ctx, uint8_t channel);
+
+#define HX711_SIM_SETTLE_CONVERSIONS 4 // Datasheet output settling after an input or gain change
+
+typedef struct {
+    long value;                    // Conversion result when no source is set
+    hx711_sim_source_func source;
+    void* source_ctx;
+    uint32_t period_ns;            // Conversion period, 0 = always ready
+    uint8_t settle_conversions;    // Conversions after an input change that are not yet valid
+
+    // Chip state
+    uint32_t shift;                // Output register (24-bit two's complement)
+    uint8_t pulses;                // Pulses clocked in the current read-out
+    uint8_t gain_pulses;           // Channel/gain selected for the next conversion
+    uint8_t channel;               // Channel of the last conversion
+    uint8_t settle_left;
+    long prev_value;               // Old input's value, for the settling output
+    bool sck;
+    bool ready;
+    uint64_t ready_at_ns;
+    uint64_t conversions;
+} hx711_sim_t;
+
+/**
+ * @brief Initializes the model.
+ *
+ * After a channel/gain change the model, like the chip, needs
+ * HX711_SIM_SETTLE_CONVERSIONS conversions before the output is valid; until
+ * then it returns the midpoint of the old and new input (settle_conversions
+ * may be changed after init, 0 = settles at once).
+ *
+ * @param sim Pointer to the model.
+ * @param value Constant conversion result (24-bit signed).
+ * @param period_ns Conversion period (100 ms at 10 SPS, 12.5 ms at 80 SPS), 0 for no wait.
+ */
+void hx711_sim_init(hx711_sim_t* sim, long value, uint32_t period_ns);
+
+/**
+ * @brief Sets a callback that produces each conversion instead of the constant.
+ * @param sim Pointer to the model.
+ * @param source Callback, or NULL for the constant value.
+ * @param ctx Passed through to the callback.
+ */
+void hx711_sim_set_source(hx711_sim_t* sim, hx711_sim_source_func source, void* ctx);
+
+/**
+ * @brief Drives PD_SCK.
+ * @param sim Pointer to the model.
+ * @param level Level on PD_SCK.
+ */
+void hx711_sim_sck(hx711_sim_t* sim, int level);
+
+/**
+ * @brief Samples DOUT.
+ * @param sim Pointer to the model.
+ * @return Level on DOUT (0 = data ready while idle).
+ */
+int hx711_sim_dout(hx711_sim_t* sim);
+
+/**
+ * @brief Binds a model to the hx711_sim_gpio_* functions.
+ * @param sim Pointer to the model.
+ */
+void hx711_sim_attach(hx711_sim_t* sim);
+
+/**
+ * @brief PD_SCK write on the attached model. Matches gpio_write_func.
+ * @param pin Ignored.
+ * @param value Level to drive.
+ */
+void hx711_sim_gpio_write(int pin, int value);
+
+/**
+ * @brief DOUT read on the attached model. Matches gpio_read_func.
+ * @param pin Ignored.
+ * @return Level on DOUT.
+ */
+int hx711_sim_gpio_read(int pin);
+
+/**
+ * @brief Binds models sharing one PD_SCK to the hx711_sim_bulk_* functions.
+ * @param sims Array of models, in channel order.
+ * @param count Number of models.
+ */
+void hx711_sim_attach_bulk(hx711_sim_t* sims, int count);
+
+/**
+ * @brief Drives the shared PD_SCK of every bulk model. Matches gpio_write_func.
+ * @param pin Ignored.
+ * @param value Level to drive.
+ */
+void hx711_sim_bulk_write(int pin, int value);
+
+/**
+ * @brief Samples every bulk model's DOUT. Matches gpio_read_bulk_func.
+ * @param bits Receives bit i = DOUT of model i.
+ * @return 0.
+ */
+int hx711_sim_bulk_read(uint32_t* bits);
+
+/**
+ * @brief Specialized clock-out on the attached model (hx711_fast.h). Matches read_sample_func.
+ * @param gain_pulses Extra pulses selecting the next channel/gain (1..3).
+ * @param raw Receives the 24 data bits, MSB first.
+ * @return 0.
+ */
+int hx711_sim_read_sample(uint8_t gain_pulses, uint32_t* raw);
+
+#endif /* HX711_SIM_H */
@@ -0,0 +1,104 @@
+/**
+ *
+ * spidev transport for the HX711 library
+ *
+ */
+#include "hx711_spi.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+
+static int spi_fd = -1;
+static uint32_t spi_speed_hz;
+static hx711_sim_t* spi_sim;
+
+int hx711_spi_open(const char* device, uint32_t speed_hz) {
+    uint8_t mode = SPI_MODE_1;  // Idle low; HX711 shifts on the rising edge, we sample on the falling
+    uint8_t bits = 8;
+
+    spi_fd = open(device, O_RDWR);
+    if (spi_fd < 0) {
+        perror("HX711 SPI open");
+        return -1;
+    }
+
+    if (ioctl(spi_fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+        ioctl(spi_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+        ioctl(spi_fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed_hz) < 0) {
+        perror("HX711 SPI setup");
+        close(spi_fd);
+        spi_fd = -1;
+        return -1;
+    }
+
+    spi_speed_hz = speed_hz;
+    spi_sim = NULL;
+    return 0;
+}
+
+int hx711_spi_open_sim(hx711_sim_t* sim, uint32_t speed_hz) {
+    spi_sim = sim;
+    spi_speed_hz = speed_hz;
+    return 0;
+}
+
+void hx711_spi_close(void) {
+    if (spi_fd >= 0) close(spi_fd);
+    spi_fd = -1;
+    spi_sim = NULL;
+}
+
+// Stand-in for SPI_IOC_MESSAGE: a mode-1 master clocking the simulated chip
+static int sim_message(const struct spi_ioc_transfer* xfer, int count) {
+    for (int t = 0; t < count; t++) {
+        unsigned int bits = xfer[t].bits_per_word ? xfer[t].bits_per_word : 8;
+        unsigned int word_bytes = (bits + 7) / 8;
+        uint8_t* rx = (uint8_t*)(uintptr_t)xfer[t].rx_buf;
+
+        for (unsigned int off = 0; off < xfer[t].len; off += word_bytes) {
+            uint32_t word = 0;
+            for (unsigned int b = 0; b < bits; b++) {
+                hx711_sim_sck(spi_sim, 1);
+                word = (word << 1) | (uint32_t)hx711_sim_dout(spi_sim);
+                hx711_sim_sck(spi_sim, 0);
+            }
+            // spidev stores words in native (little-endian) order
+            for (unsigned int i = 0; rx && i < word_bytes; i++) {
+                rx[off + i] = (uint8_t)(word >> (8 * i));
+            }
+        }
+    }
+    return 0;
+}
+
+int hx711_spi_read_sample(uint8_t gain_pulses, uint32_t* raw) {
+    uint8_t data[3] = { 0, 0, 0 };
+    uint8_t gain = 0;
+    struct spi_ioc_transfer xfer[2];
+
+    memset(xfer, 0, sizeof(xfer));
+    xfer[0].rx_buf = (uintptr_t)data;
+    xfer[0].len = sizeof(data);
+    xfer[0].speed_hz = spi_speed_hz;
+    xfer[0].bits_per_word = 8;
+
+    // One short word supplies exactly the 1..3 channel/gain pulses
+    xfer[1].rx_buf = (uintptr_t)&gain;
+    xfer[1].len = 1;
+    xfer[1].speed_hz = spi_speed_hz;
+    xfer[1].bits_per_word = gain_pulses;
+
+    int ret = spi_sim ? sim_message(xfer, 2) : ioctl(spi_fd, SPI_IOC_MESSAGE(2), xfer);
+    if (ret < 0) return -1;
+
+    *raw = ((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) | data[2];
+    return 0;
+}
+
+int hx711_spi_sim_dout(int pin) {
+    (void)pin;
+    return spi_sim ? hx711_sim_dout(spi_sim) : 1;
+}
@@ -0,0 +1,59 @@
+/**
+ *
+ * spidev transport for the HX711 library
+ *
+ * PD_SCK is wired to SPI SCLK and DOUT to MISO. One SPI_IOC_MESSAGE clocks
+ * out the 24 data bits and the 1..3 gain pulses, so a sample costs a single
+ * ioctl instead of 50+ GPIO syscalls. The controller generates the clock, so
+ * no real-time scheduling is needed during the transfer.
+ *
+ * MISO cannot be sensed while idle, so DOUT must also reach a GPIO input for
+ * data-ready detection (any gpio_read_func/wait_ready_func backend).
+ * The controller must accept 1..3 bits per word for the gain pulses.
+ *
+ */
+#ifndef HX711_SPI_H
+#define HX711_SPI_H
+
+#include <stdint.h>
+#include "hx711_sim.h"
+
+#define HX711_SPI_DEFAULT_HZ 1000000 // 0.5 us SCK high; datasheet allows 0.2-50 us
+
+/**
+ * @brief Opens and configures a spidev device (mode 1, MSB first).
+ * @param device Device node, e.g. "/dev/spidev0.0".
+ * @param speed_hz SCLK frequency; at most 2.5 MHz for the 0.2 us minimum pulse.
+ * @return 0 on success, -1 on failure.
+ */
+int hx711_spi_open(const char* device, uint32_t speed_hz);
+
+/**
+ * @brief Uses the stand-in spidev device: transfers are clocked into a simulated chip.
+ * @param sim Initialized model to talk to.
+ * @param speed_hz Nominal SCLK frequency (recorded only).
+ * @return 0.
+ */
+int hx711_spi_open_sim(hx711_sim_t* sim, uint32_t speed_hz);
+
+/**
+ * @brief Closes the spidev device.
+ */
+void hx711_spi_close(void);
+
+/**
+ * @brief Clocks out one conversion in a single transfer. Matches read_sample_func.
+ * @param gain_pulses Extra pulses selecting the next channel/gain (1..3).
+ * @param raw Receives the 24 data bits, MSB first.
+ * @return 0 on success, -1 on failure.
+ */
+int hx711_spi_read_sample(uint8_t gain_pulses, uint32_t* raw);
+
+/**
+ * @brief Data-ready check against the stand-in device. Matches gpio_read_func.
+ * @param pin Ignored.
+ * @return DOUT level of the simulated chip.
+ */
+int hx711_spi_sim_dout(int pin);
+
+#endif /* HX711_SPI_H */
@@ -0,0 +1,158 @@
+/**
+ *
+ * Motion/stability detector for the HX711 sample stream
+ *
+ */
+#include "hx711_stable.h"
+#include <math.h>
+#include <string.h>
+
+// Entry limits are half the exit limits, so a reading on the edge cannot flicker
+#define ENTER_SD_DIV    0.5   // Windowed sd, in divisions
+#define ENTER_DRIFT_DIV 0.5   // Slope * settling_time, in divisions
+#define EXIT_SD_DIV     1.0
+#define EXIT_DRIFT_DIV  1.0
+#define EXIT_STEP_DIV   2.0   // One sample this far from the settled value
+#define RATE_HEADROOM   1.05  // Internal-oscillator chips run a few percent fast
+
+void hx711_stable_init(hx711_stable_t* det, double settling_time_s, double division,
+                       hx711_stable_func on_event, void* ctx) {
+    memset(det, 0, sizeof(*det));
+    det->window_ns = (uint64_t)(settling_time_s * 1e9);
+    det->division = division;
+    det->noise_scale = 1.0;
+    det->held_scale = 1.0;
+    det->on_event = on_event;
+    det->ctx = ctx;
+}
+
+double hx711_stable_max_settling(int sps) {
+    return (HX711_STABLE_MAX_WINDOW - 1) / (sps * RATE_HEADROOM);
+}
+
+void hx711_stable_set_noise_scale(hx711_stable_t* det, double scale) {
+    det->noise_scale = scale < 1.0 ? 1.0 : scale;
+}
+
+void hx711_stable_set_division(hx711_stable_t* det, double division) {
+    det->division = division;
+}
+
+void hx711_stable_reset(hx711_stable_t* det, uint64_t now_ns) {
+    det->count = 0;
+    det->covered = false;
+    det->st = det->sx = det->stt = det->stx = det->sxx = 0.0;
+    det->since_rebuild = 0;
+    det->stable = false;
+    det->motion_ns = now_ns;
+}
+
+static int slot(const hx711_stable_t* det, int i) {
+    return (det->head + i) % HX711_STABLE_MAX_WINDOW;
+}
+
+static void sums_add(hx711_stable_t* det, uint64_t t, long x, double sign) {
+    double dt = (double)(int64_t)(t - det->t_ref) * 1e-9;
+    double dx = (double)(x - det->x_ref);
+    det->st += sign * dt;
+    det->sx += sign * dx;
+    det->stt += sign * dt * dt;
+    det->stx += sign * dt * dx;
+    det->sxx += sign * dx * dx;
+}
+
+// Re-centres the sums on the oldest sample, so adds and removes cannot
+// accumulate rounding error; once per window, so still O(1) amortized
+static void sums_rebuild(hx711_stable_t* det) {
+    det->st = det->sx = det->stt = det->stx = det->sxx = 0.0;
+    det->since_rebuild = 0;
+    if (det->count == 0) return;
+
+    det->t_ref = det->t[det->head];
+    det->x_ref = det->x[det->head];
+    for (int i = 0; i < det->count; i++) {
+        int s = slot(det, i);
+        sums_add(det, det->t[s], det->x[s], 1.0);
+    }
+}
+
+static void window_stats(const hx711_stable_t* det, double* mean, double* sd, double* slope) {
+    double n = (double)det->count;
+    double mx = det->sx / n;
+    double var = det->sxx / n - mx * mx;
+    double tvar = det->stt / n - (det->st / n) * (det->st / n);
+
+    *mean = mx + (double)det->x_ref;
+    *sd = var > 0.0 ? sqrt(var) : 0.0;
+    *slope = tvar > 1e-12 ? (det->stx / n - (det->st / n) * mx) / tvar : 0.0;
+}
+
+static void publish(hx711_stable_t* det, bool stable, uint64_t t, double mean, double sd, double slope) {
+    det->stable = stable;
+    det->last.stable = stable;
+    det->last.value = lround(mean);
+    det->last.timestamp_ns = t;
+    det->last.settle_ns = stable ? t - det->motion_ns : 0;
+    det->last.sd = sd;
+    det->last.slope_per_s = slope;
+    if (!stable) det->motion_ns = t;
+    if (det->on_event) det->on_event(&det->last, det->ctx);
+}
+
+bool hx711_stable_push(hx711_stable_t* det, uint64_t timestamp_ns, long value) {
+    if (det->count == 0 && det->since_rebuild == 0) {
+        if (!det->motion_ns) det->motion_ns = timestamp_ns;
+        det->t_ref = timestamp_ns;
+        det->x_ref = value;
+    }
+
+    // Drop samples older than the settling window (or the ring's capacity)
+    while (det->count > 0 &&
+           (timestamp_ns - det->t[det->head] > det->window_ns || det->count == HX711_STABLE_MAX_WINDOW)) {
+        sums_add(det, det->t[det->head], det->x[det->head], -1.0);
+        det->head = slot(det, 1);
+        det->count--;
+        det->covered = true;
+    }
+
+    int s = slot(det, det->count);
+    det->t[s] = timestamp_ns;
+    det->x[s] = value;
+    det->count++;
+    sums_add(det, timestamp_ns, value, 1.0);
+    if (++det->since_rebuild >= HX711_STABLE_MAX_WINDOW) sums_rebuild(det);
+
+    // Noisier samples keep the limits wide until they have left the window
+    if (det->noise_scale >= det->held_scale || timestamp_ns > det->held_until_ns) {
+        det->held_scale = det->noise_scale;
+        det->held_until_ns = timestamp_ns + det->window_ns;
+    }
+
+    if (det->count < 3) return false;
+
+    double mean, sd, slope;
+    window_stats(det, &mean, &sd, &slope);
+    double drift = fabs(slope) * (double)det->window_ns * 1e-9;
+    double div = det->division;
+    double noise_div = div * det->held_scale; // sd and step limits follow the sample noise
+
+    if (det->stable) {
+        if (sd > EXIT_SD_DIV * noise_div || drift > EXIT_DRIFT_DIV * div ||
+            fabs((double)(value - det->last.value)) > EXIT_STEP_DIV * noise_div) {
+            publish(det, false, timestamp_ns, mean, sd, slope);
+            return true;
+        }
+    } else if (det->covered && sd <= ENTER_SD_DIV * noise_div && drift <= ENTER_DRIFT_DIV * div) {
+        publish(det, true, timestamp_ns, mean, sd, slope);
+        return true;
+    }
+    return false;
+}
+
+bool hx711_stable_is_stable(const hx711_stable_t* det) {
+    return det->stable;
+}
+
+const hx711_stable_event_t* hx711_stable_last(const hx711_stable_t* det) {
+    return &det->last;
+}
@@ -0,0 +1,132 @@
+/**
+ *
+ * Motion/stability detector for the HX711 sample stream
+ *
+ * Keeps the samples of the last `settling_time` in a ring with running
+ * regression sums, so the windowed standard deviation and slope are
+ * available in O(1) per sample. The load is reported stable once the whole
+ * window is quiet against the scale division, and unstable again as soon as
+ * it moves; each transition is published as an event carrying the settled
+ * value and the time it took to settle.
+ *
+ */
+#ifndef HX711_STABLE_H
+#define HX711_STABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HX711_STABLE_MAX_WINDOW 256 // Samples; 3.2 s at 80 SPS
+
+// A stable/unstable transition
+typedef struct {
+    bool stable;
+    long value;              // Mean over the settling window, in the units fed in
+    uint64_t timestamp_ns;   // Time of the sample that caused the transition
+    uint64_t settle_ns;      // Stable only: from the start of motion to settling
+    double sd;               // Windowed standard deviation
+    double slope_per_s;      // Windowed drift rate
+} hx711_stable_event_t;
+
+typedef void (*hx711_stable_func)(const hx711_stable_event_t* ev, void* ctx);
+
+typedef struct {
+    uint64_t window_ns;      // settling_time
+    double division;         // Scale division in the units fed in (raw counts for raw samples)
+    double noise_scale;      // Sample noise relative to the rate the limits assume, >= 1
+    double held_scale;       // Largest noise_scale still inside the window
+    uint64_t held_until_ns;
+    hx711_stable_func on_event;
+    void* ctx;
+
+    // Samples inside the window
+    uint64_t t[HX711_STABLE_MAX_WINDOW];
+    long x[HX711_STABLE_MAX_WINDOW];
+    int head;
+    int count;
+    bool covered;            // The window has spanned a full settling_time
+
+    // Regression sums relative to t_ref/x_ref, rebuilt now and then
+    uint64_t t_ref;
+    long x_ref;
+    double st, sx, stt, stx, sxx;
+    int since_rebuild;
+
+    bool stable;
+    uint64_t motion_ns;      // When the current motion started
+    hx711_stable_event_t last;
+} hx711_stable_t;
+
+/**
+ * @brief Initializes the detector in the unstable state.
+ * @param det Pointer to the detector.
+ * @param settling_time_s Window that must be quiet, in seconds (config "settling_time").
+ * @param division Scale division in the units that will be pushed.
+ * @param on_event Optional transition callback.
+ * @param ctx Passed through to the callback.
+ */
+void hx711_stable_init(hx711_stable_t* det, double settling_time_s, double division,
+                       hx711_stable_func on_event, void* ctx);
+
+/**
+ * @brief Longest settling_time the ring holds at a given sample rate.
+ *
+ * A longer window would be cut to HX711_STABLE_MAX_WINDOW samples without
+ * notice, so callers should clamp the configured time to this.
+ *
+ * @param sps Samples per second pushed into the detector.
+ * @return Seconds, with headroom for a chip whose oscillator runs fast.
+ */
+double hx711_stable_max_settling(int sps);
+
+/**
+ * @brief Widens the noise limits for samples taken at a noisier rate.
+ *
+ * The sd and single-step limits are multiplied by the scale, so the faster
+ * output rate can settle on the same load as the slow one (e.g.
+ * HX711_RATE_NOISE_RATIO at 80 SPS, 1 at 10 SPS). A lower scale takes effect
+ * once the noisier samples have left the window.
+ *
+ * @param det Pointer to the detector.
+ * @param scale Noise of the samples now pushed relative to the reference rate.
+ */
+void hx711_stable_set_noise_scale(hx711_stable_t* det, double scale);
+
+/**
+ * @brief Changes the division, e.g. after a new calibration factor.
+ * @param det Pointer to the detector.
+ * @param division Scale division in the units that are pushed.
+ */
+void hx711_stable_set_division(hx711_stable_t* det, double division);
+
+/**
+ * @brief Forgets the window and reports unstable until it fills again.
+ * @param det Pointer to the detector.
+ * @param now_ns Time the new motion starts.
+ */
+void hx711_stable_reset(hx711_stable_t* det, uint64_t now_ns);
+
+/**
+ * @brief Adds one sample and publishes a transition if there is one.
+ * @param det Pointer to the detector.
+ * @param timestamp_ns Sample time (hx711_sample_t.timestamp_ns).
+ * @param value Sample value (raw or filtered counts).
+ * @return True if the state changed with this sample.
+ */
+bool hx711_stable_push(hx711_stable_t* det, uint64_t timestamp_ns, long value);
+
+/**
+ * @brief Current state.
+ * @param det Pointer to the detector.
+ * @return True while the load is stable.
+ */
+bool hx711_stable_is_stable(const hx711_stable_t* det);
+
+/**
+ * @brief The most recent transition.
+ * @param det Pointer to the detector.
+ * @return Pointer to the last published event.
+ */
+const hx711_stable_event_t* hx711_stable_last(const hx711_stable_t* det);
+
+#endif /* HX711_STABLE_H */
@@ -0,0 +1,197 @@
+/**
+ *
+ * Temperature compensation for the HX711 library
+ *
+ */
+#include "hx711_temp.h"
+#include "hx711_timing.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define READER_SLICE_MS 100 // Stop is noticed within one slice of the period
+
+static void fit_reset(hx711_temp_fit_t* fit) {
+    memset(fit, 0, sizeof(*fit));
+}
+
+static void fit_push(hx711_temp_fit_t* fit, double t, double y) {
+    if (fit->n == 0) {
+        fit->t0 = t;
+        fit->t_min = t;
+        fit->t_max = t;
+    }
+    if (t < fit->t_min) fit->t_min = t;
+    if (t > fit->t_max) fit->t_max = t;
+
+    double dt = t - fit->t0;
+    fit->n++;
+    fit->st += dt;
+    fit->stt += dt * dt;
+    fit->sy += y;
+    fit->sty += dt * y;
+}
+
+// Line through the capture, evaluated around t_ref: y = a + b * (t - t_ref)
+static int fit_solve(const hx711_temp_fit_t* fit, double t_ref, double* a, double* b) {
+    if (fit->n < HX711_TEMP_FIT_MIN_SAMPLES) return -1;
+    if (fit->t_max - fit->t_min < HX711_TEMP_FIT_MIN_SPREAD) return -1;
+
+    double n = (double)fit->n;
+    double det = n * fit->stt - fit->st * fit->st;
+    if (det <= 0.0) return -1;
+
+    *b = (n * fit->sty - fit->st * fit->sy) / det;
+    *a = (fit->sy - *b * fit->st) / n + *b * (t_ref - fit->t0);
+    return 0;
+}
+
+static void update_terms(hx711_temp_t* tc) {
+    if (!tc->have_temp) {
+        tc->shift = 0.0f;
+        tc->gain = 1.0f;
+        return;
+    }
+    float span = 1.0f + tc->span_tc * (tc->temp - tc->ref_temp);
+    tc->shift = tc->zero_tc * (tc->temp - tc->tare_temp);
+    tc->gain = span > 0.0f ? 1.0f / span : 1.0f;
+}
+
+void hx711_temp_init(hx711_temp_t* tc, float ref_temp, float tare_temp, float zero_tc, float span_tc) {
+    memset(tc, 0, sizeof(*tc));
+    tc->ref_temp = ref_temp;
+    tc->tare_temp = tare_temp;
+    tc->zero_tc = zero_tc;
+    tc->span_tc = span_tc;
+    update_terms(tc);
+}
+
+void hx711_temp_set(hx711_temp_t* tc, float celsius) {
+    tc->temp = celsius;
+    tc->have_temp = true;
+    update_terms(tc);
+}
+
+void hx711_temp_clear(hx711_temp_t* tc) {
+    tc->have_temp = false;
+    update_terms(tc);
+}
+
+void hx711_temp_tare(hx711_temp_t* tc) {
+    if (!tc->have_temp) return;
+    tc->tare_temp = tc->temp;
+    update_terms(tc);
+}
+
+void hx711_temp_calibrate(hx711_temp_t* tc) {
+    if (!tc->have_temp) return;
+    tc->ref_temp = tc->temp;
+    tc->tare_temp = tc->temp;
+    update_terms(tc);
+}
+
+long hx711_temp_apply(const hx711_temp_t* tc, const hx711_t* hx, long raw) {
+    // Net fits a float exactly (24-bit), so this is one subtract and one multiply-add
+    float net = (float)(raw - hx->offset) - tc->shift;
+    return hx->offset + lrintf(net * tc->gain);
+}
+
+void hx711_temp_start_capture(hx711_temp_t* tc, hx711_temp_capture_t mode) {
+    tc->capture = mode;
+    fit_reset(&tc->fit);
+}
+
+void hx711_temp_capture(hx711_temp_t* tc, const hx711_t* hx, long raw) {
+    if (!tc->have_temp) return;
+
+    switch (tc->capture) {
+    case HX711_TEMP_CAPTURE_ZERO:
+        fit_push(&tc->fit, tc->temp, (double)raw);
+        break;
+    case HX711_TEMP_CAPTURE_SPAN:
+        // Zero movement is already known; what is left is the span change
+        fit_push(&tc->fit, tc->temp, (double)(raw - hx->offset) - tc->shift);
+        break;
+    default:
+        break;
+    }
+}
+
+int hx711_temp_solve(hx711_temp_t* tc) {
+    double a, b;
+
+    switch (tc->capture) {
+    case HX711_TEMP_CAPTURE_ZERO:
+        if (fit_solve(&tc->fit, tc->tare_temp, &a, &b) != 0) return -1;
+        tc->zero_tc = (float)b;
+        break;
+    case HX711_TEMP_CAPTURE_SPAN:
+        if (fit_solve(&tc->fit, tc->ref_temp, &a, &b) != 0 || a == 0.0) return -1;
+        tc->span_tc = (float)(b / a);
+        break;
+    default:
+        return -1;
+    }
+    update_terms(tc);
+    return 0;
+}
+
+int hx711_temp_read_sysfs(const char* path, float* celsius) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return -1;
+
+    long milli;
+    int ok = fscanf(fp, "%ld", &milli) == 1;
+    fclose(fp);
+    if (!ok) return -1;
+
+    *celsius = (float)milli / 1000.0f;
+    return 0;
+}
+
+static void* reader_thread(void* arg) {
+    hx711_temp_reader_t* rd = arg;
+    struct timespec slice = { 0, READER_SLICE_MS * 1000000L };
+
+    while (atomic_load_explicit(&rd->running, memory_order_relaxed)) {
+        float celsius;
+        if (hx711_temp_read_sysfs(rd->path, &celsius) == 0) {
+            // Value first, then the stamp: a reader that sees the stamp sees this value or a newer one
+            atomic_store_explicit(&rd->milli, lrintf(celsius * 1000.0f), memory_order_relaxed);
+            atomic_store_explicit(&rd->read_ns, hx711_time_ns(), memory_order_release);
+        }
+        for (unsigned waited = 0; waited < rd->period_ms; waited += READER_SLICE_MS) {
+            if (!atomic_load_explicit(&rd->running, memory_order_relaxed)) break;
+            nanosleep(&slice, NULL);
+        }
+    }
+    return NULL;
+}
+
+int hx711_temp_reader_start(hx711_temp_reader_t* rd, const char* path, unsigned period_ms) {
+    snprintf(rd->path, sizeof(rd->path), "%s", path);
+    rd->period_ms = period_ms;
+    atomic_store(&rd->milli, 0);
+    atomic_store(&rd->read_ns, 0);
+    atomic_store(&rd->running, true);
+
+    if (pthread_create(&rd->thread, NULL, reader_thread, rd) != 0) {
+        atomic_store(&rd->running, false);
+        return -1;
+    }
+    return 0;
+}
+
+void hx711_temp_reader_stop(hx711_temp_reader_t* rd) {
+    if (!atomic_exchange(&rd->running, false)) return;
+    pthread_join(rd->thread, NULL);
+}
+
+bool hx711_temp_reader_latest(hx711_temp_reader_t* rd, float* celsius, uint64_t* read_ns) {
+    uint64_t at = atomic_load_explicit(&rd->read_ns, memory_order_acquire);
+    if (at == 0) return false;
+    *celsius = (float)atomic_load_explicit(&rd->milli, memory_order_relaxed) / 1000.0f;
+    *read_ns = at;
+    return true;
+}
@@ -0,0 +1,174 @@
+/**
+ *
+ * Temperature compensation for the HX711 library
+ *
+ * A load cell's zero and span both move with temperature. The model is
+ *
+ *     net(T) = W * (1 + span_tc * (T - ref_temp)) + zero_tc * (T - tare_temp)
+ *
+ * with zero_tc in raw counts per degree and span_tc a fraction per degree.
+ * Span is referred to the calibration temperature, zero to the temperature
+ * of the last tare. hx711_temp_set() folds the current temperature into a
+ * shift and a gain, so hx711_temp_apply() costs one subtract and one
+ * multiply-add per sample and returns a raw-domain value that the filter,
+ * stability and zero stages take unchanged.
+ *
+ * Capture mode learns the coefficients from stable readings across a
+ * temperature swing: an empty pan for zero_tc, then a constant test load for
+ * span_tc. Both are plain least-squares sums, no allocation.
+ *
+ * Sysfs sensors can take most of a second per read (a 1-wire conversion is
+ * ~750 ms), so hx711_temp_reader_start() reads them on a thread of their own
+ * and the caller only picks up the latest value.
+ *
+ */
+#ifndef HX711_TEMP_H
+#define HX711_TEMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "hx711.h"
+
+#define HX711_TEMP_FIT_MIN_SAMPLES 10
+#define HX711_TEMP_FIT_MIN_SPREAD 2.0  // Degrees the capture must cover before it is solved
+
+typedef enum {
+    HX711_TEMP_CAPTURE_OFF,
+    HX711_TEMP_CAPTURE_ZERO,   // Empty pan: fit raw zero against temperature
+    HX711_TEMP_CAPTURE_SPAN    // Constant test load: fit zero-compensated net against temperature
+} hx711_temp_capture_t;
+
+// Least-squares line y = a + b * (t - t0); sums relative to the first temperature
+typedef struct {
+    uint32_t n;
+    double t0;
+    double st, stt, sy, sty;
+    double t_min, t_max;
+} hx711_temp_fit_t;
+
+typedef struct {
+    float ref_temp;     // Calibration temperature (span reference)
+    float tare_temp;    // Temperature of the last tare (zero reference)
+    float zero_tc;      // Raw counts per degree
+    float span_tc;      // Fraction per degree
+
+    float temp;         // Latest temperature
+    bool have_temp;
+    float shift;        // zero_tc * (temp - tare_temp)
+    float gain;         // 1 / (1 + span_tc * (temp - ref_temp))
+
+    hx711_temp_capture_t capture;
+    hx711_temp_fit_t fit;
+} hx711_temp_t;
+
+// Background reader for a millidegree sysfs file
+typedef struct {
+    char path[96];
+    unsigned period_ms;
+    pthread_t thread;
+    atomic_bool running;
+    atomic_long milli;          // Latest reading, millidegrees
+    atomic_uint_fast64_t read_ns; // hx711_time_ns() after that reading, 0 = none yet
+} hx711_temp_reader_t;
+
+/**
+ * @brief Initializes the model; without a temperature it passes samples through.
+ * @param tc Pointer to the model.
+ * @param ref_temp Calibration temperature.
+ * @param tare_temp Temperature the current tare offset was taken at.
+ * @param zero_tc Zero coefficient, raw counts per degree.
+ * @param span_tc Span coefficient, fraction per degree.
+ */
+void hx711_temp_init(hx711_temp_t* tc, float ref_temp, float tare_temp, float zero_tc, float span_tc);
+
+/**
+ * @brief Feeds a new temperature reading and recomputes shift and gain.
+ * @param tc Pointer to the model.
+ * @param celsius Temperature in degrees Celsius.
+ */
+void hx711_temp_set(hx711_temp_t* tc, float celsius);
+
+/**
+ * @brief Forgets the temperature; samples pass through uncompensated until the next hx711_temp_set().
+ * @param tc Pointer to the model.
+ */
+void hx711_temp_clear(hx711_temp_t* tc);
+
+/**
+ * @brief Records that the scale was just tared at the current temperature.
+ * @param tc Pointer to the model.
+ */
+void hx711_temp_tare(hx711_temp_t* tc);
+
+/**
+ * @brief Records that the scale was just calibrated at the current temperature.
+ * @param tc Pointer to the model.
+ */
+void hx711_temp_calibrate(hx711_temp_t* tc);
+
+/**
+ * @brief Compensates one sample.
+ * @param tc Pointer to the model.
+ * @param hx Scale whose tare offset the sample is measured against.
+ * @param raw Raw reading.
+ * @return The reading as it would be at the reference temperatures (raw counts).
+ */
+long hx711_temp_apply(const hx711_temp_t* tc, const hx711_t* hx, long raw);
+
+/**
+ * @brief Starts learning one coefficient; clears the previous capture.
+ * @param tc Pointer to the model.
+ * @param mode What is on the pan during the capture, or HX711_TEMP_CAPTURE_OFF.
+ */
+void hx711_temp_start_capture(hx711_temp_t* tc, hx711_temp_capture_t mode);
+
+/**
+ * @brief Adds a stable, uncompensated reading to the running capture.
+ * @param tc Pointer to the model.
+ * @param hx Scale the reading came from.
+ * @param raw Raw (or filtered raw) reading, not compensated.
+ */
+void hx711_temp_capture(hx711_temp_t* tc, const hx711_t* hx, long raw);
+
+/**
+ * @brief Fits the captured data and updates the coefficient being learned.
+ * @param tc Pointer to the model.
+ * @return 0 on success, -1 with too few samples or too small a temperature swing.
+ */
+int hx711_temp_solve(hx711_temp_t* tc);
+
+/**
+ * @brief Reads a millidegree temperature file (thermal zone, 1-wire "temperature").
+ * @param path Sysfs path, e.g. /sys/class/thermal/thermal_zone0/temp.
+ * @param celsius Receives the temperature in degrees Celsius.
+ * @return 0 on success, -1 if the file could not be read.
+ */
+int hx711_temp_read_sysfs(const char* path, float* celsius);
+
+/**
+ * @brief Starts a thread that reads a sysfs temperature file every period.
+ * @param rd Pointer to the reader.
+ * @param path Sysfs path, read with hx711_temp_read_sysfs().
+ * @param period_ms Time between reads.
+ * @return 0 on success, -1 if the thread could not be started.
+ */
+int hx711_temp_reader_start(hx711_temp_reader_t* rd, const char* path, unsigned period_ms);
+
+/**
+ * @brief Stops the reader thread; waits for a read in progress.
+ * @param rd Pointer to the reader.
+ */
+void hx711_temp_reader_stop(hx711_temp_reader_t* rd);
+
+/**
+ * @brief Latest successful reading, without blocking.
+ * @param rd Pointer to the reader.
+ * @param celsius Receives the temperature in degrees Celsius.
+ * @param read_ns Receives the hx711_time_ns() of the reading.
+ * @return true once a read has succeeded.
+ */
+bool hx711_temp_reader_latest(hx711_temp_reader_t* rd, float* celsius, uint64_t* read_ns);
+
+#endif /* HX711_TEMP_H */
@@ -0,0 +1,82 @@
+/**
+ *
+ * Timing layer for the HX711 clock train
+ *
+ */
+#include "hx711_timing.h"
+#include <time.h>
+
+#define CALIB_ROUNDS      200
+#define CALIB_LOOP_COUNT  100000
+
+static hx711_timing_info_t info;
+
+_Thread_local uint32_t hx711_fast_high_max_ns; // hx711_fast.h
+
+uint64_t hx711_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void spin_loops(uint32_t loops) {
+    for (uint32_t i = 0; i < loops; i++) {
+        __asm__ __volatile__("" ::: "memory");
+    }
+}
+
+void hx711_timing_calibrate(void) {
+    uint64_t best = UINT64_MAX;
+
+    // Cheapest of many back-to-back clock reads
+    for (int i = 0; i < CALIB_ROUNDS; i++) {
+        uint64_t t0 = hx711_time_ns();
+        uint64_t t1 = hx711_time_ns();
+        if (t1 - t0 < best) best = t1 - t0;
+    }
+    info.clock_read_ns = (uint32_t)best;
+
+    // Fastest run of the busy loop, so a preempted round cannot skew it
+    uint64_t loop_ns = UINT64_MAX;
+    for (int i = 0; i < 5; i++) {
+        uint64_t t0 = hx711_time_ns();
+        spin_loops(CALIB_LOOP_COUNT);
+        uint64_t dt = hx711_time_ns() - t0;
+        if (dt < loop_ns) loop_ns = dt;
+    }
+    if (loop_ns == 0) loop_ns = 1;
+    info.loops_per_us = (uint32_t)((CALIB_LOOP_COUNT * 1000ull) / loop_ns);
+    if (info.loops_per_us == 0) info.loops_per_us = 1;
+    info.calibrated = true;
+
+    // Verify a 1 us hold against the clock
+    uint64_t over_sum = 0;
+    for (int i = 0; i < CALIB_ROUNDS; i++) {
+        uint64_t t0 = hx711_time_ns();
+        hx711_spin_delay_ns(1000);
+        uint64_t dt = hx711_time_ns() - t0;
+        if (dt > 1000 + info.clock_read_ns) over_sum += dt - 1000 - info.clock_read_ns;
+    }
+    info.spin_error_ns = (uint32_t)(over_sum / CALIB_ROUNDS);
+}
+
+const hx711_timing_info_t* hx711_timing_info(void) {
+    return &info;
+}
+
+void hx711_spin_delay_ns(unsigned int ns) {
+    // Shorter than two clock reads: count loop iterations instead
+    if (info.calibrated && ns < 2 * info.clock_read_ns) {
+        spin_loops((uint32_t)(((uint64_t)ns * info.loops_per_us) / 1000));
+        return;
+    }
+
+    uint64_t end = hx711_time_ns() + ns;
+    while (hx711_time_ns() < end) {
+        // spin
+    }
+}
+
+void hx711_spin_delay_us(unsigned int us) {
+    hx711_spin_delay_ns(us * 1000u);
+}
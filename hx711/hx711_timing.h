@@ -0,0 +1,57 @@
+/**
+ *
+ * Timing layer for the HX711 clock train
+ *
+ * usleep(1) costs 60-100 us on our boards, which is longer than the chip's
+ * 60 us SCK-high power-down limit. These delays spin on the vDSO
+ * clock_gettime instead, with a calibrated busy loop for holds shorter than
+ * one clock read.
+ *
+ */
+#ifndef HX711_TIMING_H
+#define HX711_TIMING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Result of hx711_timing_calibrate()
+typedef struct {
+    uint32_t clock_read_ns;    // Cost of one clock_gettime(CLOCK_MONOTONIC) call
+    uint32_t loops_per_us;     // Busy-loop iterations per microsecond
+    uint32_t spin_error_ns;    // Mean overshoot of a 1 us hold
+    bool calibrated;
+} hx711_timing_info_t;
+
+/**
+ * @brief Monotonic time in nanoseconds (vDSO, no syscall).
+ * @return CLOCK_MONOTONIC in nanoseconds.
+ */
+uint64_t hx711_time_ns(void);
+
+/**
+ * @brief Measures clock read cost and busy-loop speed. Call once at startup.
+ *
+ * The delays work before calibration, but holds shorter than one clock read
+ * are only accurate afterwards.
+ */
+void hx711_timing_calibrate(void);
+
+/**
+ * @brief Get the calibration results.
+ * @return Pointer to the calibration results.
+ */
+const hx711_timing_info_t* hx711_timing_info(void);
+
+/**
+ * @brief Busy-waits for the given number of nanoseconds.
+ * @param ns Hold time in nanoseconds.
+ */
+void hx711_spin_delay_ns(unsigned int ns);
+
+/**
+ * @brief Busy-waits for the given number of microseconds. Drop-in for hx711_t.delay_us.
+ * @param us Hold time in microseconds.
+ */
+void hx711_spin_delay_us(unsigned int us);
+
+#endif /* HX711_TIMING_H */
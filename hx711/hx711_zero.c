@@ -0,0 +1,123 @@
+/**
+ *
+ * Automatic zero tracking for the HX711 library
+ *
+ */
+#include "hx711_zero.h"
+#include <math.h>
+#include <string.h>
+
+#define BAND_DIV 0.5   // Tracking band, in divisions
+#define RATE_DIV 0.5   // Correction rate, in divisions per second
+
+void hx711_zero_init(hx711_zero_t* z, hx711_t* hx, double division, double range,
+                     double zero_drift, double threshold) {
+    memset(z, 0, sizeof(*z));
+    hx711_zero_set_division(z, division);
+    z->range = range;
+    z->threshold = threshold;
+    z->reference = hx711_get_offset(hx);
+    z->zero_drift = zero_drift;
+    // The alarm flag is not persisted; a saved total past the threshold was already reported
+    z->alarmed = threshold > 0.0 && fabs(zero_drift) > threshold;
+}
+
+void hx711_zero_set_alarm(hx711_zero_t* z, hx711_zero_alarm_func on_alarm, void* ctx) {
+    z->on_alarm = on_alarm;
+    z->ctx = ctx;
+}
+
+void hx711_zero_set_division(hx711_zero_t* z, double division) {
+    z->band = BAND_DIV * fabs(division);
+    z->rate_per_s = RATE_DIV * fabs(division);
+}
+
+void hx711_zero_rebase(hx711_zero_t* z, hx711_t* hx) {
+    z->reference = hx711_get_offset(hx);
+    z->residual = 0.0;
+    z->last_ns = 0;
+}
+
+static void add_drift(hx711_zero_t* z, long applied) {
+    z->zero_drift += (double)applied;
+    if (z->threshold > 0.0 && !z->alarmed && fabs(z->zero_drift) > z->threshold) {
+        z->alarmed = true;
+        if (z->on_alarm) z->on_alarm(z->zero_drift, z->ctx);
+    }
+}
+
+long hx711_zero_power_up(hx711_zero_t* z, hx711_t* hx, long value) {
+    long applied = value - hx711_get_offset(hx);
+
+    hx711_set_offset(hx, value);
+    hx711_zero_rebase(z, hx);
+    if (applied != 0) add_drift(z, applied);
+    return applied;
+}
+
+long hx711_zero_update(hx711_zero_t* z, hx711_t* hx, uint64_t timestamp_ns, long value, bool stable) {
+    long offset = hx711_get_offset(hx);
+    double error = (double)(value - offset);
+
+    if (z->range <= 0.0) return 0;
+
+    // Loaded, moving or outside the band: stop tracking until it is empty again
+    if (!stable || fabs(error) > z->band) {
+        z->last_ns = 0;
+        z->residual = 0.0;
+        return 0;
+    }
+    if (z->last_ns == 0 || timestamp_ns <= z->last_ns) {
+        z->last_ns = timestamp_ns;
+        return 0;
+    }
+
+    double dt = (double)(timestamp_ns - z->last_ns) * 1e-9;
+    double step = z->rate_per_s * dt;
+    z->last_ns = timestamp_ns;
+
+    double want = error - z->residual;
+    if (want > step) want = step;
+    if (want < -step) want = -step;
+
+    // Never walk the zero further than the allowed range from the reference
+    double from_ref = (double)(offset - z->reference) + z->residual + want;
+    if (fabs(from_ref) > z->range) return 0;
+
+    // Apply whole counts; carry the fraction so slow rates still add up
+    z->residual += want;
+    long applied = lround(z->residual);
+    if (applied == 0) return 0;
+    z->residual -= (double)applied;
+
+    hx711_set_offset(hx, offset + applied);
+    add_drift(z, applied);
+    return applied;
+}
+
+long hx711_zero_shift(hx711_zero_t* z, hx711_t* hx, double counts) {
+    long offset = hx711_get_offset(hx);
+    if (z->range <= 0.0) return 0;
+
+    // Clamp to what is left of the range on that side of the reference
+    double from_ref = (double)(offset - z->reference) + z->residual;
+    if (from_ref + counts > z->range) counts = z->range - from_ref;
+    if (from_ref + counts < -z->range) counts = -z->range - from_ref;
+
+    z->residual += counts;
+    long applied = lround(z->residual);
+    if (applied == 0) return 0;
+    z->residual -= (double)applied;
+
+    hx711_set_offset(hx, offset + applied);
+    add_drift(z, applied);
+    return applied;
+}
+
+bool hx711_zero_alarmed(const hx711_zero_t* z) {
+    return z->alarmed;
+}
+
+double hx711_zero_drift(const hx711_zero_t* z) {
+    return z->zero_drift;
+}
@@ -0,0 +1,123 @@
+/**
+ *
+ * Automatic zero tracking for the HX711 library
+ *
+ * Follows slow zero drift while the scale is empty and stable, the way
+ * legal-metrology rules allow it: only inside a band around zero (0.5 d),
+ * at a limited rate (0.5 d per second), and within a total range of the
+ * reference zero (at most 4% of Max). Without a range there is no tracking. Corrections go straight into hx711_t.offset, one sample at
+ * a time, so no extra conversions are read.
+ *
+ * Every correction is added to a running zero_drift total (raw counts, as
+ * stored in config.json). Crossing max_zero_drift_threshold raises the alarm
+ * callback once; a saved total already past it counts as raised.
+ *
+ */
+#ifndef HX711_ZERO_H
+#define HX711_ZERO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hx711.h"
+
+typedef void (*hx711_zero_alarm_func)(double zero_drift, void* ctx);
+
+typedef struct {
+    double band;               // Track only within +/- band of zero (raw counts)
+    double rate_per_s;         // Largest correction per second (raw counts)
+    double range;              // Largest total correction from the reference zero, 0 = no tracking
+    double threshold;          // max_zero_drift_threshold (raw counts), 0 = no alarm
+
+    long reference;            // Zero the drift is measured against
+    double zero_drift;         // Running total of corrections (signed)
+    double residual;           // Fraction of a count not yet applied to the offset
+    uint64_t last_ns;          // Previous tracked sample, 0 = not tracking
+    bool alarmed;
+
+    hx711_zero_alarm_func on_alarm;
+    void* ctx;
+} hx711_zero_t;
+
+/**
+ * @brief Initializes the tracker around the current offset.
+ * @param z Pointer to the tracker.
+ * @param hx Scale whose offset will be tracked.
+ * @param division Scale division in raw counts (band 0.5 d, rate 0.5 d/s).
+ * @param range Total correction allowed from the current zero in raw counts, 0 = no tracking.
+ * @param zero_drift Drift accumulated so far (config "zero_drift").
+ * @param threshold Alarm level (config "max_zero_drift_threshold"), 0 = no alarm.
+ */
+void hx711_zero_init(hx711_zero_t* z, hx711_t* hx, double division, double range,
+                     double zero_drift, double threshold);
+
+/**
+ * @brief Sets the callback raised once when |zero_drift| crosses the threshold.
+ * @param z Pointer to the tracker.
+ * @param on_alarm Callback, or NULL.
+ * @param ctx Passed through to the callback.
+ */
+void hx711_zero_set_alarm(hx711_zero_t* z, hx711_zero_alarm_func on_alarm, void* ctx);
+
+/**
+ * @brief Changes the division (e.g. after calibration).
+ * @param z Pointer to the tracker.
+ * @param division Scale division in raw counts.
+ */
+void hx711_zero_set_division(hx711_zero_t* z, double division);
+
+/**
+ * @brief Takes a manual tare as the new reference zero; the drift total is kept.
+ * @param z Pointer to the tracker.
+ * @param hx Scale that was just tared.
+ */
+void hx711_zero_rebase(hx711_zero_t* z, hx711_t* hx);
+
+/**
+ * @brief Sets the zero at power-up from the settled empty-scale reading.
+ *
+ * The caller decides whether the correction is within its allowed range.
+ * It is added to zero_drift like a tracking correction, so restarts cannot
+ * walk the zero past the alarm threshold unnoticed.
+ * @param z Pointer to the tracker.
+ * @param hx Scale whose offset is set.
+ * @param value Settled raw value of the empty scale.
+ * @return The correction applied to the offset (raw counts).
+ */
+long hx711_zero_power_up(hx711_zero_t* z, hx711_t* hx, long value);
+
+/**
+ * @brief Feeds one sample; corrects the offset when empty and stable.
+ * @param z Pointer to the tracker.
+ * @param hx Scale whose offset is tracked.
+ * @param timestamp_ns Sample time.
+ * @param value Filtered raw value.
+ * @param stable Current state of the stability detector.
+ * @return The correction applied to the offset (raw counts), usually 0.
+ */
+long hx711_zero_update(hx711_zero_t* z, hx711_t* hx, uint64_t timestamp_ns, long value, bool stable);
+
+/**
+ * @brief Moves the zero by a correction another tracker measured (e.g. the
+ *        check-weigher's empty-belt level); range and drift accounting as for tracking.
+ * @param z Pointer to the tracker.
+ * @param hx Scale whose offset is moved.
+ * @param counts Wanted correction in raw counts.
+ * @return The correction applied (raw counts); less than wanted at the edge of the range.
+ */
+long hx711_zero_shift(hx711_zero_t* z, hx711_t* hx, double counts);
+
+/**
+ * @brief Whether the drift total is past the threshold (saved or tracked).
+ * @param z Pointer to the tracker.
+ * @return True once the alarm has been raised or was already due at init.
+ */
+bool hx711_zero_alarmed(const hx711_zero_t* z);
+
+/**
+ * @brief Running drift total.
+ * @param z Pointer to the tracker.
+ * @return Accumulated zero drift in raw counts.
+ */
+double hx711_zero_drift(const hx711_zero_t* z);
+
+#endif /* HX711_ZERO_H */
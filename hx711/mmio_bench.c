@@ -0,0 +1,152 @@
+/**
+ *
+ * Register-level check and clock-out benchmark for hx711_mmio, on the fake bank
+ *
+ * Compile with: gcc -O2 -DHX711_FAST_PULSE_NS=0 mmio_bench.c hx711_mmio.c hx711.c hx711_timing.c hx711_curve.c -o mmio_bench -lpthread -lm
+ *
+ * ./mmio_bench [reads]
+ *     Runs the MMIO backend against the in-memory register file
+ *     (hx711_mmio_open_fake), so it works on any Linux host:
+ *     - checks the stores the backend makes: SCK low and set as output,
+ *       DOUT set as input, the write-enable mask in the upper half-word,
+ *       pins 16-31 in the _H registers, and SCK left low after a read;
+ *     - checks that DOUT strapped low or high reads back as 0 or -1 through
+ *       both the runtime loop and hx711_mmio_read_sample(), and the bulk
+ *       read of a shared-clock group;
+ *     - times hx711_read() through both loops with no holds, in TSC
+ *       cycles on x86 and nanoseconds elsewhere. HX711_FAST_PULSE_NS=0
+ *       drops the specialized loop's spin hold so both loops are timed
+ *       on the same footing; leave it out to see the held loop.
+ *     The fake has no chip behind it, so other bit patterns are left to
+ *     the simulator benchmarks.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "hx711.h"
+#include "hx711_mmio.h"
+#include "hx711_timing.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "cycles"
+static inline uint64_t bench_now(void) { return __rdtsc(); }
+#else
+#define BENCH_UNIT "ns"
+static inline uint64_t bench_now(void) { return hx711_time_ns(); }
+#endif
+
+static hx711_mmio_fake_t fake;
+static int failures;
+
+static void no_delay_us(unsigned int us) { (void)us; }
+static void no_delay_ms(unsigned int ms) { (void)ms; }
+static void no_delay_ns(unsigned int ns) { (void)ns; }
+
+static void check(bool ok, const char* what) {
+    printf("%-52s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static uint32_t reg(uint32_t offset) {
+    return fake.regs[offset / 4];
+}
+
+// Pin setup and single-pin stores for one DOUT/SCK pair. The fake keeps the
+// last store to each word rather than latching pins, so when both pins share
+// a DDR word only the DOUT store (made last) is visible there.
+static void check_pins(int dout, int sck) {
+    char what[64];
+    uint32_t sck_word = sck >= 16 ? 4 : 0, dout_word = dout >= 16 ? 4 : 0;
+    uint32_t sck_bit = 1u << (sck & 15), dout_bit = 1u << (dout & 15);
+
+    hx711_mmio_open_fake(&fake, dout, sck);
+    uint32_t ddr_sck = reg(HX711_MMIO_DDR_L + sck_word);
+    uint32_t ddr_dout = reg(HX711_MMIO_DDR_L + dout_word);
+
+    snprintf(what, sizeof(what), "SCK %d: output, driven low at open", sck);
+    check(hx711_mmio_fake_output(&fake, sck) == 0 &&
+          reg(HX711_MMIO_DR_L + sck_word) == sck_bit << 16 &&
+          (sck_word == dout_word || ddr_sck == ((sck_bit << 16) | sck_bit)), what);
+    snprintf(what, sizeof(what), "DOUT %d: input, masked store", dout);
+    check((ddr_dout & (dout_bit << 16)) && !(ddr_dout & dout_bit), what);
+
+    hx711_mmio_write(sck, 1);
+    snprintf(what, sizeof(what), "SCK %d: one store sets it, mask 0x%08x", sck, (unsigned)(sck_bit << 16));
+    check(hx711_mmio_fake_output(&fake, sck) == 1 &&
+          reg(HX711_MMIO_DR_L + sck_word) == ((sck_bit << 16) | sck_bit), what);
+    hx711_mmio_write(sck, 0);
+
+    hx711_mmio_fake_input(&fake, dout, 1);
+    bool high = hx711_mmio_read(dout) == 1;
+    hx711_mmio_fake_input(&fake, dout, 0);
+    snprintf(what, sizeof(what), "DOUT %d: EXT_PORT bit reads back", dout);
+    check(high && hx711_mmio_read(dout) == 0, what);
+}
+
+static void run(const char* name, hx711_t* hx, int reads) {
+    uint64_t best = UINT64_MAX, sum = 0;
+
+    for (int i = 0; i < reads; i++) {
+        uint64_t t0 = bench_now();
+        long value = hx711_read(hx);
+        uint64_t dt = bench_now() - t0;
+        (void)value;
+        sum += dt;
+        if (dt < best) best = dt;
+    }
+    printf("%-18s min %6llu %s, avg %6llu %s\n", name, (unsigned long long)best, BENCH_UNIT,
+           (unsigned long long)(sum / (uint64_t)reads), BENCH_UNIT);
+}
+
+int main(int argc, char** argv) {
+    int reads = argc >= 2 ? atoi(argv[1]) : 20000;
+    hx711_t hx;
+    uint32_t raw;
+
+    if (reads < 1) reads = 1;
+    check_pins(5, 4);
+    check_pins(20, 17);
+    check_pins(3, 18);
+
+    // Strapped DOUT through the runtime loop and the specialized one
+    hx711_mmio_open_fake(&fake, 5, 4);
+    hx711_backend_t backend = {
+        .gpio_write = hx711_mmio_write,
+        .gpio_read = hx711_mmio_read,
+        .delay_us = no_delay_us,
+        .delay_ms = no_delay_ms,
+    };
+    hx711_init_backend(&hx, 5, 4, &backend);
+    hx711_set_pulse_ns(&hx, no_delay_ns, 0);
+    hx.rt_context = true;
+    hx711_mmio_fake_input(&fake, 5, 0);
+    check(hx711_read(&hx) == 0 && hx711_mmio_fake_output(&fake, 4) == 0, "runtime loop: DOUT low reads 0, SCK left low");
+
+    hx711_mmio_fake_input(&fake, 5, 1);
+    check(hx711_mmio_read_sample(1, &raw) == 0 && raw == 0xFFFFFFu && hx711_mmio_fake_output(&fake, 4) == 0,
+          "specialized loop: DOUT high reads 0xFFFFFF");
+    hx711_mmio_fake_input(&fake, 5, 0);
+    check(hx711_mmio_read_sample(3, &raw) == 0 && raw == 0, "specialized loop: DOUT low reads 0");
+
+    // Shared-clock group: one load, bit i = DOUT pin i
+    int group[3] = { 5, 9, 21 };
+    check(hx711_mmio_bind_bulk(group, 3) == 0, "bulk: bind pins 5, 9, 21");
+    hx711_mmio_fake_input(&fake, 9, 1);
+    hx711_mmio_fake_input(&fake, 21, 1);
+    check(hx711_mmio_read_bulk(&raw) == 0 && raw == 0x6u, "bulk: levels 0,1,1 read as 0x6");
+    hx711_mmio_fake_input(&fake, 9, 0);
+    hx711_mmio_fake_input(&fake, 21, 0);
+
+    printf("\n%d reads per loop, fake bank, no holds, RT context\n", reads);
+    run("runtime loop:", &hx, reads);
+    backend.read_sample = hx711_mmio_read_sample;
+    backend.read_sample_rt = true;
+    hx711_init_backend(&hx, 5, 4, &backend);
+    hx.rt_context = true;
+    run("specialized loop:", &hx, reads);
+
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
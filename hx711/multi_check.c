@@ -0,0 +1,179 @@
+/**
+ *
+ * Shared-clock check for hx711_multi
+ *
+ * Compile with: gcc -O2 multi_check.c hx711_multi.c hx711.c hx711_timing.c hx711_curve.c hx711_sim.c -o multi_check -lpthread -lm
+ *
+ * ./multi_check [reads]
+ *     Drives four behavioural chips on one PD_SCK through the bulk sim
+ *     functions, each with its own conversion period so the slowest one
+ *     gates every read. Each chip's n-th conversion is its corner's base
+ *     value plus n steps, with bases that cover both signs and the 24-bit
+ *     rails, so every read must return one conversion per corner, all from
+ *     the same n, each exactly as the chip produced it:
+ *       values     `reads` reads, every corner exact and simultaneous
+ *       failure    a bulk read that fails mid-train returns -1, leaves raw
+ *                  untouched, and the next read is still in step with the
+ *                  chips (the train was clocked to the end)
+ *       tare       per-corner offsets from hx711_multi_tare()
+ *       units      per-corner scales, the corner weights, their sum and
+ *                  the corner imbalance
+ *       gain       gain 64 reaches every chip (3 pulses after the data)
+ *     A read that leaves the chips out of step waits for data ready that
+ *     never comes; the check gives up after 10 s and reports FAIL.
+ *
+ */
+#include <stdio.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "hx711_multi.h"
+#include "hx711_sim.h"
+
+#define CORNERS 4
+#define STEP 1000L
+
+static const long base[CORNERS] = { 120000L, -80000L, 0x7FFFFFL - 40 * STEP, -0x800000L + 7 };
+static const uint32_t period_ns[CORNERS] = { 1000000u, 1100000u, 1200000u, 1300000u };
+
+typedef struct {
+    long base;
+    long n;          // Conversions produced so far
+} corner_t;
+
+static hx711_sim_t sims[CORNERS];
+static corner_t corners[CORNERS];
+static hx711_multi_t multi;
+static int fail_at = -1;   // Bulk read that fails, counted from the next one; -1 = none
+static int failed;
+
+static long corner_source(void* ctx, uint8_t channel) {
+    corner_t* c = (corner_t*)ctx;
+    (void)channel;
+    return c->base + STEP * c->n++;
+}
+
+static int failing_bulk_read(uint32_t* bits) {
+    if (fail_at >= 0 && fail_at-- == 0) {
+        failed++;
+        return -1;
+    }
+    return hx711_sim_bulk_read(bits);
+}
+
+static void sim_delay_ms(unsigned int ms) {
+    struct timespec ts = { ms / 1000, ms ? (long)(ms % 1000) * 1000000L : 50000L };
+    nanosleep(&ts, NULL);
+}
+
+// A read that leaves a chip mid-train never sees every DOUT low again
+static void on_hang(int sig) {
+    (void)sig;
+    static const char msg[] = "hung waiting for data ready: the chips are out of step\nFAIL\n";
+    write(1, msg, sizeof(msg) - 1);
+    _exit(1);
+}
+
+// Value corner c must give for its n-th conversion, clamped like the chip
+static long expect(int c, long n) {
+    long v = corners[c].base + STEP * n;
+    if (v > 0x7FFFFF) v = 0x7FFFFF;
+    if (v < -0x800000) v = -0x800000;
+    return v;
+}
+
+// One read; every corner must hold its n-th conversion
+static int read_in_step(long n, const char* what) {
+    long raw[CORNERS];
+    if (hx711_multi_read(&multi, raw) != 0) {
+        printf("%s: read failed\n", what);
+        return 1;
+    }
+    for (int c = 0; c < CORNERS; c++) {
+        if (raw[c] != expect(c, n)) {
+            printf("%s: corner %d read %ld, expected %ld (conversion %ld)\n", what, c, raw[c], expect(c, n), n);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int reads = argc >= 2 ? atoi(argv[1]) : 50;
+    int errors = 0;
+    long n = 0;
+
+    if (reads < 1) reads = 50;
+    signal(SIGALRM, on_hang);
+    alarm(10);
+    for (int c = 0; c < CORNERS; c++) {
+        corners[c] = (corner_t){ base[c], 0 };
+        hx711_sim_init(&sims[c], 0, period_ns[c]);
+        hx711_sim_set_source(&sims[c], corner_source, &corners[c]);
+    }
+    hx711_sim_attach_bulk(sims, CORNERS);
+    hx711_multi_init(&multi, CORNERS, 0, hx711_sim_bulk_write, failing_bulk_read, NULL, 0, sim_delay_ms);
+
+    // Values: exact, signed, and from the same conversion on every corner
+    int bad = 0;
+    for (int i = 0; i < reads; i++) bad += read_in_step(n++, "values");
+    printf("values:  %d reads of %d corners, %d wrong\n", reads, CORNERS, bad);
+    errors += bad;
+
+    // Failure mid-train: -1, raw untouched, and the chips still in step
+    long raw[CORNERS] = { 1, 2, 3, 4 };
+    while (!hx711_multi_is_ready(&multi)) sim_delay_ms(0);
+    fail_at = 1 + 6; // The ready check, then the 7th data bit
+    int ret = hx711_multi_read(&multi, raw);
+    n++; // The failed read still clocked that conversion out of every chip
+    bad = ret != -1 || failed != 1 || raw[0] != 1 || raw[1] != 2 || raw[2] != 3 || raw[3] != 4;
+    bad += read_in_step(n++, "after failure");
+    printf("failure: returned %d, raw %s, next read %s\n", ret,
+           raw[0] == 1 && raw[3] == 4 ? "kept" : "overwritten", bad ? "FAILED" : "in step");
+    errors += bad;
+
+    // Tare and units: a fixed input per corner, so the averages are exact
+    static const float scale[CORNERS] = { 400.0f, -380.0f, 410.0f, 395.0f };
+    static const float load_g[CORNERS] = { 1250.0f, 980.0f, 1010.0f, 760.0f };
+    for (int c = 0; c < CORNERS; c++) {
+        hx711_sim_set_source(&sims[c], NULL, NULL);
+        sims[c].value = corners[c].base / 2;
+        hx711_multi_set_scale(&multi, c, scale[c]);
+    }
+    hx711_multi_read(&multi, raw); // Flush the conversion latched before the switch
+    bad = hx711_multi_tare(&multi, 8) != 0;
+    for (int c = 0; c < CORNERS; c++) bad += multi.offset[c] != corners[c].base / 2;
+    printf("tare:    offsets %ld %ld %ld %ld %s\n", multi.offset[0], multi.offset[1], multi.offset[2],
+           multi.offset[3], bad ? "FAILED" : "ok");
+    errors += bad;
+
+    float total_g = 0.0f, units[CORNERS];
+    for (int c = 0; c < CORNERS; c++) {
+        sims[c].value = corners[c].base / 2 + lroundf(load_g[c] * scale[c]);
+        total_g += load_g[c];
+    }
+    hx711_multi_read(&multi, raw);
+    float sum = hx711_multi_get_units(&multi, 4, units);
+    bad = !(fabsf(sum - total_g) < 0.01f);
+    for (int c = 0; c < CORNERS; c++) bad += !(fabsf(units[c] - load_g[c]) < 0.01f);
+    float share[CORNERS];
+    float imbalance = hx711_multi_corner_imbalance(units, CORNERS, share);
+    bad += !(fabsf(imbalance - (load_g[0] / total_g - 0.25f)) < 1e-4f);
+    printf("units:   %.2f + %.2f + %.2f + %.2f = %.2f g (expected %.2f), imbalance %.3f %s\n", units[0], units[1],
+           units[2], units[3], sum, total_g, imbalance, bad ? "FAILED" : "ok");
+    errors += bad;
+
+    // Gain 64: the pulses after the data select channel A/64 on every chip
+    long before[CORNERS];
+    hx711_multi_set_gain(&multi, 64);
+    bad = hx711_multi_read(&multi, before) != 0;
+    bad += hx711_multi_read(&multi, raw) != 0;
+    for (int c = 0; c < CORNERS; c++) bad += sims[c].channel != 3 || raw[c] != before[c];
+    printf("gain:    64 on every chip %s\n", bad ? "FAILED" : "ok");
+    errors += bad;
+
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
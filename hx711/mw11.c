@@ -1,3 +1,13 @@
+/*
+ * Weighing daemon: HX711 acquisition thread, LCD, tare and secure calibration.
+ *
+ * Compile with: gcc mw11.c hx711.c hx711_timing.c hx711_gpiod.c hx711_spi.c hx711_iio.c hx711_mmio.c hx711_filter.c hx711_stable.c hx711_zero.c hx711_curve.c hx711_temp.c hx711_checkweigh.c hx711_dynamic.c hx711_dosing.c hx711_count.c hx711_sim.c lcd.c cJSON.c ../lib/libevent_loop.a ../lib/libtamper_log.a -o mw11 \
+ *               -lgpiod -lpthread -lm -lsqlite3 -lssl -lcrypto
+ *               (run make in ../lib first; it builds both libraries)
+ *
+ * Add -DHX711_FAST_READ to clock the GPIO/MMIO transports through the specialized
+ * loops in hx711_fast.h (no per-bit indirect calls, no pulse-width capture).
+ */
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -6,55 +16,201 @@
 #include <fcntl.h>
 #include <stdbool.h>
 #include <string.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/stat.h>
 #include "hx711.h"
+#include "hx711_timing.h"
+#include "hx711_gpiod.h"
+#include "hx711_spi.h"
+#include "hx711_iio.h"
+#include "hx711_mmio.h"
+#include "hx711_filter.h"
+#include "hx711_stable.h"
+#include "hx711_zero.h"
+#include "hx711_curve.h"
+#include "hx711_temp.h"
+#include "hx711_checkweigh.h"
+#include "hx711_dynamic.h"
+#include "hx711_dosing.h"
+#include "hx711_count.h"
 #include "lcd.h"
 #include "cJSON.h"
 
 // Include Tamper Log Library
 // (Adjust path if your folder structure differs)
 #include "../lib/tamper_logs.h" 
+#include "../lib/event_loop.h"
 
 // --- System Paths ---
 #define CONFIG_JSON_PATH "/home/pico/calibris/data/config.json"
 #define SAFE_MODE_BIN    "/usr/local/bin/activate_safe_mode_bin/activate_safe_mode" // Path to your compiled activator
 
 // --- Calibration Settings ---
-#define CALIB_WEIGHT_MID  500.0f   // 500g
+#define CALIB_MAX_WEIGHTS 8        // Reference weights per calibration (plus the zero point)
+#define CALIB_WEIGHT_MID  500.0f   // 500g, first weight without "capacity"
 #define CALIB_WEIGHT_HIGH 1000.0f  // 1kg
 
+// --- Tare/Calibration Sampling ---
+#define DEFAULT_SAMPLE_SEM 0.05f  // Standard error of the mean to reach, in divisions
+#define DEFAULT_SAMPLE_MIN 8      // Conversions per point, at least
+#define DEFAULT_SAMPLE_MAX 80     // and at most
+
+// --- Check-Weighing ---
+#define DEFAULT_CW_ON_DIVISIONS 20 // Item detection level, in divisions above the empty belt
+#define DEFAULT_CW_EDGE         2  // Samples trimmed from each end of an item window
+#define CW_MIN_PLATEAU          4  // Settled samples an item needs for a verdict
+
+// --- Dynamic Weighing ---
+#define DEFAULT_DYN_LOAD_DIVISIONS 20 // Load present above this many divisions
+#define DEFAULT_DYN_CONFIDENCE  0.95f // Hold once the estimate is this likely within the tolerance
+#define DEFAULT_DYN_BLOCK       10    // Samples per trimmed-mean block (125 ms at 80 SPS)
+#define DYN_MIN_BLOCKS          6     // Blocks per batch of the dynamic error estimate
+
+// --- Dosing ---
+#define DEFAULT_DOSE_FINE_DIVISIONS 20  // Grams the fine feed alone adds, in divisions
+#define DEFAULT_DOSE_LEARN      0.5f    // Share of each cycle's error folded into the preacts
+#define DEFAULT_DOSE_BLANK_MS   300     // Coarse column landing time (valve delay + fall)
+#define DEFAULT_DOSE_SETTLE_MS  500     // Wait after the cut-off before weighing the result
+#define DEFAULT_DOSE_TIMEOUT_S  60      // Longest feeding time
+#define DOSE_DECISION_AVG       2       // Samples averaged for cut-off decisions
+#define DOSE_WEIGH_SAMPLES      8       // Samples averaged for the container and the result
+#define DOSE_SAVE_CHANGE        0.1f    // Grams a preact must move before it is saved again
+#define DOSE_WATCHDOG_MS        300     // No good sample this long during a fill: the feeds are closed
+#define DOSE_WATCHDOG_CHECK_MS  50
+
+// --- Piece Counting ---
+#define DEFAULT_COUNT_REF       10      // Reference quantity, pieces
+#define DEFAULT_COUNT_CV        0.02f   // Assumed piece-to-piece variation
+#define DEFAULT_COUNT_CONFIDENCE 0.999f // Refine the piece weight once a larger count is this likely exact
+#define DEFAULT_COUNT_WINDOW    16      // Samples averaged for a settled count (200 ms at 80 SPS)
+
+// --- Fast Start ---
+#define DEFAULT_BOOT_ZERO_DIVISIONS 4  // Saved zero may be this far off at power-up and still be re-zeroed
+#define BOOT_ZERO_RANGE_OF_MAX  0.02f   // Never further than 2% of Max without a TARE
+#define BOOT_ZERO_OK_DIVISIONS  0.5f    // Closer than this the saved zero stands
+
+// --- Event Loop ---
+#define DISPLAY_PERIOD_MS   250          // LCD refresh and housekeeping tick
+#define BUTTON_DEBOUNCE_NS  200000000ull // Edges closer than this to a press are bounce
+
+// --- Stability Detection ---
+#define DEFAULT_SETTLING_TIME 0.5f // Seconds, when config.json has no "settling_time"
+#define DEFAULT_DIVISION      1.0f // Grams, when config.json has no "division"
+#define RATE_MOTION_DIVISIONS 5.0f // A settled load must move this far before RATE goes back to 80 SPS
+#define RATE_FAST_GROUP       4    // 80 SPS conversions averaged into one filter sample (20 per second)
+#define RATE_HOLD_SAMPLES     32   // Settled at 10 SPS: the shown weight averages up to this many filtered values
+#define RATE_HOLD_MIN         5    // Fewer than this: the detector's settled value is shown
+
+// --- Zero Tracking ---
+#define ZERO_RANGE_OF_MAX     0.04f // Auto-zero may move the zero by at most 4% of Max
+
+// --- Temperature Compensation ---
+#define TEMP_READ_PERIOD_MS   10000 // Sysfs sensors change slowly
+#define TEMP_STALE_MS         60000 // No reading for this long turns compensation off
+
+// --- HX711 Timing ---
+#define SCK_PULSE_NS 500   // Datasheet minimum is 200 ns per SCK phase
+
 // --- Forensic Thresholds (TUNE THESE FOR YOUR HARDWARE) ---
-#define LINEARITY_TOLERANCE    0.10f   // Ratio must be 2.0 +/- 0.1
+#define LINEARITY_TOLERANCE    0.05f   // Each signal ratio to the first weight must match the weight ratio within 5%
 #define CALIB_FACTOR_TOLERANCE 0.15f   // New factor must be within 15% of old factor
-#define MIN_RAW_COUNTS_500G    100000  // Minimum acceptable raw reading for 500g
-                                       // (Prevents using a coin to simulate 500g)
+#define MIN_RAW_COUNTS_PER_G   200.0f  // Minimum acceptable raw reading per gram of the first weight
+                                       // (Prevents using a coin to simulate it; 100000 counts for 500g)
 
 // Structure to hold config values
 typedef struct {
     float calibration_factor;
     long tare_offset;
+    hx711_rt_config_t rt;    // Optional "rt_acquisition", "rt_cpu", "rt_priority"
+    char transport[16];      // Optional "hx711_transport": "gpio" (default), "mmio", "spi" or "iio"
+    char spi_device[64];     // Optional "spi_device"
+    uint32_t spi_speed_hz;   // Optional "spi_speed_hz"
+    int iio_device;          // Optional "iio_device": N in /dev/iio:deviceN
+    char iio_trigger[32];    // Optional "iio_trigger", empty keeps the current trigger
+    uint32_t mmio_base;      // Optional "gpio_mmio_base": physical base of the scale's GPIO bank
+    hx711_filter_chain_t filter; // Optional "filters": [{"type": "hampel", "window": 7, "k": 3}, ...]
+    float settling_time;     // "settling_time": seconds the load must be quiet to count as stable
+    float division;          // Optional "division": display division in grams
+    double zero_drift;       // "zero_drift": auto-zero corrections so far (raw counts)
+    double max_zero_drift;   // "max_zero_drift_threshold" (raw counts)
+    float capacity;          // Optional "capacity": Max of the scale in grams
+    float zero_range;        // Optional "zero_tracking_range": grams auto-zero may move, default 4% of Max, 0 = off
+    float calib_weights[CALIB_MAX_WEIGHTS]; // Optional "calibration_weights": grams, ascending, up to Max
+    int calib_count;         // Default: 1/4, 1/2, 3/4 and all of "capacity", else 500 g and 1 kg
+    int rate_pin;            // Optional "rate_pin": scale-chip line wired to HX711 RATE, -1 = tied off
+    uint32_t channel_b_every; // Optional "channel_b_every": weight conversions per channel-B one, 0 = off
+    hx711_curve_t curve;     // Optional "calibration_curve": [[net_counts, grams], ...], else built from the factor
+    char temp_source[96];    // Optional "temp_source": "channel_b" or a millidegree sysfs file, empty = off
+    hx711_curve_t temp_curve; // "channel_b_temp_curve": [[channel_b_counts, celsius], ...]
+    float temp_ref;          // "temp_ref": calibration temperature
+    float temp_at_tare;      // "temp_at_tare": temperature of the saved tare_offset
+    float temp_zero_tc;      // "temp_zero_tc": raw counts per degree
+    float temp_span_tc;      // "temp_span_tc": span fraction per degree
+    char temp_capture[8];    // Optional "temp_capture": "zero" or "span" learns that coefficient
+    float max_jump;          // Optional "max_jump": largest plausible departure from the recent trend in grams, 0 = off
+    float sample_sem;        // Optional "sample_sem": tare/calibration precision, divisions (standard error)
+    int sample_min;          // Optional "sample_min": fewest conversions per tare/calibration point
+    int sample_max;          // Optional "sample_max": most conversions per tare/calibration point
+    char mode[16];           // Optional "mode": "static" (default), "checkweigh", "dynamic", "dosing" or "counting"
+    float cw_on_level;       // Optional "cw_on_level": grams above the empty belt that mark an item
+    float cw_lower;          // Optional "cw_lower": lowest accepted item weight in grams
+    float cw_upper;          // Optional "cw_upper": highest accepted item weight in grams, 0 = none
+    int cw_edge;             // Optional "cw_edge": samples dropped from each end of an item window
+    char cw_trace[96];       // Optional "cw_trace": file to record "timestamp_ns,grams" to
+    float dyn_min_load;      // Optional "dyn_min_load": grams that count as a load on the platform
+    float dyn_tolerance;     // Optional "dyn_tolerance": grams the held value must be within
+    float dyn_confidence;    // Optional "dyn_confidence": 0..1, confidence at which the value is held
+    int dyn_block;           // Optional "dyn_block": samples per trimmed-mean block
+    char dyn_trace[96];      // Optional "dyn_trace": file to record "timestamp_ns,grams" to
+    float dose_target;       // "dose_target": net grams per fill
+    int dose_coarse_pin;     // "dose_coarse_pin": buttons-chip line driving the coarse feed, -1 = single-speed
+    int dose_fine_pin;       // "dose_fine_pin": buttons-chip line driving the fine feed
+    float dose_fine_band;    // Optional "dose_fine_band": grams the fine feed alone adds
+    float dose_preact;       // "dose_preact": learned fine in-flight, grams (saved by the daemon)
+    float dose_coarse_preact; // "dose_coarse_preact": learned coarse in-flight, grams (saved by the daemon)
+    float dose_learn;        // Optional "dose_learn": 0..1, 0 keeps the preacts fixed
+    int dose_blank_ms;       // Optional "dose_blank_ms": coarse column landing time
+    int dose_settle_ms;      // Optional "dose_settle_ms": wait after the cut-off before weighing
+    int dose_timeout_s;      // Optional "dose_timeout_s": longest feeding time
+    char dose_log[96];       // Optional "dose_log": CSV file the cycles are appended to
+    int count_ref;           // Optional "count_ref": pieces in the reference sample
+    float count_cv;          // Optional "count_cv": expected piece-to-piece variation (sd / piece weight)
+    float count_confidence;  // Optional "count_confidence": 0..1 to refine the piece weight, 0 = never
+    int count_window;        // Optional "count_window": samples averaged for a settled count
+    float count_stable;      // Optional "count_stable": grams of sample spread that still count as settled
+    bool fast_start;         // Optional "fast_start": false waits for the LCD (and a tare without config) before weighing
+    float boot_zero_range;   // Optional "boot_zero_range": grams the saved zero may be off at power-up and still be re-zeroed
+    bool debug;              // Optional "debug": diagnostics and the periodic statistics on stderr
 } config_struct;
 
+// --- Diagnostics ---
+// Silent unless config.json has "debug": true; errors always go to stderr
+static bool debug_enabled;
+#define debug_log(...) do { if (debug_enabled) fprintf(stderr, __VA_ARGS__); } while (0)
+
+// One tare or calibration point
+typedef struct {
+    long mean;
+    double sem_div;   // Standard error of the mean, in divisions
+    uint32_t samples;
+    bool timed_out;   // The conversions stopped before the point was done
+} point_result_t;
+
+// Calibration in use; hx711_t only keeps a pointer to it
+static hx711_curve_t active_curve;
+
 // --- GPIO Globals ---
-struct gpiod_chip* chip_scale;   
+// (DOUT/PD_SCK are owned by the hx711_gpiod backend)
 struct gpiod_chip* chip_buttons; 
-struct gpiod_line* dout_line;
-struct gpiod_line* sck_line;
 struct gpiod_line* tare_line;    // Pin 19
 struct gpiod_line* calib_line;   // Pin 15
 struct gpiod_line* enter_line;   // Pin 14
 
 // --- Helper Functions ---
 
-void my_gpio_write(int pin, int value) {
-    gpiod_line_set_value(sck_line, value);
-}
-
-int my_gpio_read(int pin) {
-    return gpiod_line_get_value(dout_line);
-}
-
 void my_delay_us(unsigned int us) {
-    usleep(us);
+    hx711_spin_delay_us(us); // usleep(1) sleeps 60-100 us on this board
 }
 
 void my_delay_ms(unsigned int ms) {
@@ -89,24 +245,275 @@ void trigger_safe_mode() {
     while(1) { sleep(1); } 
 }
 
+// --- Stability Events ---
+void on_stability_event(const hx711_stable_event_t* ev, void* ctx) {
+    hx711_t* scale = (hx711_t*)ctx;
+    float grams = hx711_raw_to_units(scale, ev->value);
+
+    if (ev->stable) {
+        debug_log("Stable: %.2f g (settled in %llu ms)\n", grams,
+                  (unsigned long long)(ev->settle_ns / 1000000ull));
+    } else {
+        debug_log("Motion from %.2f g\n", grams);
+    }
+}
+
 // --- JSON Config Management ---
-int read_config_json(const char *path, config_struct *out) {
-    FILE *fp = fopen(path, "r");
-    if (!fp) return 1;
-    fseek(fp, 0, SEEK_END);
+
+int json_int(cJSON *obj, const char *key, int fallback) {
+    cJSON *item = cJSON_GetObjectItem(obj, key);
+    return cJSON_IsNumber(item) ? item->valueint : fallback;
+}
+
+float json_float(cJSON *obj, const char *key, float fallback) {
+    cJSON *item = cJSON_GetObjectItem(obj, key);
+    return cJSON_IsNumber(item) ? (float)item->valuedouble : fallback;
+}
+
+bool json_bool(cJSON *obj, const char *key, bool fallback) {
+    cJSON *item = cJSON_GetObjectItem(obj, key);
+    return cJSON_IsBool(item) ? cJSON_IsTrue(item) : fallback;
+}
+
+// Builds the display filter chain; without a valid "filters" array it is
+// the 5-sample box average the display always used
+void read_filter_config(cJSON *filters, hx711_filter_chain_t *chain) {
+    hx711_filter_init(chain);
+
+    cJSON *stage;
+    if (cJSON_IsArray(filters)) {
+        cJSON_ArrayForEach(stage, filters) {
+            cJSON *type = cJSON_GetObjectItem(stage, "type");
+            if (!cJSON_IsString(type)) continue;
+            if (hx711_filter_add_named(chain, type->valuestring,
+                                       json_int(stage, "window", 5), json_float(stage, "k", 3.0f),
+                                       json_int(stage, "shift", 3), json_float(stage, "noise", 100.0f),
+                                       json_float(stage, "drift", 5.0f)) != 0) {
+                fprintf(stderr, "Ignoring filter stage \"%s\"\n", type->valuestring);
+            }
+        }
+    }
+    if (chain->count == 0) hx711_filter_add_moving_average(chain, 5);
+}
+
+// Parses "calibration_curve" pairs; without a usable curve falls back to the single factor
+void read_curve_config(cJSON* points, float factor, hx711_curve_t* curve) {
+    hx711_curve_init(curve);
+    if (cJSON_IsArray(points)) {
+        cJSON* p;
+        cJSON_ArrayForEach(p, points) {
+            cJSON* net = cJSON_GetArrayItem(p, 0);
+            cJSON* grams = cJSON_GetArrayItem(p, 1);
+            if (cJSON_IsNumber(net) && cJSON_IsNumber(grams)) {
+                hx711_curve_add_point(curve, (long)net->valuedouble, (float)grams->valuedouble);
+            }
+        }
+    }
+    if (hx711_curve_build(curve) != 0) {
+        hx711_curve_from_factor(curve, factor);
+    }
+}
+// Reference weights for the secure calibration: the configured list if it
+// has two or more usable entries, else points spread up to Max
+void read_calib_weights(cJSON *weights, float capacity, config_struct *out) {
+    out->calib_count = 0;
+    if (cJSON_IsArray(weights)) {
+        cJSON *w;
+        cJSON_ArrayForEach(w, weights) {
+            if (!cJSON_IsNumber(w)) continue;
+            float grams = (float)w->valuedouble;
+            float last = out->calib_count ? out->calib_weights[out->calib_count - 1] : 0.0f;
+            if (grams <= last || (capacity > 0.0f && grams > capacity) || out->calib_count == CALIB_MAX_WEIGHTS) {
+                fprintf(stderr, "Ignoring calibration weight %.1f g (ascending, up to capacity, at most %d)\n",
+                        grams, CALIB_MAX_WEIGHTS);
+                continue;
+            }
+            out->calib_weights[out->calib_count++] = grams;
+        }
+    }
+    if (out->calib_count >= 2) return;
+
+    if (capacity > 0.0f) {
+        out->calib_count = 4;
+        for (int i = 0; i < 4; i++) out->calib_weights[i] = capacity * (float)(i + 1) / 4.0f;
+    } else {
+        out->calib_count = 2;
+        out->calib_weights[0] = CALIB_WEIGHT_MID;
+        out->calib_weights[1] = CALIB_WEIGHT_HIGH;
+    }
+}
+
+// Values used when config.json is missing or has no such key
+void config_defaults(config_struct *conf) {
+    memset(conf, 0, sizeof(*conf));
+    conf->rt.cpu = -1;
+    conf->rate_pin = -1;
+    conf->division = DEFAULT_DIVISION;
+    conf->sample_sem = DEFAULT_SAMPLE_SEM;
+    conf->sample_min = DEFAULT_SAMPLE_MIN;
+    conf->sample_max = DEFAULT_SAMPLE_MAX;
+    conf->dose_coarse_pin = -1;
+    conf->dose_fine_pin = -1;
+    conf->fast_start = true;
+    conf->boot_zero_range = DEFAULT_BOOT_ZERO_DIVISIONS * DEFAULT_DIVISION;
+    snprintf(conf->transport, sizeof(conf->transport), "gpio");
+    read_calib_weights(NULL, 0.0f, conf);
+}
+
+// Parses the whole of an open config file; NULL if it cannot be read or parsed
+static cJSON *parse_config_file(FILE *fp) {
+    if (fseek(fp, 0, SEEK_END) != 0) return NULL;
     long length = ftell(fp);
+    if (length < 0) return NULL;
     rewind(fp);
-    char *data = malloc(length + 1);
-    fread(data, 1, length, fp);
+
+    char *data = malloc((size_t)length + 1);
+    if (!data) return NULL;
+    if (fread(data, 1, (size_t)length, fp) != (size_t)length) {
+        free(data);
+        return NULL;
+    }
     data[length] = '\0';
-    fclose(fp);
 
     cJSON *j = cJSON_Parse(data);
     free(data);
+    return j;
+}
+
+int read_config_json(const char *path, config_struct *out) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 1;
+    cJSON *j = parse_config_file(fp);
+    fclose(fp);
     if (!j) return 2;
 
     cJSON *calib = cJSON_GetObjectItem(j, "calibration_factor");
     cJSON *tare = cJSON_GetObjectItem(j, "tare_offset");
+    cJSON *rt = cJSON_GetObjectItem(j, "rt_acquisition");
+    cJSON *rt_cpu = cJSON_GetObjectItem(j, "rt_cpu");
+    cJSON *rt_prio = cJSON_GetObjectItem(j, "rt_priority");
+
+    out->rt.enabled = cJSON_IsTrue(rt);
+    out->rt.cpu = cJSON_IsNumber(rt_cpu) ? rt_cpu->valueint : -1;
+    out->rt.priority = cJSON_IsNumber(rt_prio) ? rt_prio->valueint : 0;
+    out->rt.stack_prefault = 0;
+
+    cJSON *transport = cJSON_GetObjectItem(j, "hx711_transport");
+    cJSON *spi_dev = cJSON_GetObjectItem(j, "spi_device");
+    cJSON *spi_hz = cJSON_GetObjectItem(j, "spi_speed_hz");
+
+    snprintf(out->transport, sizeof(out->transport), "%s",
+             cJSON_IsString(transport) ? transport->valuestring : "gpio");
+    snprintf(out->spi_device, sizeof(out->spi_device), "%s",
+             cJSON_IsString(spi_dev) ? spi_dev->valuestring : "/dev/spidev0.0");
+    out->spi_speed_hz = cJSON_IsNumber(spi_hz) ? (uint32_t)spi_hz->valuedouble : HX711_SPI_DEFAULT_HZ;
+
+    cJSON *iio_dev = cJSON_GetObjectItem(j, "iio_device");
+    cJSON *iio_trig = cJSON_GetObjectItem(j, "iio_trigger");
+
+    out->iio_device = cJSON_IsNumber(iio_dev) ? iio_dev->valueint : 0;
+    snprintf(out->iio_trigger, sizeof(out->iio_trigger), "%s",
+             cJSON_IsString(iio_trig) ? iio_trig->valuestring : "");
+
+    cJSON *mmio_base = cJSON_GetObjectItem(j, "gpio_mmio_base");
+    out->mmio_base = cJSON_IsNumber(mmio_base) ? (uint32_t)mmio_base->valuedouble : HX711_MMIO_RV1106_GPIO2_BASE;
+
+    read_filter_config(cJSON_GetObjectItem(j, "filters"), &out->filter);
+    out->settling_time = json_float(j, "settling_time", DEFAULT_SETTLING_TIME);
+    out->division = json_float(j, "division", DEFAULT_DIVISION);
+    out->zero_drift = json_float(j, "zero_drift", 0.0f);
+    out->max_zero_drift = json_float(j, "max_zero_drift_threshold", 0.0f);
+    out->capacity = json_float(j, "capacity", 0.0f);
+    out->zero_range = json_float(j, "zero_tracking_range", ZERO_RANGE_OF_MAX * out->capacity);
+    if (out->capacity > 0.0f && out->zero_range > ZERO_RANGE_OF_MAX * out->capacity) {
+        fprintf(stderr, "zero_tracking_range %.1f g is beyond 4%% of capacity, using %.1f g\n",
+                out->zero_range, ZERO_RANGE_OF_MAX * out->capacity);
+        out->zero_range = ZERO_RANGE_OF_MAX * out->capacity;
+    }
+    if (out->zero_range <= 0.0f) {
+        fprintf(stderr, "Zero tracking off: set \"capacity\" or \"zero_tracking_range\"\n");
+    }
+    read_calib_weights(cJSON_GetObjectItem(j, "calibration_weights"), out->capacity, out);
+    out->rate_pin = json_int(j, "rate_pin", -1);
+
+    // The stability ring holds HX711_STABLE_MAX_WINDOW samples; with RATE wired it fills at 80 SPS
+    int stable_sps = out->rate_pin >= 0 ? HX711_SPS_FAST : HX711_SPS_SLOW;
+    float max_settling = (float)hx711_stable_max_settling(stable_sps);
+    if (out->settling_time > max_settling) {
+        fprintf(stderr, "settling_time %.2f s exceeds the %d-sample window at %d SPS, using %.2f s\n",
+                out->settling_time, HX711_STABLE_MAX_WINDOW, stable_sps, max_settling);
+        out->settling_time = max_settling;
+    }
+    out->channel_b_every = (uint32_t)json_int(j, "channel_b_every", 0);
+
+    cJSON *temp_source = cJSON_GetObjectItem(j, "temp_source");
+    cJSON *temp_capture = cJSON_GetObjectItem(j, "temp_capture");
+    snprintf(out->temp_source, sizeof(out->temp_source), "%s",
+             cJSON_IsString(temp_source) ? temp_source->valuestring : "");
+    snprintf(out->temp_capture, sizeof(out->temp_capture), "%s",
+             cJSON_IsString(temp_capture) ? temp_capture->valuestring : "");
+    out->temp_ref = json_float(j, "temp_ref", 20.0f);
+    out->temp_at_tare = json_float(j, "temp_at_tare", out->temp_ref);
+    out->temp_zero_tc = json_float(j, "temp_zero_tc", 0.0f);
+    out->temp_span_tc = json_float(j, "temp_span_tc", 0.0f);
+    out->max_jump = json_float(j, "max_jump", 0.0f);
+    out->sample_sem = json_float(j, "sample_sem", DEFAULT_SAMPLE_SEM);
+    out->sample_min = json_int(j, "sample_min", DEFAULT_SAMPLE_MIN);
+    out->sample_max = json_int(j, "sample_max", DEFAULT_SAMPLE_MAX);
+
+    cJSON *mode = cJSON_GetObjectItem(j, "mode");
+    cJSON *cw_trace = cJSON_GetObjectItem(j, "cw_trace");
+    snprintf(out->mode, sizeof(out->mode), "%s", cJSON_IsString(mode) ? mode->valuestring : "static");
+    snprintf(out->cw_trace, sizeof(out->cw_trace), "%s", cJSON_IsString(cw_trace) ? cw_trace->valuestring : "");
+    out->cw_on_level = json_float(j, "cw_on_level", DEFAULT_CW_ON_DIVISIONS * out->division);
+    out->cw_lower = json_float(j, "cw_lower", 0.0f);
+    out->cw_upper = json_float(j, "cw_upper", 0.0f);
+    out->cw_edge = json_int(j, "cw_edge", DEFAULT_CW_EDGE);
+
+    cJSON *dyn_trace = cJSON_GetObjectItem(j, "dyn_trace");
+    snprintf(out->dyn_trace, sizeof(out->dyn_trace), "%s", cJSON_IsString(dyn_trace) ? dyn_trace->valuestring : "");
+    out->dyn_min_load = json_float(j, "dyn_min_load", DEFAULT_DYN_LOAD_DIVISIONS * out->division);
+    out->dyn_tolerance = json_float(j, "dyn_tolerance", out->division);
+    out->dyn_confidence = json_float(j, "dyn_confidence", DEFAULT_DYN_CONFIDENCE);
+    out->dyn_block = json_int(j, "dyn_block", DEFAULT_DYN_BLOCK);
+
+    cJSON *dose_log = cJSON_GetObjectItem(j, "dose_log");
+    snprintf(out->dose_log, sizeof(out->dose_log), "%s", cJSON_IsString(dose_log) ? dose_log->valuestring : "");
+    out->dose_target = json_float(j, "dose_target", 0.0f);
+    out->dose_coarse_pin = json_int(j, "dose_coarse_pin", -1);
+    out->dose_fine_pin = json_int(j, "dose_fine_pin", -1);
+    out->dose_fine_band = json_float(j, "dose_fine_band", DEFAULT_DOSE_FINE_DIVISIONS * out->division);
+    out->dose_preact = json_float(j, "dose_preact", 0.0f);
+    out->dose_coarse_preact = json_float(j, "dose_coarse_preact", 0.0f);
+    out->dose_learn = json_float(j, "dose_learn", DEFAULT_DOSE_LEARN);
+    out->dose_blank_ms = json_int(j, "dose_blank_ms", DEFAULT_DOSE_BLANK_MS);
+    out->dose_settle_ms = json_int(j, "dose_settle_ms", DEFAULT_DOSE_SETTLE_MS);
+    out->dose_timeout_s = json_int(j, "dose_timeout_s", DEFAULT_DOSE_TIMEOUT_S);
+
+    out->count_ref = json_int(j, "count_ref", DEFAULT_COUNT_REF);
+    out->count_cv = json_float(j, "count_cv", DEFAULT_COUNT_CV);
+    out->count_confidence = json_float(j, "count_confidence", DEFAULT_COUNT_CONFIDENCE);
+    out->count_window = json_int(j, "count_window", DEFAULT_COUNT_WINDOW);
+    out->count_stable = json_float(j, "count_stable", out->division);
+    out->fast_start = json_bool(j, "fast_start", true);
+    out->boot_zero_range = json_float(j, "boot_zero_range", DEFAULT_BOOT_ZERO_DIVISIONS * out->division);
+    // Anything bigger at power-up is a load left on, or worse: the operator confirms it with TARE
+    float boot_zero_max = out->capacity > 0.0f ? BOOT_ZERO_RANGE_OF_MAX * out->capacity
+                                               : DEFAULT_BOOT_ZERO_DIVISIONS * out->division;
+    if (out->boot_zero_range > boot_zero_max) {
+        fprintf(stderr, "boot_zero_range %.1f g is beyond the power-up zero range, using %.1f g\n",
+                out->boot_zero_range, boot_zero_max);
+        out->boot_zero_range = boot_zero_max;
+    }
+    out->debug = json_bool(j, "debug", false);
+    read_curve_config(cJSON_GetObjectItem(j, "channel_b_temp_curve"), 0.0f, &out->temp_curve);
+    // Channel B is never read with it off, and the IIO driver does not expose it
+    if (strcmp(out->temp_source, "channel_b") == 0 &&
+        (out->channel_b_every == 0 || strcmp(out->transport, "iio") == 0 || !out->temp_curve.built)) {
+        fprintf(stderr, "temp_source \"channel_b\" needs channel_b_every > 0, a channel_b_temp_curve "
+                "and a transport other than iio; temperature compensation off\n");
+        out->temp_source[0] = '\0';
+    }
 
     if (cJSON_IsNumber(calib) && cJSON_IsNumber(tare)) {
         out->calibration_factor = (float)calib->valuedouble;
@@ -115,52 +522,222 @@ int read_config_json(const char *path, config_struct *out) {
         out->calibration_factor = 400.0f; // Default safety
         out->tare_offset = 0;
     }
+    read_curve_config(cJSON_GetObjectItem(j, "calibration_curve"), out->calibration_factor, &out->curve);
     cJSON_Delete(j);
     return 0;
 }
 
-int write_config_json(const char *path, float calibration_factor, long tare_offset) {
+// Sets a number, adding the key if the file does not have it yet
+static void json_set_number(cJSON *obj, const char *key, double value) {
+    if (cJSON_GetObjectItem(obj, key)) {
+        cJSON_ReplaceItemInObject(obj, key, cJSON_CreateNumber(value));
+    } else {
+        cJSON_AddNumberToObject(obj, key, value);
+    }
+}
+
+// Changes some keys of the parsed config.json in place
+typedef void (*config_edit_func)(cJSON *j, const void *ctx);
+
+// config.json as our own last write left it; the inotify event of that write is not an edit
+static struct stat config_self_write;
+
+static bool config_is_self_write(const char *path) {
+    struct stat now;
+    return stat(path, &now) == 0 && now.st_ino == config_self_write.st_ino &&
+           now.st_size == config_self_write.st_size &&
+           now.st_mtim.tv_sec == config_self_write.st_mtim.tv_sec &&
+           now.st_mtim.tv_nsec == config_self_write.st_mtim.tv_nsec;
+}
+
+// Read-modify-write of config.json: every key the edit leaves alone is kept.
+// Returns 0, 1 if the file cannot be opened, 2 if it cannot be read or
+// parsed, 3 if the new contents could not be written.
+static int update_config_json(const char *path, config_edit_func edit, const void *ctx) {
     FILE *fp = fopen(path, "r+");
     if (!fp) return 1;
-    fseek(fp, 0, SEEK_END);
-    long length = ftell(fp);
-    rewind(fp);
-    char *data = malloc(length + 1);
-    fread(data, 1, length, fp);
-    data[length] = '\0';
-
-    cJSON *j = cJSON_Parse(data);
-    free(data);
+    cJSON *j = parse_config_file(fp);
     if (!j) { fclose(fp); return 2; }
 
-    cJSON_ReplaceItemInObject(j, "calibration_factor", cJSON_CreateNumber(calibration_factor));
-    cJSON_ReplaceItemInObject(j, "tare_offset", cJSON_CreateNumber(tare_offset));
+    edit(j, ctx);
 
     char *out = cJSON_Print(j);
-    fseek(fp, 0, SEEK_SET);
-    fwrite(out, 1, strlen(out), fp);
-    fflush(fp);
-    ftruncate(fileno(fp), strlen(out));
-    fclose(fp);
     cJSON_Delete(j);
+    if (!out) { fclose(fp); return 3; }
+
+    size_t len = strlen(out);
+    int ret = 0;
+    if (fseek(fp, 0, SEEK_SET) != 0 || fwrite(out, 1, len, fp) != len || fflush(fp) != 0 ||
+        ftruncate(fileno(fp), (off_t)len) != 0) {
+        ret = 3;
+    }
     free(out);
-    return 0;
+    if (fclose(fp) != 0) ret = 3;
+    if (ret == 0) stat(path, &config_self_write);
+    return ret;
+}
+
+typedef struct {
+    float calibration_factor;
+    long tare_offset;
+    double zero_drift;
+} config_zero_t;
+
+static void edit_calibration(cJSON *j, const void *ctx) {
+    const config_zero_t *c = ctx;
+    json_set_number(j, "calibration_factor", c->calibration_factor);
+    json_set_number(j, "tare_offset", c->tare_offset);
+}
+
+int write_config_json(const char *path, float calibration_factor, long tare_offset) {
+    config_zero_t c = { .calibration_factor = calibration_factor, .tare_offset = tare_offset };
+    return update_config_json(path, edit_calibration, &c);
+}
+
+static void edit_zero(cJSON *j, const void *ctx) {
+    const config_zero_t *c = ctx;
+    json_set_number(j, "tare_offset", c->tare_offset);
+    json_set_number(j, "zero_drift", c->zero_drift);
+}
+
+// Persists the auto-zero state: the tracked offset and the drift total
+int write_config_zero(const char *path, long tare_offset, double zero_drift) {
+    config_zero_t c = { .tare_offset = tare_offset, .zero_drift = zero_drift };
+    return update_config_json(path, edit_zero, &c);
+}
+
+// Persists the calibration points next to the factor written by write_config_json
+static void edit_curve(cJSON *j, const void *ctx) {
+    const hx711_curve_t *curve = ctx;
+    cJSON *points = cJSON_CreateArray();
+    for (int i = 0; i < curve->count; i++) {
+        cJSON *p = cJSON_CreateArray();
+        cJSON_AddItemToArray(p, cJSON_CreateNumber(curve->net[i]));
+        cJSON_AddItemToArray(p, cJSON_CreateNumber(curve->units[i]));
+        cJSON_AddItemToArray(points, p);
+    }
+    if (cJSON_GetObjectItem(j, "calibration_curve")) {
+        cJSON_ReplaceItemInObject(j, "calibration_curve", points);
+    } else {
+        cJSON_AddItemToObject(j, "calibration_curve", points);
+    }
+}
+
+int write_config_curve(const char *path, const hx711_curve_t* curve) {
+    return update_config_json(path, edit_curve, curve);
 }
 
-void perform_tare(hx711_t* scale) {
+// Persists the temperature model: reference points and learned coefficients
+static void edit_temp(cJSON *j, const void *ctx) {
+    const hx711_temp_t *tc = ctx;
+    json_set_number(j, "temp_ref", tc->ref_temp);
+    json_set_number(j, "temp_at_tare", tc->tare_temp);
+    json_set_number(j, "temp_zero_tc", tc->zero_tc);
+    json_set_number(j, "temp_span_tc", tc->span_tc);
+}
+
+int write_config_temp(const char *path, const hx711_temp_t *tc) {
+    return update_config_json(path, edit_temp, tc);
+}
+
+// Persists the learned in-flight compensation of the dosing mode
+typedef struct {
+    float preact;
+    float coarse_preact;
+} config_dose_t;
+
+static void edit_dose(cJSON *j, const void *ctx) {
+    const config_dose_t *d = ctx;
+    json_set_number(j, "dose_preact", d->preact);
+    json_set_number(j, "dose_coarse_preact", d->coarse_preact);
+}
+
+int write_config_dose(const char *path, float preact, float coarse_preact) {
+    config_dose_t d = { .preact = preact, .coarse_preact = coarse_preact };
+    return update_config_json(path, edit_dose, &d);
+}
+
+// --- Zero Drift Alarm ---
+void on_zero_drift_alarm(double zero_drift, void* ctx) {
+    hx711_t* scale = (hx711_t*)ctx;
+    char details[128];
+
+    // Save first, so the tamper record's config snapshot carries the drift
+    write_config_zero(CONFIG_JSON_PATH, hx711_get_offset(scale), zero_drift);
+    snprintf(details, sizeof(details), "Auto-zero drift %.0f counts (%.2f g)",
+             zero_drift, zero_drift / hx711_get_scale(scale));
+    log_tamper("weight_drift", details);
+}
+
+// Samples one point until its mean is known to conf->sample_sem divisions
+point_result_t measure_point(hx711_acq_t* acq, const config_struct* conf, float counts_per_g) {
+    point_result_t pt;
+    hx711_stat_t st;
+    double counts_per_div = fabs((double)conf->division * counts_per_g);
+    if (counts_per_div <= 0.0) counts_per_div = 1.0;
+
+    hx711_stat_reset(&st);
+    pt.timed_out = hx711_acq_collect_sem(acq, conf->sample_sem * counts_per_div,
+                                         (uint32_t)conf->sample_min, (uint32_t)conf->sample_max, &st) != 0;
+    pt.mean = hx711_stat_mean(&st);
+    pt.sem_div = hx711_stat_sem(&st) / counts_per_div;
+    pt.samples = hx711_stat_count(&st);
+    return pt;
+}
+
+// Fewer than sample_min good conversions (a stream of rejects) says nothing about
+// the load, and neither does a point cut short because the conversions stopped
+bool point_ok(const point_result_t* pt, const config_struct* conf) {
+    return !pt->timed_out && pt->samples > 0 && pt->samples >= (uint32_t)conf->sample_min;
+}
+
+// Shows what a point achieved: "n=12 se=0.03d"
+void show_point(const point_result_t* pt) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "n=%u se=%.2fd", (unsigned)pt->samples, pt->sem_div);
+    lcd_set_cursor(1, 0); lcd_send_string("                ");
+    lcd_set_cursor(1, 0); lcd_send_string(buf);
+}
+
+// Returns false when the tare failed and the old zero was kept
+bool perform_tare(hx711_acq_t* acq, const config_struct* conf) {
+    hx711_t* scale = acq->hx;
     lcd_clear();
     lcd_set_cursor(0, 0); lcd_send_string("Re-Taring...");
     lcd_set_cursor(1, 0); lcd_send_string("Do not touch!");
     
-    hx711_tare(scale, 20);
-    long new_offset = hx711_get_offset(scale);
-    write_config_json(CONFIG_JSON_PATH, scale->scale, new_offset);
+    point_result_t zero = measure_point(acq, conf, hx711_get_scale(scale));
+    debug_log("Tare: %u samples, standard error %.3f d%s\n", (unsigned)zero.samples, zero.sem_div,
+              zero.timed_out ? ", conversions stopped" : "");
+    show_point(&zero);
+    if (!point_ok(&zero, conf)) {
+        lcd_set_cursor(0, 0); lcd_send_string("Tare failed     ");
+        my_delay_ms(1500);
+        return false; // Keep the old zero
+    }
+    hx711_set_offset(scale, zero.mean);
+    write_config_json(CONFIG_JSON_PATH, scale->scale, hx711_get_offset(scale));
     
     my_delay_ms(1500);
+    return true;
+}
+
+// A point without enough good conversions: a sensor fault, not tampering, so
+// calibration stops with the old zero and nothing is logged or locked
+bool calibration_short_point(hx711_t* scale, long old_offset, const char* name, const point_result_t* pt) {
+    debug_log("Calibration: %s point has %u good samples%s, aborted\n", name, (unsigned)pt->samples,
+              pt->timed_out ? " (conversions stopped)" : "");
+    hx711_set_offset(scale, old_offset);
+    lcd_clear(); lcd_send_string("ERR: NO READING");
+    lcd_set_cursor(1, 0); lcd_send_string("Check Sensor!");
+    my_delay_ms(3000);
+    return false;
 }
 
 // --- SECURE CALIBRATION FUNCTION ---
-void perform_secure_calibration(hx711_t* scale) {
+bool perform_secure_calibration(hx711_acq_t* acq, const config_struct* conf) {
+    hx711_t* scale = acq->hx;
+    long old_offset = hx711_get_offset(scale);
     lcd_clear();
     lcd_set_cursor(0, 0); lcd_send_string("Secure Calib");
     lcd_set_cursor(1, 0); lcd_send_string("Init Check...");
@@ -180,70 +757,102 @@ void perform_secure_calibration(hx711_t* scale) {
     lcd_set_cursor(1, 0); lcd_send_string("Press Enter...");
     wait_for_enter_button();
     
+    // Points are sampled to a precision in divisions of the old calibration
     lcd_set_cursor(1, 0); lcd_send_string("Measuring Zero..");
-    hx711_tare(scale, 20);
-    long new_offset = hx711_get_offset(scale);
+    point_result_t zero = measure_point(acq, conf, old_factor);
+    show_point(&zero);
+    if (!point_ok(&zero, conf)) return calibration_short_point(scale, old_offset, "zero", &zero);
+    hx711_set_offset(scale, zero.mean);
+    long new_offset = zero.mean;
 
-    // --- Point 2: 500g ---
-    lcd_clear();
-    lcd_set_cursor(0, 0); lcd_send_string("2. Place 500g");
-    lcd_set_cursor(1, 0); lcd_send_string("Press Enter...");
-    wait_for_enter_button();
-    
-    lcd_set_cursor(1, 0); lcd_send_string("Measuring...");
-    long raw_w1 = hx711_read_average(scale, 20);
-    double signal_mid = (double)(raw_w1 - new_offset);
+    // --- Points 2..n: reference weights, lightest first, up to Max ---
+    int n = conf->calib_count;
+    const float *grams = conf->calib_weights;
+    point_result_t pts[CALIB_MAX_WEIGHTS];
+    double signal[CALIB_MAX_WEIGHTS];
 
-    // [SECURITY CHECK 1] Absolute Raw Value Check
-    // Detects "Coin Attacks" (using light objects to fake heavy weights)
-    if (signal_mid < MIN_RAW_COUNTS_500G) {
-        log_tamper("calib_underweight", "Raw signal too low for 500g");
-        lcd_clear(); lcd_send_string("ERR: INVALID WGT");
-        lcd_set_cursor(1, 0); lcd_send_string("Check Sensor!");
-        my_delay_ms(3000);
-        return; // Abort safely (no safe mode, just reject)
-    }
+    // Achieved precision of every point, logged with any check that fails
+    char precision[192];
+    int len = snprintf(precision, sizeof(precision), "[se 0:%.3fd", zero.sem_div);
 
-    float factor1 = (float)signal_mid / CALIB_WEIGHT_MID;
+    for (int i = 0; i < n; i++) {
+        char prompt[17];
+        lcd_clear();
+        snprintf(prompt, sizeof(prompt), "%d. Place %.0fg", i + 2, grams[i]);
+        lcd_set_cursor(0, 0); lcd_send_string(prompt);
+        lcd_set_cursor(1, 0); lcd_send_string("Press Enter...");
+        wait_for_enter_button();
 
-    // --- Point 3: 1000g ---
-    lcd_clear();
-    lcd_set_cursor(0, 0); lcd_send_string("3. Place 1000g");
-    lcd_set_cursor(1, 0); lcd_send_string("Press Enter...");
-    wait_for_enter_button();
-    
-    lcd_set_cursor(1, 0); lcd_send_string("Measuring...");
-    long raw_w2 = hx711_read_average(scale, 20);
-    double signal_high = (double)(raw_w2 - new_offset);
-    float factor2 = (float)signal_high / CALIB_WEIGHT_HIGH;
+        lcd_set_cursor(1, 0); lcd_send_string("Measuring...");
+        pts[i] = measure_point(acq, conf, old_factor);
+        show_point(&pts[i]);
+        if (!point_ok(&pts[i], conf)) {
+            char name[16];
+            snprintf(name, sizeof(name), "%.0fg", grams[i]);
+            return calibration_short_point(scale, old_offset, name, &pts[i]);
+        }
+        signal[i] = (double)(pts[i].mean - new_offset);
+        if (len < (int)sizeof(precision)) {
+            len += snprintf(precision + len, sizeof(precision) - (size_t)len, " %.0f:%.3fd", grams[i], pts[i].sem_div);
+        }
+
+        // [SECURITY CHECK 1] Absolute Raw Value Check
+        // Detects "Coin Attacks" (using light objects to fake heavy weights)
+        if (i == 0 && signal[0] < MIN_RAW_COUNTS_PER_G * grams[0]) {
+            char details[128];
+            snprintf(details, sizeof(details), "Raw signal too low for %.0fg [se 0:%.3fd %.0f:%.3fd]",
+                     grams[0], zero.sem_div, grams[0], pts[0].sem_div);
+            log_tamper("calib_underweight", details);
+            lcd_clear(); lcd_send_string("ERR: INVALID WGT");
+            lcd_set_cursor(1, 0); lcd_send_string("Check Sensor!");
+            my_delay_ms(3000);
+            return false; // Abort safely (no safe mode, just reject)
+        }
+    }
+    if (len < (int)sizeof(precision)) len += snprintf(precision + len, sizeof(precision) - (size_t)len, ", n %u",
+                                                      (unsigned)zero.samples);
+    for (int i = 0; i < n && len < (int)sizeof(precision); i++) {
+        len += snprintf(precision + len, sizeof(precision) - (size_t)len, "/%u", (unsigned)pts[i].samples);
+    }
+    if (len < (int)sizeof(precision)) snprintf(precision + len, sizeof(precision) - (size_t)len, "]");
 
     // [SECURITY CHECK 2] Linearity Ratio
     // Detects "Double Tap" (using same weight twice)
-    double actual_ratio = signal_high / signal_mid;
-    if (fabs(actual_ratio - 2.0) > LINEARITY_TOLERANCE) {
-        char details[128];
-        snprintf(details, sizeof(details), "Linearity Fail: Ratio %.2f", actual_ratio);
-        
-        log_tamper("calib_linearity", details);
-        lcd_clear(); lcd_send_string("TAMPER DETECTED!");
-        lcd_set_cursor(1,0); lcd_send_string("Linearity Err");
-        my_delay_ms(2000);
-        
-        trigger_safe_mode(); // LOCK SYSTEM
-        return; 
+    for (int i = 1; i < n; i++) {
+        double actual_ratio = signal[i] / signal[0];
+        double expected_ratio = (double)grams[i] / grams[0];
+        if (fabs(actual_ratio / expected_ratio - 1.0) > LINEARITY_TOLERANCE) {
+            char details[256];
+            snprintf(details, sizeof(details), "Linearity Fail: %.0fg/%.0fg Ratio %.2f (expected %.2f) %s",
+                     grams[i], grams[0], actual_ratio, expected_ratio, precision);
+
+            log_tamper("calib_linearity", details);
+            lcd_clear(); lcd_send_string("TAMPER DETECTED!");
+            lcd_set_cursor(1,0); lcd_send_string("Linearity Err");
+            my_delay_ms(2000);
+
+            trigger_safe_mode(); // LOCK SYSTEM
+            return false;
+        }
     }
 
     // --- Calculate New Factor ---
-    float new_factor = (factor1 + factor2) / 2.0f;
+    // Least squares through zero, so the heavy points near Max carry the most weight
+    double sw = 0.0, ww = 0.0;
+    for (int i = 0; i < n; i++) {
+        sw += signal[i] * grams[i];
+        ww += (double)grams[i] * grams[i];
+    }
+    float new_factor = (float)(sw / ww);
 
     // [SECURITY CHECK 3] Historical Factor Deviation
     // Detects "Scaling Attack" (using 50g & 100g to fake 500g & 1000g)
     float deviation = fabsf(new_factor - old_factor) / old_factor;
     
     if (deviation > CALIB_FACTOR_TOLERANCE) {
-        char details[128];
-        snprintf(details, sizeof(details), "Drift: Old:%.1f New:%.1f (%.0f%%)", 
-                 old_factor, new_factor, deviation * 100);
+        char details[256];
+        snprintf(details, sizeof(details), "Drift: Old:%.1f New:%.1f (%.0f%%) %s",
+                 old_factor, new_factor, deviation * 100, precision);
         
         log_tamper("calib_sensitivity", details);
         
@@ -252,12 +861,24 @@ void perform_secure_calibration(hx711_t* scale) {
         my_delay_ms(2000);
         
         trigger_safe_mode(); // LOCK SYSTEM
-        return;
+        return false;
     }
 
     // --- Success: Save Data ---
+    // The factor stays the tamper-check reference; the points become the
+    // curve, so a bowed cell reads true at every weight instead of their average
+    hx711_curve_t curve;
+    hx711_curve_init(&curve);
+    hx711_curve_add_point(&curve, 0, 0.0f);
+    for (int i = 0; i < n; i++) hx711_curve_add_point(&curve, (long)signal[i], grams[i]);
+    if (hx711_curve_build(&curve) != 0) hx711_curve_from_factor(&curve, new_factor);
+
     hx711_set_scale(scale, new_factor);
+    active_curve = curve;
+    hx711_set_curve(scale, &active_curve);
     write_config_json(CONFIG_JSON_PATH, new_factor, new_offset);
+    write_config_curve(CONFIG_JSON_PATH, &active_curve);
+    debug_log("Calibration: factor %.2f %s\n", new_factor, precision);
 
     lcd_clear();
     lcd_set_cursor(0, 0); lcd_send_string("Calib Secured!");
@@ -265,10 +886,1001 @@ void perform_secure_calibration(hx711_t* scale) {
     snprintf(buf, 16, "F: %.1f", new_factor);
     lcd_set_cursor(1, 0); lcd_send_string(buf);
     my_delay_ms(3000);
+    return true;
+}
+
+// Engine and event-loop counters for the once-a-minute debug report
+void debug_engine_stats(hx711_acq_t* acq, const EventLoop* loop) {
+    if (!debug_enabled) return;
+    hx711_acq_print_stats(acq, stderr);
+    hx711_acq_print_integrity(acq, stderr);
+    fprintf(stderr, "Event loop: %llu wakeups\n", (unsigned long long)loop->wakeups);
+}
+
+// --- Buttons ---
+// Reads one queued edge; true for a press (rising edge) that is not contact bounce
+bool button_pressed(int fd, uint64_t* last_ns) {
+    struct gpiod_line_event ev;
+    if (gpiod_line_event_read_fd(fd, &ev) != 0) return false;
+
+    uint64_t now = hx711_time_ns();
+    if (ev.event_type != GPIOD_LINE_EVENT_RISING_EDGE || now - *last_ns < BUTTON_DEBOUNCE_NS) return false;
+    *last_ns = now;
+    return true;
+}
+
+// Drops edges queued while a tare or calibration held the loop
+void button_flush(int fd, uint64_t* last_ns) {
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    struct gpiod_line_event ev;
+    while (poll(&pfd, 1, 0) > 0 && gpiod_line_event_read_fd(fd, &ev) == 0) {}
+    *last_ns = hx711_time_ns();
+}
+
+// --- Startup Timing ---
+// Service start to first weight, reported once the first value is on the LCD
+typedef struct {
+    uint64_t process_ns;     // Process start, 0 = unknown
+    uint64_t main_ns;        // main() entered
+    uint64_t config_ns;      // Phase durations
+    uint64_t gpio_ns;
+    uint64_t hx711_ns;       // Transport, timing calibration, acquisition thread start
+    uint64_t lcd_ns;
+} startup_times_t;
+
+static startup_times_t startup;
+
+// CLOCK_BOOTTIME is the clock /proc reports process start times on
+uint64_t boottime_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Field 22 of /proc/self/stat, in clock ticks since boot; 0 if unreadable
+uint64_t process_start_ns(void) {
+    char buf[1024];
+    unsigned long long ticks;
+    long hz = sysconf(_SC_CLK_TCK);
+    FILE* fp = fopen("/proc/self/stat", "r");
+    if (!fp || hz <= 0) {
+        if (fp) fclose(fp);
+        return 0;
+    }
+    size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[n] = '\0';
+
+    // The command name may hold spaces and brackets; the fields follow the last ')'
+    char* p = strrchr(buf, ')');
+    if (!p || sscanf(p + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu",
+                     &ticks) != 1) {
+        return 0;
+    }
+    return ticks * (1000000000ull / (uint64_t)hz);
+}
+
+void print_startup_report(void) {
+    uint64_t now = boottime_ns();
+
+    if (startup.process_ns && startup.process_ns <= startup.main_ns) {
+        debug_log("Startup: first weight %.1f ms after process start, %.1f ms after main\n",
+                  (now - startup.process_ns) / 1e6, (now - startup.main_ns) / 1e6);
+    } else {
+        debug_log("Startup: first weight %.1f ms after main\n", (now - startup.main_ns) / 1e6);
+    }
+    debug_log("Startup: config %.1f ms, GPIO %.1f ms, HX711 %.1f ms, LCD %.1f ms\n", startup.config_ns / 1e6,
+              startup.gpio_ns / 1e6, startup.hx711_ns / 1e6, startup.lcd_ns / 1e6);
+}
+
+// --- Weighing Event Handlers ---
+// State shared by the static weighing handlers
+typedef struct {
+    hx711_acq_t* acq;
+    hx711_t* scale;
+    config_struct* conf;
+    hx711_reader_t reader;
+    hx711_reader_t aux_reader;
+    hx711_sample_t aux_sample;
+    hx711_stable_t stability;
+    hx711_zero_t zero;
+    hx711_temp_t thermal;
+    hx711_temp_reader_t temp_reader;
+    bool temp_from_b;
+    bool temp_from_file;
+    uint64_t temp_ns;        // When the temperature in use was read
+    double saved_drift;
+    uint32_t ticks;          // Display refreshes so far
+    uint64_t tare_press_ns;
+    uint64_t calib_press_ns;
+    char shown[17];          // LCD line 1 as last drawn, empty = redraw
+    long last_value;         // Latest conversion, shown until the filter is primed
+    bool have_value;
+    bool first_shown;        // First weight drawn and the startup time reported
+    bool boot_check;         // Saved zero not yet checked against a settled reading
+    bool provisional_zero;   // No saved zero: the first conversion stands in until then
+    bool zero_unconfirmed;   // Saved zero out of the power-up range: no weight until a TARE
+    bool rate_fast;          // 80 SPS requested
+    bool have_rate_ref;
+    long rate_ref;           // Filtered value when the load last settled
+    long group_sum;          // 80 SPS conversions not yet averaged into a filter sample
+    int group_n;
+    double hold_mean;        // Running mean of the filtered value since settling at 10 SPS
+    int hold_n;
+} weigh_state_t;
+
+// Tare/calibration blocked the loop and may have changed the scale
+void after_blocking_operation(weigh_state_t* st) {
+    float counts_per_div = st->conf->division * fabsf(hx711_get_scale(st->scale));
+
+    lcd_clear(); lcd_send_string("Weight:");
+    st->shown[0] = '\0';
+    hx711_stable_set_division(&st->stability, counts_per_div);
+    hx711_stable_reset(&st->stability, hx711_time_ns());
+    st->group_sum = 0;
+    st->group_n = 0;
+    st->hold_n = 0;
+    hx711_zero_set_division(&st->zero, counts_per_div);
+    hx711_zero_rebase(&st->zero, st->scale);
+}
+
+// Stable: show the settled value, refined by the hold mean at 10 SPS; moving: show the live filtered value
+void draw_weight(weigh_state_t* st) {
+    bool stable = hx711_stable_is_stable(&st->stability);
+    float weight = 0.0f;
+    if (stable && st->hold_n >= RATE_HOLD_MIN) {
+        weight = hx711_raw_to_units(st->scale, lround(st->hold_mean));
+    } else if (stable) {
+        weight = hx711_raw_to_units(st->scale, hx711_stable_last(&st->stability)->value);
+    } else if (st->conf->filter.primed) {
+        weight = hx711_raw_to_units(st->scale, hx711_filter_value(&st->conf->filter));
+    } else if (st->have_value) {
+        weight = hx711_raw_to_units(st->scale, st->last_value);
+    }
+    if (fabsf(weight) < 0.5) weight = 0.0;
+
+    // The I2C backpack is slow; only redraw what changed
+    char lcd_buffer[17];
+    if (st->zero_unconfirmed) {
+        snprintf(lcd_buffer, sizeof(lcd_buffer), "%8s g", "----");
+    } else {
+        snprintf(lcd_buffer, sizeof(lcd_buffer), "%8.2f g %s", weight, stable ? "*" : " ");
+    }
+    if (strcmp(lcd_buffer, st->shown) == 0) return;
+    snprintf(st->shown, sizeof(st->shown), "%s", lcd_buffer);
+    lcd_set_cursor(1, 0); lcd_send_string("                ");
+    lcd_set_cursor(1, 0); lcd_send_string(lcd_buffer);
+}
+
+// Fast start weighs on the saved zero from the first conversion; the first
+// settled reading then confirms it, re-zeroes within boot_zero_range (counted
+// as zero drift, so restarts cannot walk the zero unnoticed) or records the
+// offset and withholds the weight until a tare
+void check_boot_zero(weigh_state_t* st, long settled) {
+    config_struct* conf = st->conf;
+    st->boot_check = false;
+
+    if (st->provisional_zero) {
+        st->provisional_zero = false;
+        hx711_set_offset(st->scale, settled);
+        hx711_zero_rebase(&st->zero, st->scale);
+        debug_log("Boot zero: set from the first settled reading\n");
+        return;
+    }
+
+    float net = hx711_raw_to_units(st->scale, settled);
+    if (fabsf(net) <= BOOT_ZERO_OK_DIVISIONS * conf->division) {
+        debug_log("Boot zero: saved zero confirmed (%+.2f g)\n", net);
+    } else if (fabsf(net) <= conf->boot_zero_range) {
+        long applied = hx711_zero_power_up(&st->zero, st->scale, settled);
+        st->saved_drift = hx711_zero_drift(&st->zero);
+        write_config_zero(CONFIG_JSON_PATH, hx711_get_offset(st->scale), st->saved_drift);
+        debug_log("Boot zero: re-zeroed %+.2f g (%ld counts, drift now %.0f)\n", net, applied, st->saved_drift);
+    } else {
+        char details[128];
+        snprintf(details, sizeof(details), "Power-up reading %.2f g off the saved zero, beyond +/-%.2f g",
+                 net, conf->boot_zero_range);
+        log_tamper("boot_zero", details);
+        debug_log("Boot zero: %s; press TARE\n", details);
+        st->zero_unconfirmed = true;
+        st->shown[0] = '\0';
+        lcd_set_cursor(0, 0); lcd_send_string("Check zero: TARE");
+    }
+}
+
+// Every conversion since the last wakeup goes through the filter chain and the stability detector
+void on_weigh_samples(EventLoop* loop, int fd, uint32_t events, void* ctx) {
+    weigh_state_t* st = (weigh_state_t*)ctx;
+    config_struct* conf = st->conf;
+    hx711_sample_t sample;
+    (void)loop; (void)fd; (void)events;
+
+    while (hx711_acq_poll(st->acq, &st->reader, &sample)) {
+        // Saturated, frozen, clock-overrun and glitch conversions never reach the filters
+        if (sample.flags & HX711_FLAGS_REJECT) continue;
+        if (st->thermal.capture != HX711_TEMP_CAPTURE_OFF && hx711_stable_is_stable(&st->stability)) {
+            hx711_temp_capture(&st->thermal, st->scale, sample.value);
+        }
+        long compensated = hx711_temp_apply(&st->thermal, st->scale, sample.value);
+        if (st->provisional_zero && !st->have_value) {
+            hx711_set_offset(st->scale, compensated);
+            hx711_zero_rebase(&st->zero, st->scale);
+        }
+        st->last_value = compensated;
+        st->have_value = true;
+        // At 80 SPS the filters see the mean of each RATE_FAST_GROUP conversions, so
+        // their windows span the same time at either rate and the noise drops by
+        // sqrt(RATE_FAST_GROUP) instead of rising 1.8x
+        double noise_scale = 1.0;
+        if (sample.sps == HX711_SPS_FAST) {
+            st->group_sum += compensated;
+            if (++st->group_n < RATE_FAST_GROUP) continue;
+            compensated = lround((double)st->group_sum / st->group_n);
+            noise_scale = fmax(1.0, HX711_RATE_NOISE_RATIO / sqrt(RATE_FAST_GROUP));
+        }
+        st->group_sum = 0;
+        st->group_n = 0;
+        long filtered = hx711_filter_push(&conf->filter, compensated);
+        hx711_stable_set_noise_scale(&st->stability, noise_scale);
+        hx711_stable_push(&st->stability, sample.timestamp_ns, filtered);
+        // A move restarts at 80 SPS, so a settled load can afford the long average
+        if (hx711_stable_is_stable(&st->stability) && sample.sps == HX711_SPS_SLOW) {
+            if (st->hold_n < RATE_HOLD_SAMPLES) st->hold_n++;
+            st->hold_mean += (filtered - st->hold_mean) / st->hold_n;
+        } else {
+            st->hold_n = 0;
+        }
+        if (st->boot_check && hx711_stable_is_stable(&st->stability)) {
+            check_boot_zero(st, hx711_stable_last(&st->stability)->value);
+        }
+        hx711_zero_update(&st->zero, st->scale, sample.timestamp_ns, filtered,
+                          hx711_stable_is_stable(&st->stability));
+    }
+
+    // The first conversion goes on the LCD now rather than on the next tick
+    if (st->have_value && !st->first_shown) {
+        st->first_shown = true;
+        draw_weight(st);
+        print_startup_report();
+    }
+
+    while (hx711_acq_aux_poll(st->acq, &st->aux_reader, &st->aux_sample)) {
+        if (st->temp_from_b) {
+            hx711_temp_set(&st->thermal, hx711_curve_eval(&conf->temp_curve, st->aux_sample.value));
+            st->temp_ns = hx711_time_ns();
+        }
+    }
+
+    // 10 SPS once settled; back to 80 SPS only for a real move, not for a
+    // noise-level exit from stability, so the rate cannot flap on a still load.
+    // Filter and detector state carry over; the thread drops the unsettled conversions
+    // and a partial 80 SPS group is discarded.
+    long now_filtered = hx711_filter_value(&conf->filter);
+    if (hx711_stable_is_stable(&st->stability)) {
+        st->rate_fast = false;
+        st->rate_ref = now_filtered;
+        st->have_rate_ref = true;
+    } else if (!st->have_rate_ref || labs(now_filtered - st->rate_ref) >
+               RATE_MOTION_DIVISIONS * conf->division * fabsf(hx711_get_scale(st->scale))) {
+        st->rate_fast = true;
+    }
+    hx711_acq_request_rate(st->acq, st->rate_fast ? HX711_SPS_FAST : HX711_SPS_SLOW);
+
+    // Persist the tracked zero once it has moved a full division since the last save
+    if (fabs(hx711_zero_drift(&st->zero) - st->saved_drift) >= conf->division * fabsf(hx711_get_scale(st->scale))) {
+        st->saved_drift = hx711_zero_drift(&st->zero);
+        write_config_zero(CONFIG_JSON_PATH, hx711_get_offset(st->scale), st->saved_drift);
+    }
+}
+
+void on_display_tick(EventLoop* loop, int fd, uint32_t events, void* ctx) {
+    weigh_state_t* st = (weigh_state_t*)ctx;
+    (void)fd; (void)events;
+    st->ticks++;
+
+    // Acquisition overhead/jitter report, once a minute
+    if (st->ticks % (60000 / DISPLAY_PERIOD_MS) == 0) {
+        debug_engine_stats(st->acq, loop);
+        if (st->thermal.have_temp) debug_log("Temperature: %.2f C\n", st->thermal.temp);
+    }
+
+    // The sysfs reader thread does the slow part; take its latest value
+    float celsius;
+    uint64_t read_ns;
+    if (st->temp_from_file && hx711_temp_reader_latest(&st->temp_reader, &celsius, &read_ns) &&
+        read_ns != st->temp_ns) {
+        hx711_temp_set(&st->thermal, celsius);
+        st->temp_ns = read_ns;
+    }
+    // A sensor that stopped answering must not keep correcting with an old temperature
+    if (st->thermal.have_temp && hx711_time_ns() - st->temp_ns > TEMP_STALE_MS * 1000000ull) {
+        hx711_temp_clear(&st->thermal);
+        debug_log("Temperature: no reading for %d s, compensation off\n", TEMP_STALE_MS / 1000);
+    }
+
+    // Capture: refit every five minutes and keep the coefficient once the swing is wide enough
+    if (st->thermal.capture != HX711_TEMP_CAPTURE_OFF && st->ticks % (300000 / DISPLAY_PERIOD_MS) == 0 &&
+        hx711_temp_solve(&st->thermal) == 0) {
+        debug_log("Temperature fit: zero %.3f counts/C, span %.6f /C\n", st->thermal.zero_tc, st->thermal.span_tc);
+        write_config_temp(CONFIG_JSON_PATH, &st->thermal);
+    }
+
+    draw_weight(st);
+}
+
+void on_tare_button(EventLoop* loop, int fd, uint32_t events, void* ctx) {
+    weigh_state_t* st = (weigh_state_t*)ctx;
+    (void)loop; (void)events;
+    if (!button_pressed(fd, &st->tare_press_ns)) return;
+
+    if (perform_tare(st->acq, st->conf)) {
+        st->boot_check = false;
+        st->provisional_zero = false;
+        st->zero_unconfirmed = false;
+        hx711_temp_tare(&st->thermal);
+        write_config_temp(CONFIG_JSON_PATH, &st->thermal);
+    }
+    after_blocking_operation(st);
+    button_flush(fd, &st->tare_press_ns);
+}
+
+void on_calib_button(EventLoop* loop, int fd, uint32_t events, void* ctx) {
+    weigh_state_t* st = (weigh_state_t*)ctx;
+    (void)loop; (void)events;
+    if (!button_pressed(fd, &st->calib_press_ns)) return;
+
+    if (perform_secure_calibration(st->acq, st->conf)) {
+        st->boot_check = false;
+        st->provisional_zero = false;
+        st->zero_unconfirmed = false;
+        hx711_temp_calibrate(&st->thermal);
+        write_config_temp(CONFIG_JSON_PATH, &st->thermal);
+    }
+    after_blocking_operation(st);
+    button_flush(fd, &st->calib_press_ns);
+}
+
+// config.json was rewritten by another tool: take the settings that are safe to change live.
+// Calibration, tare and transport only change through the buttons or a restart.
+void on_config_changed(EventLoop* loop, int fd, uint32_t events, void* ctx) {
+    weigh_state_t* st = (weigh_state_t*)ctx;
+    config_struct* conf = st->conf;
+    static config_struct fresh;
+    (void)loop; (void)fd; (void)events;
+
+    if (config_is_self_write(CONFIG_JSON_PATH)) return;
+    config_defaults(&fresh);
+    if (read_config_json(CONFIG_JSON_PATH, &fresh) != 0) return;
+
+    if (fresh.division == conf->division && fresh.sample_sem == conf->sample_sem &&
+        fresh.sample_min == conf->sample_min && fresh.sample_max == conf->sample_max) {
+        return;
+    }
+    conf->division = fresh.division;
+    conf->sample_sem = fresh.sample_sem;
+    conf->sample_min = fresh.sample_min;
+    conf->sample_max = fresh.sample_max;
+
+    float counts_per_div = conf->division * fabsf(hx711_get_scale(st->scale));
+    hx711_stable_set_division(&st->stability, counts_per_div);
+    hx711_zero_set_division(&st->zero, counts_per_div);
+    debug_log("Config reloaded: division %.3f g, sampling %.3f div (%d..%d)\n", conf->division, conf->sample_sem,
+              conf->sample_min, conf->sample_max);
+}
+
+// --- Mode Skeleton ---
+// What the conveyor, dynamic, dosing and counting modes share: the sample
+// stream, the two buttons, a two-line display and the statistics once a
+// minute. Each mode's state starts with a weigh_mode_t and fills in the
+// hooks it needs; NULL hooks are left out.
+typedef struct weigh_mode_s weigh_mode_t;
+struct weigh_mode_s {
+    hx711_acq_t* acq;
+    config_struct* conf;
+    hx711_reader_t reader;
+    FILE* trace;             // Flushed with the statistics
+    uint64_t tare_press_ns;
+    uint64_t calib_press_ns;
+    char shown[2][17];       // LCD lines as last drawn
+
+    void (*on_sample)(weigh_mode_t* m, const hx711_sample_t* sample); // Every good conversion
+    const char* (*busy)(weigh_mode_t* m);     // Why a tare must wait, or NULL
+    void (*after_tare)(weigh_mode_t* m);
+    void (*on_calib)(weigh_mode_t* m);        // Calibrate button; NULL leaves it unused
+    void (*draw)(weigh_mode_t* m, char lines[2][17]); // NULL: the mode draws the LCD itself
+    void (*on_stats)(weigh_mode_t* m);
+};
+
+// After a blocking operation: a fresh display, and no backlog of samples from before it
+void mode_restart(weigh_mode_t* m) {
+    hx711_acq_reader_init(m->acq, &m->reader);
+    lcd_clear();
+    m->shown[0][0] = m->shown[1][0] = '\0';
+}
+
+void on_mode_samples(EventLoop* loop, int fd, uint32_t events, void* ctx) {
+    weigh_mode_t* m = (weigh_mode_t*)ctx;
+    hx711_sample_t sample;
+    (void)loop; (void)fd; (void)events;
+
+    while (hx711_acq_poll(m->acq, &m->reader, &sample)) {
+        if (sample.flags & HX711_FLAGS_REJECT) continue;
+        m->on_sample(m, &sample);
+    }
+}
+
+void on_mode_tare(EventLoop* loop, int fd, uint32_t events, void* ctx) {
+    weigh_mode_t* m = (weigh_mode_t*)ctx;
+    const char* busy = m->busy ? m->busy(m) : NULL;
+    (void)loop; (void)events;
+    if (!button_pressed(fd, &m->tare_press_ns)) return;
+    if (busy) {
+        debug_log("Tare ignored: %s\n", busy);
+        return;
+    }
+
+    perform_tare(m->acq, m->conf);
+    mode_restart(m);
+    if (m->after_tare) m->after_tare(m);
+    button_flush(fd, &m->tare_press_ns);
+}
+
+// The mode decides what the button means while it is busy (dosing: stop the fill)
+void on_mode_calib(EventLoop* loop, int fd, uint32_t events, void* ctx) {
+    weigh_mode_t* m = (weigh_mode_t*)ctx;
+    (void)loop; (void)events;
+    if (!button_pressed(fd, &m->calib_press_ns)) return;
+
+    m->on_calib(m);
+    button_flush(fd, &m->calib_press_ns);
+}
+
+// The I2C backpack is slow; only rows that changed are redrawn
+void on_mode_display(EventLoop* loop, int fd, uint32_t events, void* ctx) {
+    weigh_mode_t* m = (weigh_mode_t*)ctx;
+    char lines[2][17];
+    (void)loop; (void)fd; (void)events;
+
+    m->draw(m, lines);
+    for (int row = 0; row < 2; row++) {
+        if (strcmp(lines[row], m->shown[row]) == 0) continue;
+        snprintf(m->shown[row], sizeof(m->shown[row]), "%s", lines[row]);
+        lcd_set_cursor(row, 0); lcd_send_string("                ");
+        lcd_set_cursor(row, 0); lcd_send_string(lines[row]);
+    }
+}
+
+void on_mode_stats(EventLoop* loop, int fd, uint32_t events, void* ctx) {
+    weigh_mode_t* m = (weigh_mode_t*)ctx;
+    (void)fd; (void)events;
+
+    debug_engine_stats(m->acq, loop);
+    if (m->on_stats) m->on_stats(m);
+    if (m->trace) fflush(m->trace);
+}
+
+// Registers the mode's handlers and runs the loop; samples_fd < 0 when the
+// mode takes its samples through the acquisition hook instead
+int run_mode(EventLoop* loop, weigh_mode_t* m, int samples_fd, int tare_fd, int calib_fd) {
+    hx711_acq_reader_init(m->acq, &m->reader);
+
+    if ((m->on_sample && event_loop_add_counter(loop, samples_fd, on_mode_samples, m) != 0) ||
+        event_loop_add_fd(loop, tare_fd, EPOLLIN, on_mode_tare, m) != 0 ||
+        (m->on_calib && event_loop_add_fd(loop, calib_fd, EPOLLIN, on_mode_calib, m) != 0) ||
+        (m->draw && event_loop_add_timer(loop, DISPLAY_PERIOD_MS, on_mode_display, m) < 0) ||
+        event_loop_add_timer(loop, 60000, on_mode_stats, m) < 0) {
+        perror("Event loop");
+        return 1;
+    }
+    return event_loop_run(loop) == 0 ? 0 : 1;
+}
+
+// --- Check-Weighing Mode ---
+const char* cw_verdict_text(hx711_cw_verdict_t verdict) {
+    switch (verdict) {
+    case HX711_CW_ACCEPT: return "OK";
+    case HX711_CW_UNDER:  return "UNDER";
+    case HX711_CW_OVER:   return "OVER";
+    default:              return "NO READ";
+    }
+}
+
+void on_checkweigh_item(const hx711_cw_item_t* item, void* ctx) {
+    (void)ctx;
+    char buf[17];
+
+    debug_log("Item %u: %.2f g, %s (%u/%u samples, sd %.2f g, %llu ms%s)\n", (unsigned)item->index, item->weight,
+              cw_verdict_text(item->verdict), (unsigned)item->plateau, (unsigned)item->samples, item->sd,
+              (unsigned long long)((item->end_ns - item->start_ns) / 1000000ull), item->truncated ? ", truncated" : "");
+
+    snprintf(buf, sizeof(buf), "#%-6u %s", (unsigned)item->index, cw_verdict_text(item->verdict));
+    lcd_set_cursor(0, 0); lcd_send_string("                ");
+    lcd_set_cursor(0, 0); lcd_send_string(buf);
+    snprintf(buf, sizeof(buf), "%10.1f g", item->weight);
+    lcd_set_cursor(1, 0); lcd_send_string("                ");
+    lcd_set_cursor(1, 0); lcd_send_string(buf);
+}
+
+// Weighs items passing over the plate on a conveyor; replaces the static
+// display loop. Every conversion is used, at 80 SPS when RATE is wired.
+typedef struct {
+    weigh_mode_t mode;
+    hx711_checkweigh_t cw;
+    hx711_zero_t zero;
+    double saved_drift;
+} checkweigh_state_t;
+
+void checkweigh_sample(weigh_mode_t* m, const hx711_sample_t* sample) {
+    checkweigh_state_t* st = (checkweigh_state_t*)m;
+    hx711_t* hx = m->acq->hx;
+
+    float grams = hx711_raw_to_units(hx, sample->value);
+    if (m->trace) fprintf(m->trace, "%llu,%.3f\n", (unsigned long long)sample->timestamp_ns, grams);
+    hx711_checkweigh_push(&st->cw, sample->timestamp_ns, grams);
+
+    // The empty-belt level moves the zero itself, so it stays within zero_range
+    // of the tare and every move is counted as zero drift (and can raise the alarm)
+    if (!st->cw.on && st->cw.have_baseline) {
+        float counts_per_g = hx711_get_scale(hx);
+        long applied = hx711_zero_shift(&st->zero, hx, st->cw.baseline * counts_per_g);
+        if (applied != 0) hx711_checkweigh_shift_baseline(&st->cw, -(float)applied / counts_per_g);
+    }
+
+    // Persist the zero once it has moved a full division since the last save
+    if (fabs(hx711_zero_drift(&st->zero) - st->saved_drift) >= m->conf->division * fabsf(hx711_get_scale(hx))) {
+        st->saved_drift = hx711_zero_drift(&st->zero);
+        write_config_zero(CONFIG_JSON_PATH, hx711_get_offset(hx), st->saved_drift);
+    }
+}
+
+// Tare and calibration only between items
+const char* checkweigh_busy(weigh_mode_t* m) {
+    return ((checkweigh_state_t*)m)->cw.on ? "item on the plate" : NULL;
+}
+
+// The belt level and the zero reference are learned again after a tare or calibration
+void checkweigh_after_tare(weigh_mode_t* m) {
+    checkweigh_state_t* st = (checkweigh_state_t*)m;
+
+    hx711_zero_set_division(&st->zero, m->conf->division * fabsf(hx711_get_scale(m->acq->hx)));
+    hx711_zero_rebase(&st->zero, m->acq->hx);
+    hx711_checkweigh_reset(&st->cw);
+    lcd_send_string("Check-weighing");
+}
+
+void checkweigh_calib(weigh_mode_t* m) {
+    if (checkweigh_busy(m)) {
+        debug_log("Calibration ignored: item on the plate\n");
+        return;
+    }
+    perform_secure_calibration(m->acq, m->conf);
+    mode_restart(m);
+    checkweigh_after_tare(m);
+}
+
+void checkweigh_stats(weigh_mode_t* m) {
+    hx711_checkweigh_t* cw = &((checkweigh_state_t*)m)->cw;
+
+    debug_log("Check-weighing: %u items, %u accepted, %u under, %u over, %u not weighed\n",
+              (unsigned)cw->items, (unsigned)cw->verdicts[HX711_CW_ACCEPT], (unsigned)cw->verdicts[HX711_CW_UNDER],
+              (unsigned)cw->verdicts[HX711_CW_OVER], (unsigned)cw->verdicts[HX711_CW_NO_PLATEAU]);
+}
+
+int run_checkweigh(EventLoop* loop, hx711_acq_t* acq, config_struct* conf, int samples_fd, int tare_fd,
+                   int calib_fd) {
+    static checkweigh_state_t st;
+
+    st.mode = (weigh_mode_t){ .acq = acq, .conf = conf, .on_sample = checkweigh_sample, .busy = checkweigh_busy,
+                              .after_tare = checkweigh_after_tare, .on_calib = checkweigh_calib,
+                              .on_stats = checkweigh_stats };
+    hx711_checkweigh_init(&st.cw, conf->cw_on_level, conf->cw_lower, conf->cw_upper, conf->division,
+                          on_checkweigh_item, NULL);
+    hx711_checkweigh_set_window(&st.cw, (uint16_t)conf->cw_edge, CW_MIN_PLATEAU);
+    // Past what the zero may take up, the belt level follows by one division at most
+    hx711_checkweigh_set_baseline_limit(&st.cw, conf->division);
+
+    float counts_per_g = fabsf(hx711_get_scale(acq->hx));
+    hx711_zero_init(&st.zero, acq->hx, conf->division * counts_per_g, conf->zero_range * counts_per_g,
+                    conf->zero_drift, conf->max_zero_drift);
+    hx711_zero_set_alarm(&st.zero, on_zero_drift_alarm, acq->hx);
+    st.saved_drift = conf->zero_drift;
+
+    if (conf->cw_trace[0] && !(st.mode.trace = fopen(conf->cw_trace, "w"))) perror("cw_trace");
+
+    if (acq->rate_write) {
+        hx711_acq_request_rate(acq, HX711_SPS_FAST);
+    } else {
+        fprintf(stderr, "Check-weighing without \"rate_pin\": tie RATE high for 80 SPS\n");
+    }
+
+    lcd_clear(); lcd_send_string("Check-weighing");
+    return run_mode(loop, &st.mode, samples_fd, tare_fd, calib_fd);
+}
+
+// --- Dynamic Weighing Mode ---
+typedef struct {
+    weigh_mode_t mode;
+    hx711_dynamic_t dyn;
+    float live;              // Latest sample, for the display while no load is present
+} dynamic_state_t;
+
+void on_dynamic_event(const hx711_dyn_event_t* ev, void* ctx) {
+    (void)ctx;
+    if (ev->held) {
+        debug_log("Held %.2f g +/- %.2f g (%.0f%%) after %.2f s\n", ev->value, ev->sem, 100.0f * ev->confidence,
+                  ev->elapsed_ns / 1e9);
+    } else {
+        debug_log("Released\n");
+    }
+}
+
+void dynamic_sample(weigh_mode_t* m, const hx711_sample_t* sample) {
+    dynamic_state_t* st = (dynamic_state_t*)m;
+
+    st->live = hx711_raw_to_units(m->acq->hx, sample->value);
+    if (m->trace) fprintf(m->trace, "%llu,%.3f\n", (unsigned long long)sample->timestamp_ns, st->live);
+    hx711_dynamic_push(&st->dyn, sample->timestamp_ns, st->live);
+}
+
+// Line 0: state and confidence; line 1: held value, running estimate or live load
+void dynamic_draw(weigh_mode_t* m, char lines[2][17]) {
+    dynamic_state_t* st = (dynamic_state_t*)m;
+    hx711_dynamic_t* dyn = &st->dyn;
+
+    if (hx711_dynamic_is_held(dyn)) {
+        const hx711_dyn_event_t* held = hx711_dynamic_last(dyn);
+        snprintf(lines[0], sizeof(lines[0]), "HOLD        %3.0f%%", 100.0f * held->confidence);
+        snprintf(lines[1], sizeof(lines[1]), "%8.2f g H", held->value);
+    } else if (dyn->present && dyn->count > 0) {
+        snprintf(lines[0], sizeof(lines[0]), "Weighing    %3.0f%%", 100.0f * dyn->confidence);
+        snprintf(lines[1], sizeof(lines[1]), "%8.2f g", dyn->estimate);
+    } else {
+        snprintf(lines[0], sizeof(lines[0]), "Dynamic");
+        snprintf(lines[1], sizeof(lines[1]), "%8.2f g", fabsf(st->live) < 0.5f ? 0.0f : st->live);
+    }
+}
+
+void dynamic_after_tare(weigh_mode_t* m) {
+    hx711_dynamic_reset(&((dynamic_state_t*)m)->dyn);
+}
+
+// Weighs loads that never settle (livestock, swinging sacks) and holds the
+// result once it is confident enough; replaces the static display loop.
+int run_dynamic(EventLoop* loop, hx711_acq_t* acq, config_struct* conf, int samples_fd, int tare_fd) {
+    static dynamic_state_t st;
+
+    st.mode = (weigh_mode_t){ .acq = acq, .conf = conf, .on_sample = dynamic_sample,
+                              .after_tare = dynamic_after_tare, .draw = dynamic_draw };
+    hx711_dynamic_init(&st.dyn, conf->dyn_min_load, conf->dyn_tolerance, conf->dyn_confidence,
+                       on_dynamic_event, NULL);
+    hx711_dynamic_set_window(&st.dyn, (uint16_t)conf->dyn_block, DYN_MIN_BLOCKS);
+
+    if (conf->dyn_trace[0] && !(st.mode.trace = fopen(conf->dyn_trace, "w"))) perror("dyn_trace");
+
+    // The estimator wants every conversion; 80 SPS when RATE is wired
+    hx711_acq_request_rate(acq, HX711_SPS_FAST);
+
+    lcd_clear();
+    return run_mode(loop, &st.mode, samples_fd, tare_fd, -1);
+}
+
+// --- Dosing Mode ---
+// The controller runs on the acquisition thread through the sample hook, so
+// the feed is cut within one conversion of the weight reaching the cut-off;
+// the event loop only starts cycles, logs them and draws the display.
+typedef struct {
+    weigh_mode_t mode;
+    hx711_dosing_t dose;
+    struct gpiod_line* coarse_line;
+    struct gpiod_line* fine_line;
+    FILE* log;
+    uint32_t seen;
+    hx711_dose_cycle_t last;      // Latest finished cycle, for the display
+    float saved_preact;
+    float saved_coarse_preact;
+    uint64_t ready_ns;            // Data-ready time of the sample being pushed (acquisition thread)
+    _Atomic uint32_t lat_max_ns;  // Data-ready to valve command, worst so far
+    _Atomic uint64_t good_ns;     // Time of the latest good conversion, for the watchdog
+    pthread_mutex_t feed_lock;    // Valve writes: acquisition thread, or the event loop stopping a fill
+    _Atomic bool halted;          // Feeds held closed until the next start; set under feed_lock
+} dosing_state_t;
+
+static dosing_state_t dosing = { .feed_lock = PTHREAD_MUTEX_INITIALIZER };
+
+// Drives the valve lines; caller holds feed_lock
+static void set_feeds(dosing_state_t* st, bool coarse, bool fine) {
+    if (st->coarse_line) {
+        gpiod_line_set_value(st->coarse_line, coarse);
+        if (st->fine_line) gpiod_line_set_value(st->fine_line, fine);
+    } else if (st->fine_line) {
+        // Single-speed feeder: the one valve runs through both phases
+        gpiod_line_set_value(st->fine_line, coarse || fine);
+    }
+}
+
+// Valve outputs; runs on the acquisition thread. The lock is only ever
+// contended by a stop, so it costs the cut-off nothing in normal running.
+void dosing_output(bool coarse, bool fine, void* ctx) {
+    dosing_state_t* st = (dosing_state_t*)ctx;
+
+    pthread_mutex_lock(&st->feed_lock);
+    if (atomic_load_explicit(&st->halted, memory_order_relaxed)) coarse = fine = false;
+    set_feeds(st, coarse, fine);
+    pthread_mutex_unlock(&st->feed_lock);
+    if (st->ready_ns) {
+        uint64_t lat = hx711_time_ns() - st->ready_ns;
+        if (lat > atomic_load_explicit(&st->lat_max_ns, memory_order_relaxed)) {
+            atomic_store_explicit(&st->lat_max_ns, (uint32_t)lat, memory_order_relaxed);
+        }
+    }
+}
+
+// Stops a fill from the event loop: both feeds close now rather than at the
+// next sample, which may never come, and stay closed until the next start
+// even if the acquisition thread has not yet seen the abort
+void dosing_halt(dosing_state_t* st, const char* why) {
+    pthread_mutex_lock(&st->feed_lock);
+    atomic_store_explicit(&st->halted, true, memory_order_relaxed);
+    set_feeds(st, false, false);
+    pthread_mutex_unlock(&st->feed_lock);
+    hx711_dosing_abort(&st->dose);
+    debug_log("Dosing stopped: %s\n", why);
+}
+
+// Sample hook: every conversion goes straight into the controller; one that
+// failed the integrity checks is skipped, and a run of them faults the fill
+void dosing_on_sample(const hx711_sample_t* sample, void* ctx) {
+    dosing_state_t* st = (dosing_state_t*)ctx;
+    st->ready_ns = sample->ready_ns;
+    if (sample->flags & HX711_FLAGS_REJECT) {
+        hx711_dosing_reject(&st->dose, sample->timestamp_ns);
+        return;
+    }
+    atomic_store_explicit(&st->good_ns, sample->timestamp_ns, memory_order_relaxed);
+    hx711_dosing_push(&st->dose, sample->timestamp_ns, hx711_raw_to_units(st->mode.acq->hx, sample->value));
+}
+
+// Claims the feeder outputs and installs the hook; before the acquisition thread starts
+int setup_dosing(hx711_acq_t* acq, config_struct* conf) {
+    dosing_state_t* st = &dosing;
+
+    st->mode.acq = acq;
+    st->mode.conf = conf;
+    if (conf->dose_coarse_pin >= 0) st->coarse_line = gpiod_chip_get_line(chip_buttons, conf->dose_coarse_pin);
+    if (conf->dose_fine_pin >= 0) st->fine_line = gpiod_chip_get_line(chip_buttons, conf->dose_fine_pin);
+    if (!st->fine_line ||
+        gpiod_line_request_output(st->fine_line, "dose_fine", 0) != 0 ||
+        (st->coarse_line && gpiod_line_request_output(st->coarse_line, "dose_coarse", 0) != 0)) {
+        fprintf(stderr, "Dosing needs \"dose_fine_pin\" (and optionally \"dose_coarse_pin\") on the buttons chip\n");
+        return -1;
+    }
+
+    hx711_dosing_init(&st->dose, conf->dose_fine_band, dosing_output, st);
+    hx711_dosing_set_learning(&st->dose, conf->dose_learn, 10.0f * conf->dose_fine_band + conf->dose_target / 2.0f);
+    hx711_dosing_set_preact(&st->dose, conf->dose_preact, conf->dose_coarse_preact);
+    hx711_dosing_set_timing(&st->dose, DOSE_DECISION_AVG, DOSE_WEIGH_SAMPLES,
+                            (uint64_t)conf->dose_blank_ms * 1000000ull, (uint64_t)conf->dose_settle_ms * 1000000ull,
+                            (uint64_t)conf->dose_timeout_s * 1000000000ull);
+    st->saved_preact = st->dose.preact;
+    st->saved_coarse_preact = st->dose.coarse_preact;
+    hx711_acq_set_sample_hook(acq, dosing_on_sample, st);
+    return 0;
+}
+
+static const char* dose_state_text(hx711_dose_state_t state) {
+    switch (state) {
+    case HX711_DOSE_TARE:   return "Taring";
+    case HX711_DOSE_COARSE: return "Coarse";
+    case HX711_DOSE_FINE:   return "Fine";
+    case HX711_DOSE_SETTLE: return "Settling";
+    case HX711_DOSE_FAULT:  return "FAULT";
+    default:                return "Ready";
+    }
+}
+
+void dosing_log_cycle(dosing_state_t* st, const hx711_dose_cycle_t* c) {
+    debug_log("Dose #%u: %.2f g of %.2f g (%+.2f g), cut at %.2f g, preact %.2f g, coarse %.2f g, "
+              "fill %.2f s, cycle %.2f s%s\n", (unsigned)c->index, c->actual, c->target, c->overshoot, c->cut_weight,
+              c->preact, c->coarse_preact, c->fill_ns / 1e9, c->cycle_ns / 1e9, c->fault ? ", FAULT" : "");
+    if (!st->log) return;
+    fprintf(st->log, "%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%d\n", (unsigned)c->index, c->target, c->actual,
+            c->overshoot, c->cut_weight, c->coarse_cut, c->coarse_inflight, c->preact, c->coarse_preact,
+            c->cycle_ns / 1e9, c->fault ? 1 : 0);
+    fflush(st->log);
+}
+
+// Line 0: state and target; line 1: net fill, or the last result when idle
+void dosing_draw(weigh_mode_t* m, char lines[2][17]) {
+    dosing_state_t* st = (dosing_state_t*)m;
+    hx711_dose_state_t state = hx711_dosing_state(&st->dose);
+    hx711_dose_cycle_t c;
+
+    while (hx711_dosing_poll_cycle(&st->dose, &st->seen, &c)) {
+        dosing_log_cycle(st, &c);
+        st->last = c;
+    }
+
+    // Stopped from here but not yet seen by the acquisition thread (it may have stalled)
+    bool stopped = atomic_load_explicit(&st->halted, memory_order_relaxed) && state != HX711_DOSE_IDLE &&
+                   state != HX711_DOSE_FAULT;
+    snprintf(lines[0], sizeof(lines[0]), "%-8s%6.1f g", stopped ? "Stopped" : dose_state_text(state),
+             m->conf->dose_target);
+    if (state == HX711_DOSE_COARSE || state == HX711_DOSE_FINE || state == HX711_DOSE_SETTLE) {
+        snprintf(lines[1], sizeof(lines[1]), "%8.2f g", hx711_dosing_net(&st->dose));
+    } else if (st->seen > 0) {
+        snprintf(lines[1], sizeof(lines[1]), "#%-5u%8.2f g", (unsigned)st->last.index, st->last.actual);
+    } else {
+        lines[1][0] = '\0';
+    }
+}
+
+// Calibrate button: start a fill, or stop the running one
+void dosing_start(weigh_mode_t* m) {
+    dosing_state_t* st = (dosing_state_t*)m;
+    hx711_dose_state_t state = hx711_dosing_state(&st->dose);
+
+    if (state == HX711_DOSE_IDLE || state == HX711_DOSE_FAULT) {
+        pthread_mutex_lock(&st->feed_lock);
+        atomic_store_explicit(&st->halted, false, memory_order_relaxed);
+        pthread_mutex_unlock(&st->feed_lock);
+        hx711_dosing_start(&st->dose, m->conf->dose_target);
+    } else {
+        dosing_halt(st, "button");
+    }
+}
+
+// Tare zeroes the display between fills; each fill nets out its container anyway
+const char* dosing_busy(weigh_mode_t* m) {
+    hx711_dose_state_t state = hx711_dosing_state(&((dosing_state_t*)m)->dose);
+    return state != HX711_DOSE_IDLE && state != HX711_DOSE_FAULT ? "fill running" : NULL;
+}
+
+// The controller only acts when a sample arrives; if they stop coming (chip
+// gone, engine stalled) or all fail the checks, the feeds would stay as they are
+void on_dosing_watchdog(EventLoop* loop, int fd, uint32_t events, void* ctx) {
+    dosing_state_t* st = (dosing_state_t*)ctx;
+    (void)loop; (void)fd; (void)events;
+
+    if (!dosing_busy(&st->mode) || atomic_load_explicit(&st->halted, memory_order_relaxed)) return;
+    uint64_t good_ns = atomic_load_explicit(&st->good_ns, memory_order_relaxed);
+    if (hx711_time_ns() - good_ns < DOSE_WATCHDOG_MS * 1000000ull) return;
+    dosing_halt(st, "no good sample");
+}
+
+// Statistics, and the learned preacts saved once they have moved
+void dosing_stats(weigh_mode_t* m) {
+    dosing_state_t* st = (dosing_state_t*)m;
+
+    debug_log("Dosing: %u cycles, data-ready to valve command max %.1f us\n", (unsigned)st->seen,
+              atomic_load_explicit(&st->lat_max_ns, memory_order_relaxed) / 1e3);
+
+    // The preacts belong to the acquisition thread while a fill runs
+    if (dosing_busy(m)) return;
+    float preact = st->dose.preact, coarse_preact = st->dose.coarse_preact;
+    if (fabsf(preact - st->saved_preact) < DOSE_SAVE_CHANGE &&
+        fabsf(coarse_preact - st->saved_coarse_preact) < DOSE_SAVE_CHANGE) return;
+    if (write_config_dose(CONFIG_JSON_PATH, preact, coarse_preact) == 0) {
+        st->saved_preact = preact;
+        st->saved_coarse_preact = coarse_preact;
+    }
+}
+
+// Fills containers to dose_target with a coarse/fine feeder; replaces the
+// static display loop. setup_dosing() must have run before acquisition started.
+int run_dosing(EventLoop* loop, hx711_acq_t* acq, config_struct* conf, int tare_fd, int calib_fd) {
+    dosing_state_t* st = &dosing;
+
+    st->mode.busy = dosing_busy;
+    st->mode.on_calib = dosing_start;
+    st->mode.draw = dosing_draw;
+    st->mode.on_stats = dosing_stats;
+    if (conf->dose_log[0]) {
+        st->log = fopen(conf->dose_log, "a");
+        if (!st->log) {
+            perror("dose_log");
+        } else if (ftell(st->log) == 0) {
+            fprintf(st->log, "cycle,target,actual,overshoot,cut_weight,coarse_cut,coarse_inflight,"
+                             "preact,coarse_preact,cycle_s,fault\n");
+        }
+    }
+
+    // Every conversion counts towards the cut-off latency; 80 SPS when RATE is wired
+    hx711_acq_request_rate(acq, HX711_SPS_FAST);
+
+    if (event_loop_add_timer(loop, DOSE_WATCHDOG_CHECK_MS, on_dosing_watchdog, st) < 0) {
+        perror("Event loop");
+        return 1;
+    }
+
+    lcd_clear();
+    int ret = run_mode(loop, &st->mode, -1, tare_fd, calib_fd);
+    hx711_acq_stop(acq);
+    dosing_output(false, false, st);
+    return ret;
+}
+
+// --- Piece Counting Mode ---
+typedef struct {
+    weigh_mode_t mode;
+    hx711_count_t counter;
+    float live;              // Latest sample, for the display without a reference
+} counting_state_t;
+
+void counting_sample(weigh_mode_t* m, const hx711_sample_t* sample) {
+    counting_state_t* st = (counting_state_t*)m;
+
+    st->live = hx711_raw_to_units(m->acq->hx, sample->value);
+    if (hx711_count_push(&st->counter, st->live)) {
+        debug_log("Piece weight refined on %u pieces: %.4f g (+/- %.4f g)\n", (unsigned)st->counter.ref_pieces,
+                  st->counter.apw, sqrtf(st->counter.apw_var));
+    }
+}
+
+// Line 0: count and how likely it is exact; line 1: 95% bound and piece weight
+void counting_draw(weigh_mode_t* m, char lines[2][17]) {
+    counting_state_t* st = (counting_state_t*)m;
+    hx711_count_result_t r;
+
+    if (hx711_count_get(&st->counter, &r) != 0) {
+        snprintf(lines[0], sizeof(lines[0]), "Place %d pcs", m->conf->count_ref);
+        snprintf(lines[1], sizeof(lines[1]), "%8.2f g", fabsf(st->live) < 0.5f ? 0.0f : st->live);
+    } else if (r.stable) {
+        snprintf(lines[0], sizeof(lines[0]), "%6ld pcs%5.1f%%", r.count, 100.0f * r.confidence);
+        snprintf(lines[1], sizeof(lines[1]), "+/-%-4.0f %6.3fg", ceilf(r.bound), st->counter.apw);
+    } else {
+        snprintf(lines[0], sizeof(lines[0]), "%6ld pcs     ~", r.count);
+        snprintf(lines[1], sizeof(lines[1]), "         %6.3fg", st->counter.apw);
+    }
+}
+
+// Calibrate button: the settled load is the reference quantity; on an empty
+// platform it forgets the reference instead
+void counting_reference(weigh_mode_t* m) {
+    counting_state_t* st = (counting_state_t*)m;
+
+    if (fabsf(st->live) < 3.0f * m->conf->count_stable) {
+        hx711_count_clear_reference(&st->counter);
+        debug_log("Counting reference cleared\n");
+    } else if (hx711_count_set_reference(&st->counter, (uint32_t)m->conf->count_ref) == 0) {
+        debug_log("Counting reference: %d pieces, %.4f g each (+/- %.4f g)\n", m->conf->count_ref,
+                  st->counter.apw, sqrtf(st->counter.apw_var));
+    } else {
+        debug_log("Counting reference not taken: load not settled\n");
+        lcd_set_cursor(0, 0); lcd_send_string("Not settled     ");
+        m->shown[0][0] = '\0';
+    }
+}
+
+void counting_after_tare(weigh_mode_t* m) {
+    hx711_count_flush(&((counting_state_t*)m)->counter);
+}
+
+// Counts pieces from a reference sample, refining the piece weight as more
+// are added; replaces the static display loop.
+int run_counting(EventLoop* loop, hx711_acq_t* acq, config_struct* conf, int samples_fd, int tare_fd,
+                 int calib_fd) {
+    static counting_state_t st;
+
+    st.mode = (weigh_mode_t){ .acq = acq, .conf = conf, .on_sample = counting_sample,
+                              .after_tare = counting_after_tare, .on_calib = counting_reference,
+                              .draw = counting_draw };
+    if (conf->count_ref < 1) conf->count_ref = 1;
+    hx711_count_init(&st.counter, (uint16_t)conf->count_window, conf->count_stable, conf->count_cv,
+                     conf->count_confidence);
+
+    // Counts follow the full-rate stream; 80 SPS when RATE is wired
+    hx711_acq_request_rate(acq, HX711_SPS_FAST);
+
+    lcd_clear();
+    return run_mode(loop, &st.mode, samples_fd, tare_fd, calib_fd);
 }
 
 // --- Main Program ---
 int main() {
+    startup.main_ns = boottime_ns();
+    startup.process_ns = process_start_ns();
+    uint64_t phase_ns = startup.main_ns;
+
     // GPIO Config
     const char* chipname_scale = "gpiochip2";
     const char* chipname_buttons = "gpiochip1";
@@ -281,78 +1893,226 @@ int main() {
     const char* I2C_BUS = "/dev/i2c-3";
     const int I2C_ADDR = 0x27;
 
-    // Init GPIO
-    chip_scale = gpiod_chip_open_by_name(chipname_scale);
+    // Load Config
+    config_struct conf;
+    config_defaults(&conf);
+    bool have_conf = read_config_json(CONFIG_JSON_PATH, &conf) == 0;
+    debug_enabled = conf.debug;
+    bool use_spi = strcmp(conf.transport, "spi") == 0;
+    bool use_iio = strcmp(conf.transport, "iio") == 0;
+    bool use_mmio = strcmp(conf.transport, "mmio") == 0;
+    startup.config_ns = boottime_ns() - phase_ns;
+    phase_ns = boottime_ns();
+
+    // Init GPIO (DOUT falling-edge events so the acquisition thread sleeps between conversions)
+    // With the spidev transport PD_SCK belongs to SPI SCLK and DOUT is also wired to MISO;
+    // with the IIO transport the kernel driver owns both lines
+    if (!use_iio && hx711_gpiod_open(chipname_scale, DOUT_PIN, use_spi ? -1 : SCK_PIN, true) != 0) { perror("GPIO Error"); return 1; }
     chip_buttons = gpiod_chip_open_by_name(chipname_buttons);
-    if (!chip_scale || !chip_buttons) { perror("GPIO Error"); return 1; }
+    if (!chip_buttons) { perror("GPIO Error"); return 1; }
 
-    dout_line = gpiod_chip_get_line(chip_scale, DOUT_PIN);
-    sck_line = gpiod_chip_get_line(chip_scale, SCK_PIN);
     tare_line = gpiod_chip_get_line(chip_buttons, TARE_PIN);
     calib_line = gpiod_chip_get_line(chip_buttons, CALIB_PIN);
     enter_line = gpiod_chip_get_line(chip_buttons, ENTER_PIN);
 
-    gpiod_line_request_input(dout_line, "hx711_dout");
-    gpiod_line_request_output(sck_line, "hx711_sck", 0);
-    gpiod_line_request_input(tare_line, "tare_btn");
-    gpiod_line_request_input(calib_line, "calib_btn");
+    // Tare and calibrate are edge sources for the event loop; enter is polled inside the calibration dialog
+    if (gpiod_line_request_rising_edge_events(tare_line, "tare_btn") != 0 ||
+        gpiod_line_request_rising_edge_events(calib_line, "calib_btn") != 0) {
+        perror("GPIO Error"); return 1;
+    }
     gpiod_line_request_input(enter_line, "enter_btn");
+    startup.gpio_ns = boottime_ns() - phase_ns;
 
-    // Init LCD
-    if (lcd_init(I2C_BUS, I2C_ADDR) != 0) {
-        fprintf(stderr, "LCD Init Failed\n");
-        return 1;
+    // Fast start brings the LCD up while the first conversions run
+    if (!conf.fast_start) {
+        phase_ns = boottime_ns();
+        if (lcd_init(I2C_BUS, I2C_ADDR) != 0) {
+            fprintf(stderr, "LCD Init Failed\n");
+            return 1;
+        }
+        lcd_clear(); lcd_send_string("System Start...");
+        startup.lcd_ns = boottime_ns() - phase_ns;
     }
-    lcd_clear(); lcd_send_string("System Start...");
+    phase_ns = boottime_ns();
 
     // Init HX711
     hx711_t scale;
-    hx711_init(&scale, DOUT_PIN, SCK_PIN, my_gpio_write, my_gpio_read, my_delay_us, my_delay_ms);
+    hx711_backend_t backend = {
+        .gpio_write = hx711_gpiod_write,
+        .gpio_read = hx711_gpiod_read,
+        .delay_us = my_delay_us,
+        .delay_ms = my_delay_ms,
+        .wait_ready = hx711_gpiod_has_events() ? hx711_gpiod_wait_ready : NULL,
+    };
+#ifdef HX711_FAST_READ
+    backend.read_sample = hx711_gpiod_read_sample;
+    backend.read_sample_rt = true;
+#endif
+    if (use_mmio) {
+        // gpiod keeps the line requests and DOUT edge events; only the clock-out bypasses it
+        if (hx711_mmio_open(conf.mmio_base, DOUT_PIN, SCK_PIN) != 0) return 1;
+        backend.gpio_write = hx711_mmio_write;
+        backend.gpio_read = hx711_mmio_read;
+#ifdef HX711_FAST_READ
+        backend.read_sample = hx711_mmio_read_sample;
+#endif
+    }
+    if (use_spi) {
+        if (hx711_spi_open(conf.spi_device, conf.spi_speed_hz) != 0) return 1;
+        backend.gpio_write = NULL;
+        backend.read_sample = hx711_spi_read_sample;
+        backend.read_sample_rt = false;
+    }
+    if (use_iio) {
+        hx711_iio_config_t iio = {
+            .device = conf.iio_device,
+            .channel = 0,
+            .trigger = conf.iio_trigger[0] ? conf.iio_trigger : NULL,
+        };
+        if (hx711_iio_open(&iio) != 0) return 1;
+        backend.gpio_write = NULL;
+        backend.gpio_read = NULL; // The buffer read is the only readiness signal; never poll
+        backend.wait_ready = hx711_iio_wait_ready;
+        backend.read_sample = hx711_iio_read_sample;
+        backend.read_sample_rt = false;
+    }
+    hx711_timing_calibrate();
+    hx711_init_backend(&scale, DOUT_PIN, SCK_PIN, &backend);
+    hx711_set_pulse_ns(&scale, hx711_spin_delay_ns, SCK_PULSE_NS);
+    hx711_capture_timing(&scale, !backend.read_sample);
+    if (have_conf && conf.max_jump > 0.0f) {
+        hx711_set_integrity_limits(&scale, (long)(conf.max_jump * fabsf(conf.calibration_factor)),
+                                   HX711_FROZEN_REPEATS);
+    }
 
-    // Load Config
-    config_struct conf;
-    if (read_config_json(CONFIG_JSON_PATH, &conf) == 0) {
+    // From here on the acquisition thread owns the chip
+    static hx711_acq_t acq;
+
+    // RATE under software control: 80 SPS while the load moves, 10 SPS once settled.
+    // Fast start begins at 80 SPS so the first weight is one short conversion away
+    if (conf.rate_pin >= 0 && !use_iio) {
+        if (hx711_gpiod_open_rate(chipname_scale, conf.rate_pin, 0) == 0) {
+            hx711_acq_set_rate_pin(&acq, hx711_gpiod_write_rate, conf.rate_pin,
+                                   conf.fast_start ? HX711_SPS_FAST : HX711_SPS_SLOW);
+        } else {
+            perror("HX711 RATE line unavailable, fixed rate");
+        }
+    }
+    // Channel B (thermistor / excitation divider) sampled between weight conversions
+    if (conf.channel_b_every > 0 && !use_iio) {
+        hx711_acq_set_channel_b(&acq, conf.channel_b_every);
+    }
+    // Dosing runs its controller on the acquisition thread; the hook goes in before it starts
+    bool dosing_mode = have_conf && strcmp(conf.mode, "dosing") == 0;
+    if (dosing_mode && setup_dosing(&acq, &conf) != 0) return 1;
+
+    // The main thread sleeps in epoll; the engine posts this eventfd per sample
+    int samples_fd = hx711_acq_notify_fd(&acq);
+    if (samples_fd < 0) { perror("HX711 sample eventfd"); return 1; }
+
+    // The saved calibration is in place before the first conversion
+    if (have_conf) {
         hx711_set_scale(&scale, conf.calibration_factor);
         hx711_set_offset(&scale, conf.tare_offset);
+        active_curve = conf.curve;
+        hx711_set_curve(&scale, &active_curve);
     } else {
         hx711_set_scale(&scale, 1.0);
-        hx711_tare(&scale, 20);
+    }
+    if (hx711_acq_start_rt(&acq, &scale, &conf.rt) != 0) {
+        fprintf(stderr, "HX711 acquisition thread failed\n");
+        return 1;
+    }
+    startup.hx711_ns = boottime_ns() - phase_ns;
+
+    if (conf.fast_start) {
+        phase_ns = boottime_ns();
+        if (lcd_init(I2C_BUS, I2C_ADDR) != 0) {
+            fprintf(stderr, "LCD Init Failed\n");
+            return 1;
+        }
+        startup.lcd_ns = boottime_ns() - phase_ns;
+    } else if (!have_conf) {
+        // Without a saved zero, tare before weighing
+        point_result_t zero = measure_point(&acq, &conf, 1.0f);
+        if (point_ok(&zero, &conf)) hx711_set_offset(&scale, zero.mean);
     }
 
     lcd_clear(); lcd_send_string("Ready to Weigh");
 
-    // Main Loop
-    while (1) {
-        bool update_screen = false;
+    // One reactor for everything: sample notifications, button edges, display timer, config changes
+    EventLoop loop;
+    if (event_loop_init(&loop) != 0) { perror("epoll"); return 1; }
+    int tare_fd = gpiod_line_event_get_fd(tare_line);
+    int calib_fd = gpiod_line_event_get_fd(calib_line);
 
-        // 1. Tare
-        if (gpiod_line_get_value(tare_line) == 1) {
-            perform_tare(&scale);
-            update_screen = true;
-            while (gpiod_line_get_value(tare_line) == 1) my_delay_ms(50);
-        }
+    if (have_conf && strcmp(conf.mode, "checkweigh") == 0) {
+        return run_checkweigh(&loop, &acq, &conf, samples_fd, tare_fd, calib_fd);
+    }
+    if (have_conf && strcmp(conf.mode, "dynamic") == 0) {
+        return run_dynamic(&loop, &acq, &conf, samples_fd, tare_fd);
+    }
+    if (dosing_mode) {
+        return run_dosing(&loop, &acq, &conf, tare_fd, calib_fd);
+    }
+    if (have_conf && strcmp(conf.mode, "counting") == 0) {
+        return run_counting(&loop, &acq, &conf, samples_fd, tare_fd, calib_fd);
+    }
 
-        // 2. Secure Calibration
-        if (gpiod_line_get_value(calib_line) == 1) {
-            perform_secure_calibration(&scale);
-            update_screen = true;
-            while (gpiod_line_get_value(calib_line) == 1) my_delay_ms(50);
-        }
+    static weigh_state_t st;
+    st.acq = &acq;
+    st.scale = &scale;
+    st.conf = &conf;
+    st.boot_check = conf.fast_start;
+    st.provisional_zero = conf.fast_start && !have_conf;
+    hx711_acq_reader_init(&acq, &st.reader);
+    hx711_acq_aux_reader_init(&acq, &st.aux_reader);
+    if (!have_conf) {
+        read_filter_config(NULL, &conf.filter);
+        conf.settling_time = DEFAULT_SETTLING_TIME;
+        conf.division = DEFAULT_DIVISION;
+    }
 
-        if (update_screen) {
-            lcd_clear(); lcd_send_string("Weight:");
-        }
+    // Division is in grams; the detector works on filtered raw counts
+    hx711_stable_init(&st.stability, conf.settling_time, conf.division * fabsf(hx711_get_scale(&scale)),
+                      on_stability_event, &scale);
 
-        float weight = hx711_get_units(&scale, 5);
-        if (fabsf(weight) < 0.5) weight = 0.0;
+    // Auto-zero follows drift while the pan is empty; the total is persisted
+    float counts_per_g = fabsf(hx711_get_scale(&scale));
+    hx711_zero_init(&st.zero, &scale, conf.division * counts_per_g, conf.zero_range * counts_per_g,
+                    conf.zero_drift, conf.max_zero_drift);
+    hx711_zero_set_alarm(&st.zero, on_zero_drift_alarm, &scale);
+    st.saved_drift = conf.zero_drift;
 
-        char lcd_buffer[17];
-        snprintf(lcd_buffer, sizeof(lcd_buffer), "%8.2f g", weight);
-        lcd_set_cursor(1, 0); lcd_send_string("                ");
-        lcd_set_cursor(1, 0); lcd_send_string(lcd_buffer);
+    // Temperature compensation; inactive until the first reading and with zero coefficients
+    st.temp_from_b = strcmp(conf.temp_source, "channel_b") == 0;
+    st.temp_from_file = conf.temp_source[0] && !st.temp_from_b;
+    hx711_temp_init(&st.thermal, conf.temp_ref, conf.temp_at_tare, conf.temp_zero_tc, conf.temp_span_tc);
+    if (strcmp(conf.temp_capture, "zero") == 0) {
+        hx711_temp_start_capture(&st.thermal, HX711_TEMP_CAPTURE_ZERO);
+    } else if (strcmp(conf.temp_capture, "span") == 0) {
+        hx711_temp_start_capture(&st.thermal, HX711_TEMP_CAPTURE_SPAN);
+    }
+    if (st.temp_from_file && hx711_temp_reader_start(&st.temp_reader, conf.temp_source, TEMP_READ_PERIOD_MS) != 0) {
+        perror("Temperature reader");
+        st.temp_from_file = false;
+    }
 
-        my_delay_ms(250);
+    if (event_loop_add_counter(&loop, samples_fd, on_weigh_samples, &st) != 0 ||
+        event_loop_add_fd(&loop, tare_fd, EPOLLIN, on_tare_button, &st) != 0 ||
+        event_loop_add_fd(&loop, calib_fd, EPOLLIN, on_calib_button, &st) != 0 ||
+        event_loop_add_timer(&loop, DISPLAY_PERIOD_MS, on_display_tick, &st) < 0) {
+        perror("Event loop");
+        return 1;
+    }
+    // Not fatal: without the watch, config edits apply on the next restart
+    if (event_loop_watch_file(&loop, CONFIG_JSON_PATH, on_config_changed, &st) < 0) {
+        perror("config.json watch");
     }
 
+    if (event_loop_run(&loop) != 0) {
+        perror("Event loop");
+        return 1;
+    }
     return 0;
 }
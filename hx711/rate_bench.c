@@ -0,0 +1,227 @@
+/**
+ *
+ * Time-to-display and noise benchmark for the 10/80 SPS RATE switching
+ *
+ * Compile with: gcc -O2 rate_bench.c hx711_filter.c hx711_stable.c -o rate_bench -lm
+ *
+ * ./rate_bench [division_g [loads]]
+ *     Replays the same load steps through the display path of mw11 (5-sample
+ *     box filter, stability detector, rate request after every sample) in
+ *     six configurations:
+ *       fixed 10     RATE tied low, as before rate switching
+ *       switch       80 SPS while unstable, 10 SPS while stable, fixed limits
+ *       +scale       the same, with the 80 SPS sd limits widened by
+ *                    HX711_RATE_NOISE_RATIO
+ *       +scale+hyst  also back to 80 SPS only after a move of
+ *                    RATE_MOTION_DIVISIONS from the settled value
+ *       +group       also each RATE_FAST_GROUP 80 SPS conversions averaged
+ *                    into one sample before the filter, so the 5-sample box
+ *                    spans 250 ms at either rate
+ *       +group+hold  also, once settled at 10 SPS, the running mean of up
+ *                    to RATE_HOLD_SAMPLES filtered values is shown (mw11)
+ *     and reports, per configuration, the median and 90th percentile time
+ *     from the step until the filtered value stays within 1 d of the load
+ *     and until the detector reports it stable, how many steps never
+ *     settled or never went back to 10 SPS, rate switches per step, and the
+ *     sd of the shown value (the filtered value, or the held mean) in the
+ *     last two seconds of each load.
+ *
+ *     The chip is modelled from the datasheet: input noise 50 nV rms at
+ *     10 SPS and 90 nV at 80 SPS (gain 128, ~2.4 nV per count), and
+ *     HX711_RATE_SETTLE_SAMPLES conversions dropped after each switch. The
+ *     load is a damped 4 Hz bounce with a 150 ms time constant, 206 counts
+ *     per gram as in data/config.json. No recorded traces of the real
+ *     cell are included; these numbers show the model, not the scale.
+ *
+ */
+#define _GNU_SOURCE // M_PI
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "hx711.h"
+#include "hx711_filter.h"
+#include "hx711_stable.h"
+
+#define COUNTS_PER_G   206.27
+#define NOISE_10SPS    21.0  // Counts rms, 50 nV
+#define NOISE_80SPS    38.0  // Counts rms, 90 nV
+#define SETTLING_TIME  0.5   // Seconds, the mw11 default
+#define LOAD_SECONDS   8.0
+#define QUIET_SECONDS  2.0   // Tail of each load the noise is measured over
+#define BOUNCE_HZ      4.0
+#define BOUNCE_TAU     0.15
+#define RATE_MOTION_DIVISIONS 5.0 // As in mw11
+#define RATE_FAST_GROUP       4
+#define RATE_HOLD_SAMPLES     32
+#define RATE_HOLD_MIN         5
+
+typedef struct {
+    const char* name;
+    bool switching;
+    bool scaled;
+    bool hysteresis;
+    bool grouped;
+    bool hold;
+} bench_config_t;
+
+typedef struct {
+    double display_s[4096];
+    double stable_s[4096];
+    int n_display, n_stable;
+    int never_stable, never_slow;
+    long switches;
+    double noise_sum, noise_n;
+} bench_result_t;
+
+static double gauss(void) {
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0), u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+// Platform response t seconds after a step from `from` to `to` grams
+static double load_at(double from, double to, double t) {
+    return to + (from - to) * exp(-t / BOUNCE_TAU) * cos(2.0 * M_PI * BOUNCE_HZ * t);
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+static double percentile(double* v, int n, double p) {
+    if (n == 0) return NAN;
+    qsort(v, (size_t)n, sizeof(double), cmp_double);
+    return v[(int)(p * (n - 1) + 0.5)];
+}
+
+static void run(const bench_config_t* cfg, double division_g, int loads, bench_result_t* res) {
+    hx711_filter_chain_t filter;
+    hx711_stable_t det;
+    double prev = 0.0;
+    int sps = HX711_SPS_SLOW, drop = 0;
+    bool have_ref = false;
+    long rate_ref = 0;
+    uint64_t t_ns = 0;
+    long group_sum = 0;
+    int group_n = 0;
+    double hold_mean = 0.0;
+    int hold_n = 0;
+
+    srand(1);
+    hx711_filter_init(&filter);
+    hx711_filter_add_moving_average(&filter, 5);
+    hx711_stable_init(&det, SETTLING_TIME, division_g * COUNTS_PER_G, NULL, NULL);
+
+    for (int l = 0; l < loads; l++) {
+        double target = 100.0 + (rand() % 20000); // 0.1 .. 20 kg
+        double in_band_since = -1.0, stable_at = -1.0, slow_at = -1.0;
+        double q_sum = 0.0, q_sq = 0.0;
+        int q_n = 0;
+        uint64_t step_ns = t_ns;
+
+        while (t_ns - step_ns < (uint64_t)(LOAD_SECONDS * 1e9)) {
+            t_ns += 1000000000ull / (uint64_t)sps;
+            double t = (double)(t_ns - step_ns) * 1e-9;
+            if (drop > 0) { drop--; continue; } // Engine drops the settling conversions
+
+            double noise = sps == HX711_SPS_FAST ? NOISE_80SPS : NOISE_10SPS;
+            long raw = lround(load_at(prev, target, t) * COUNTS_PER_G + noise * gauss());
+            double noise_scale = HX711_RATE_NOISE_RATIO;
+            if (cfg->grouped && sps == HX711_SPS_FAST) {
+                group_sum += raw;
+                if (++group_n < RATE_FAST_GROUP) continue;
+                raw = lround((double)group_sum / group_n);
+                group_sum = 0;
+                group_n = 0;
+                noise_scale = fmax(1.0, HX711_RATE_NOISE_RATIO / sqrt(RATE_FAST_GROUP));
+            } else {
+                group_sum = 0;
+                group_n = 0;
+            }
+            long filtered = hx711_filter_push(&filter, raw);
+            if (cfg->scaled) hx711_stable_set_noise_scale(&det, sps == HX711_SPS_FAST ? noise_scale : 1.0);
+            hx711_stable_push(&det, t_ns, filtered);
+
+            double shown = filtered;
+            if (cfg->hold && hx711_stable_is_stable(&det) && sps == HX711_SPS_SLOW) {
+                if (hold_n < RATE_HOLD_SAMPLES) hold_n++;
+                hold_mean += (filtered - hold_mean) / hold_n;
+                if (hold_n >= RATE_HOLD_MIN) shown = hold_mean;
+            } else {
+                hold_n = 0;
+            }
+            double err_d = fabs(shown / COUNTS_PER_G - target) / division_g;
+            if (err_d > 1.0) {
+                in_band_since = -1.0;
+            } else if (in_band_since < 0.0) {
+                in_band_since = t;
+            }
+            bool stable = hx711_stable_is_stable(&det);
+            if (stable && stable_at < 0.0) stable_at = t;
+            if (t > LOAD_SECONDS - QUIET_SECONDS) {
+                q_sum += shown;
+                q_sq += shown * shown;
+                q_n++;
+            }
+
+            if (cfg->switching) {
+                int want = stable ? HX711_SPS_SLOW : HX711_SPS_FAST;
+                if (cfg->hysteresis) {
+                    if (stable) {
+                        rate_ref = filtered;
+                        have_ref = true;
+                    } else if (have_ref && labs(filtered - rate_ref) <= RATE_MOTION_DIVISIONS * division_g * COUNTS_PER_G) {
+                        want = sps;
+                    }
+                }
+                if (want != sps) {
+                    sps = want;
+                    drop = HX711_RATE_SETTLE_SAMPLES;
+                    res->switches++;
+                }
+                if (sps == HX711_SPS_SLOW && slow_at < 0.0 && stable) slow_at = t;
+            }
+        }
+
+        if (in_band_since >= 0.0) res->display_s[res->n_display++] = in_band_since;
+        if (stable_at >= 0.0) res->stable_s[res->n_stable++] = stable_at;
+        else res->never_stable++;
+        if (cfg->switching && slow_at < 0.0) res->never_slow++;
+        if (q_n > 1) {
+            double mean = q_sum / q_n;
+            res->noise_sum += sqrt(fmax(q_sq / q_n - mean * mean, 0.0)) / COUNTS_PER_G / division_g;
+            res->noise_n++;
+        }
+        prev = target;
+    }
+}
+
+int main(int argc, char** argv) {
+    double division_g = argc >= 2 ? atof(argv[1]) : 0.15;
+    int loads = argc >= 3 ? atoi(argv[2]) : 500;
+    static const bench_config_t configs[] = {
+        { "fixed 10", false, false, false, false, false },
+        { "switch", true, false, false, false, false },
+        { "+scale", true, true, false, false, false },
+        { "+scale+hyst", true, true, true, false, false },
+        { "+group", true, true, true, true, false },
+        { "+group+hold", true, true, true, true, true },
+    };
+
+    if (loads < 1 || loads > 4096) loads = 500;
+    printf("%d load steps, d = %.3f g, settling_time %.1f s\n\n", loads, division_g, SETTLING_TIME);
+    printf("%-12s %17s %17s %7s %8s %9s %9s\n", "", "within 1 d (s)", "stable (s)", "never", "stuck at", "switches", "quiet sd");
+    printf("%-12s %8s %8s %8s %8s %7s %8s %9s %9s\n", "", "median", "p90", "median", "p90", "stable", "80 SPS", "per step", "(d)");
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        static bench_result_t res;
+        res = (bench_result_t){ 0 };
+        run(&configs[c], division_g, loads, &res);
+        int n_display = res.n_display, n_stable = res.n_stable;
+        printf("%-12s %8.2f %8.2f %8.2f %8.2f %7d %8d %9.1f %9.3f\n", configs[c].name,
+               percentile(res.display_s, n_display, 0.5), percentile(res.display_s, n_display, 0.9),
+               percentile(res.stable_s, n_stable, 0.5), percentile(res.stable_s, n_stable, 0.9),
+               res.never_stable, res.never_slow, (double)res.switches / loads, res.noise_sum / res.noise_n);
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+/**
+ *
+ * Clock-out cost benchmark for hx711_read
+ *
+ * Compile with: gcc -O2 read_bench.c hx711.c hx711_timing.c hx711_curve.c hx711_sim.c -o read_bench -lpthread -lm
+ *
+ * ./read_bench [reads]
+ *     Reads the simulated chip through hx711_read() with the runtime
+ *     bit-bang loop (indirect gpio/delay calls per bit) and with the
+ *     specialized loop from hx711_fast.h (hx711_sim_read_sample). Holds are
+ *     no-ops and the RT context is set, so only the per-read code path is
+ *     measured. Reports the minimum and mean cost per read, in TSC cycles
+ *     on x86 and in nanoseconds elsewhere.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "hx711.h"
+#include "hx711_sim.h"
+#include "hx711_timing.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "cycles"
+static inline uint64_t bench_now(void) { return __rdtsc(); }
+#else
+#define BENCH_UNIT "ns"
+static inline uint64_t bench_now(void) { return hx711_time_ns(); }
+#endif
+
+#define SIM_VALUE 123456
+
+static void no_delay_us(unsigned int us) { (void)us; }
+static void no_delay_ms(unsigned int ms) { (void)ms; }
+static void no_delay_ns(unsigned int ns) { (void)ns; }
+
+static void run(const char* name, hx711_t* hx, int reads) {
+    uint64_t best = UINT64_MAX, sum = 0;
+    int wrong = 0;
+
+    for (int i = 0; i < reads; i++) {
+        uint64_t t0 = bench_now();
+        long value = hx711_read(hx);
+        uint64_t dt = bench_now() - t0;
+
+        if (value != SIM_VALUE) wrong++;
+        sum += dt;
+        if (dt < best) best = dt;
+    }
+    printf("%-18s min %6llu %s, avg %6llu %s%s\n", name, (unsigned long long)best, BENCH_UNIT,
+           (unsigned long long)(sum / (uint64_t)reads), BENCH_UNIT, wrong ? "  (WRONG VALUES)" : "");
+}
+
+int main(int argc, char** argv) {
+    int reads = argc >= 2 ? atoi(argv[1]) : 20000;
+    static hx711_sim_t sim;
+    hx711_t hx;
+
+    if (reads < 1) reads = 1;
+    hx711_sim_init(&sim, SIM_VALUE, 0);
+    hx711_sim_attach(&sim);
+
+    hx711_backend_t backend = {
+        .gpio_write = hx711_sim_gpio_write,
+        .gpio_read = hx711_sim_gpio_read,
+        .delay_us = no_delay_us,
+        .delay_ms = no_delay_ms,
+    };
+    printf("%d reads per loop, simulator backend, no-op holds, RT context\n", reads);
+
+    hx711_init_backend(&hx, 0, 0, &backend);
+    hx711_set_pulse_ns(&hx, no_delay_ns, 0);
+    hx.rt_context = true;
+    run("runtime loop:", &hx, reads);
+
+    backend.read_sample = hx711_sim_read_sample;
+    backend.read_sample_rt = true;
+    hx711_init_backend(&hx, 0, 0, &backend);
+    hx.rt_context = true;
+    run("specialized loop:", &hx, reads);
+    return 0;
+}
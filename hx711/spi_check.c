@@ -0,0 +1,59 @@
+/**
+ *
+ * Hardware check for the spidev transport
+ *
+ * Compile with: gcc -O2 spi_check.c hx711_spi.c hx711_sim.c hx711_timing.c -o spi_check
+ *
+ * ./spi_check /dev/spidev0.0 low|high [speed_hz] [reads]
+ *     Runs hx711_spi_read_sample() through the real SPI_IOC_MESSAGE ioctl,
+ *     with MISO strapped to GND ("low") or 3V3 ("high") instead of an
+ *     HX711. The controller must accept every gain-pulse word width (1..3
+ *     bits), and the 24 data bits must read back as all zeros or all ones.
+ *     Reports failures and the time per transfer. The simulated device
+ *     (hx711_spi_open_sim) only covers the decoding, not this path.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "hx711_spi.h"
+#include "hx711_timing.h"
+
+int main(int argc, char** argv) {
+    if (argc < 3 || (strcmp(argv[2], "low") != 0 && strcmp(argv[2], "high") != 0)) {
+        fprintf(stderr, "usage: %s /dev/spidevB.C low|high [speed_hz] [reads]\n", argv[0]);
+        return 2;
+    }
+    uint32_t expect = strcmp(argv[2], "high") == 0 ? 0xFFFFFFu : 0u;
+    uint32_t speed = argc >= 4 ? (uint32_t)strtoul(argv[3], NULL, 0) : HX711_SPI_DEFAULT_HZ;
+    int reads = argc >= 5 ? atoi(argv[4]) : 1000;
+
+    if (hx711_spi_open(argv[1], speed) != 0) return 1;
+
+    int failures = 0;
+    for (uint8_t pulses = 1; pulses <= 3; pulses++) {
+        int errors = 0, wrong = 0;
+        uint64_t total_ns = 0, worst_ns = 0;
+
+        for (int i = 0; i < reads; i++) {
+            uint32_t raw = 0x5A5A5Au;
+            uint64_t t0 = hx711_time_ns();
+            int ret = hx711_spi_read_sample(pulses, &raw);
+            uint64_t dt = hx711_time_ns() - t0;
+
+            total_ns += dt;
+            if (dt > worst_ns) worst_ns = dt;
+            if (ret != 0) errors++;
+            else if (raw != expect) wrong++;
+        }
+        printf("%u gain pulse%s: %d reads, %d ioctl errors, %d wrong values, %.1f us avg, %.1f us worst\n",
+               (unsigned)pulses, pulses > 1 ? "s" : " ", reads, errors, wrong, total_ns / 1e3 / reads,
+               worst_ns / 1e3);
+        failures += errors + wrong;
+    }
+    hx711_spi_close();
+
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
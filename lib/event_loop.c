@@ -0,0 +1,198 @@
+/**
+ * Event Loop Library for Calibris
+ *
+ * Implementation of the epoll reactor.
+ *
+ * Compile: gcc -c event_loop.c -o event_loop.o
+ * Create static lib: ar rcs libevent_loop.a event_loop.o
+ */
+
+#include "event_loop.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/timerfd.h>
+#include <sys/inotify.h>
+
+#define MAX_READY 8
+
+// epoll data: slot index in the low half, slot generation in the high half
+static uint64_t make_tag(int slot, uint32_t generation) {
+    return ((uint64_t)generation << 32) | (uint32_t)slot;
+}
+
+static EventSource *add_source(EventLoop *loop, int fd, EventSourceKind kind, uint32_t events,
+                               EventHandler handler, void *ctx) {
+    for (int i = 0; i < EVENT_LOOP_MAX_SOURCES; i++) {
+        EventSource *src = &loop->sources[i];
+        if (src->fd >= 0) continue;
+
+        struct epoll_event ev = { .events = events, .data.u64 = make_tag(i, src->generation) };
+        if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) return NULL;
+
+        src->fd = fd;
+        src->kind = kind;
+        src->handler = handler;
+        src->ctx = ctx;
+        src->count = 0;
+        src->dispatched = 0;
+        src->name[0] = '\0';
+        return src;
+    }
+    errno = ENOSPC;
+    return NULL;
+}
+
+int event_loop_init(EventLoop *loop) {
+    memset(loop, 0, sizeof(*loop));
+    for (int i = 0; i < EVENT_LOOP_MAX_SOURCES; i++) loop->sources[i].fd = -1;
+
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    return loop->epoll_fd < 0 ? -1 : 0;
+}
+
+int event_loop_add_fd(EventLoop *loop, int fd, uint32_t events, EventHandler handler, void *ctx) {
+    return add_source(loop, fd, EVENT_SOURCE_FD, events, handler, ctx) ? 0 : -1;
+}
+
+int event_loop_add_counter(EventLoop *loop, int fd, EventHandler handler, void *ctx) {
+    return add_source(loop, fd, EVENT_SOURCE_COUNTER, EPOLLIN, handler, ctx) ? 0 : -1;
+}
+
+int event_loop_add_timer(EventLoop *loop, unsigned interval_ms, EventHandler handler, void *ctx) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct itimerspec its;
+    its.it_interval.tv_sec = interval_ms / 1000;
+    its.it_interval.tv_nsec = (long)(interval_ms % 1000) * 1000000L;
+    its.it_value = its.it_interval;
+    if (timerfd_settime(fd, 0, &its, NULL) != 0 ||
+        !add_source(loop, fd, EVENT_SOURCE_TIMER, EPOLLIN, handler, ctx)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int event_loop_watch_file(EventLoop *loop, const char *path, EventHandler handler, void *ctx) {
+    char dir[PATH_MAX];
+    const char *slash = strrchr(path, '/');
+    const char *name = slash ? slash + 1 : path;
+
+    if (slash == path) {
+        snprintf(dir, sizeof(dir), "/");
+    } else if (slash) {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+    } else {
+        snprintf(dir, sizeof(dir), ".");
+    }
+    if (strlen(name) >= EVENT_LOOP_MAX_NAME) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return -1;
+
+    EventSource *src = NULL;
+    if (inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0 ||
+        !(src = add_source(loop, fd, EVENT_SOURCE_FILE, EPOLLIN, handler, ctx))) {
+        close(fd);
+        return -1;
+    }
+    snprintf(src->name, sizeof(src->name), "%s", name);
+    return fd;
+}
+
+EventSource *event_loop_source(EventLoop *loop, int fd) {
+    for (int i = 0; i < EVENT_LOOP_MAX_SOURCES; i++) {
+        if (loop->sources[i].fd == fd && fd >= 0) return &loop->sources[i];
+    }
+    return NULL;
+}
+
+int event_loop_remove(EventLoop *loop, int fd) {
+    EventSource *src = event_loop_source(loop, fd);
+    if (!src) return -1;
+
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    if (src->kind == EVENT_SOURCE_TIMER || src->kind == EVENT_SOURCE_FILE) close(fd);
+    src->fd = -1;
+    src->generation++;
+    return 0;
+}
+
+// Reads what the loop owns; returns false if there is nothing to report
+static bool drain(EventSource *src) {
+    switch (src->kind) {
+    case EVENT_SOURCE_TIMER:
+    case EVENT_SOURCE_COUNTER: {
+        uint64_t n;
+        if (read(src->fd, &n, sizeof(n)) != (ssize_t)sizeof(n)) return false;
+        src->count = n;
+        return true;
+    }
+    case EVENT_SOURCE_FILE: {
+        char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        bool hit = false;
+        ssize_t len;
+
+        while ((len = read(src->fd, buf, sizeof(buf))) > 0) {
+            for (char *p = buf; p < buf + len; ) {
+                struct inotify_event *ev = (struct inotify_event *)p;
+                if (ev->len && strcmp(ev->name, src->name) == 0) hit = true;
+                p += sizeof(*ev) + ev->len;
+            }
+        }
+        src->count = hit;
+        return hit;
+    }
+    default:
+        return true;
+    }
+}
+
+int event_loop_run(EventLoop *loop) {
+    struct epoll_event ready[MAX_READY];
+
+    loop->running = true;
+    while (loop->running) {
+        int n = epoll_wait(loop->epoll_fd, ready, MAX_READY, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            loop->running = false;
+            return -1;
+        }
+        loop->wakeups++;
+
+        for (int i = 0; i < n && loop->running; i++) {
+            int slot = (int)(uint32_t)ready[i].data.u64;
+            uint32_t generation = (uint32_t)(ready[i].data.u64 >> 32);
+            EventSource *src = &loop->sources[slot];
+
+            // Removed by an earlier handler in this batch
+            if (src->fd < 0 || src->generation != generation) continue;
+            if (!drain(src)) continue;
+
+            src->dispatched++;
+            src->handler(loop, src->fd, ready[i].events, src->ctx);
+        }
+    }
+    return 0;
+}
+
+void event_loop_stop(EventLoop *loop) {
+    loop->running = false;
+}
+
+void event_loop_close(EventLoop *loop) {
+    for (int i = 0; i < EVENT_LOOP_MAX_SOURCES; i++) {
+        if (loop->sources[i].fd >= 0) event_loop_remove(loop, loop->sources[i].fd);
+    }
+    if (loop->epoll_fd >= 0) close(loop->epoll_fd);
+    loop->epoll_fd = -1;
+}
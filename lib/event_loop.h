@@ -0,0 +1,162 @@
+/**
+ * Event Loop Library for Calibris
+ *
+ * A single-threaded epoll reactor shared by the device daemons. Every input
+ * is a file descriptor with its own handler: GPIO edge events
+ * (gpiod_line_event_get_fd), eventfds posted by worker threads, periodic
+ * timerfds and inotify watches on config files. The daemon blocks in
+ * epoll_wait() until one of them fires, so it uses no CPU while idle and
+ * reacts to a button within a scheduler wakeup.
+ *
+ * Timer and eventfd sources are drained by the loop before their handler
+ * runs; plain fd sources must be consumed by the handler (they are
+ * level-triggered and fire again otherwise).
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#define EVENT_LOOP_MAX_SOURCES 16
+#define EVENT_LOOP_MAX_NAME    64
+
+typedef struct EventLoop EventLoop;
+
+/**
+ * Called when a source is ready.
+ *
+ * @param loop    The loop, e.g. for event_loop_stop()
+ * @param fd      The source's file descriptor
+ * @param events  EPOLLIN/EPOLLPRI/EPOLLERR/... as reported by epoll
+ * @param ctx     Pointer given when the source was added
+ */
+typedef void (*EventHandler)(EventLoop *loop, int fd, uint32_t events, void *ctx);
+
+typedef enum {
+    EVENT_SOURCE_FD,       // Caller's fd, consumed by the handler
+    EVENT_SOURCE_TIMER,    // timerfd owned by the loop
+    EVENT_SOURCE_COUNTER,  // Caller's eventfd, counter reset by the loop
+    EVENT_SOURCE_FILE      // inotify fd owned by the loop, watching one file
+} EventSourceKind;
+
+typedef struct {
+    int fd;                // -1 = free slot
+    uint32_t generation;   // Bumped on removal, so stale epoll events are dropped
+    EventSourceKind kind;
+    EventHandler handler;
+    void *ctx;
+    uint64_t count;        // TIMER: expirations, COUNTER: posts, since the previous call
+    uint64_t dispatched;   // Handler calls so far
+    char name[EVENT_LOOP_MAX_NAME]; // FILE: file name inside the watched directory
+} EventSource;
+
+struct EventLoop {
+    int epoll_fd;
+    bool running;
+    EventSource sources[EVENT_LOOP_MAX_SOURCES];
+    uint64_t wakeups;      // Returns from epoll_wait()
+};
+
+/**
+ * Create the epoll instance.
+ *
+ * @param loop  Loop to initialize
+ * @return      0 on success, -1 on failure (errno set)
+ */
+int event_loop_init(EventLoop *loop);
+
+/**
+ * Watch a descriptor the caller owns.
+ *
+ * @param loop     Loop
+ * @param fd       Descriptor to watch
+ * @param events   EPOLLIN, EPOLLPRI, ...
+ * @param handler  Called while the descriptor is ready; must consume it
+ * @param ctx      Passed to the handler
+ * @return         0 on success, -1 on failure
+ */
+int event_loop_add_fd(EventLoop *loop, int fd, uint32_t events, EventHandler handler, void *ctx);
+
+/**
+ * Watch an eventfd (or any 8-byte counter fd) posted by another thread.
+ * The loop reads the counter, so one handler call covers every post since
+ * the previous one.
+ *
+ * @param loop     Loop
+ * @param fd       eventfd, preferably EFD_NONBLOCK
+ * @param handler  Called after each read; the count is in the source
+ * @param ctx      Passed to the handler
+ * @return         0 on success, -1 on failure
+ */
+int event_loop_add_counter(EventLoop *loop, int fd, EventHandler handler, void *ctx);
+
+/**
+ * Create a periodic CLOCK_MONOTONIC timer. Missed periods are coalesced
+ * into one call.
+ *
+ * @param loop         Loop
+ * @param interval_ms  Period in milliseconds (first expiry one period from now)
+ * @param handler      Called on every expiry
+ * @param ctx          Passed to the handler
+ * @return             The timerfd (owned by the loop), -1 on failure
+ */
+int event_loop_add_timer(EventLoop *loop, unsigned interval_ms, EventHandler handler, void *ctx);
+
+/**
+ * Watch a file for replacement or rewrite. The parent directory is watched,
+ * so editors and tools that write a temporary file and rename it over the
+ * original are seen as well.
+ *
+ * @param loop     Loop
+ * @param path     File to watch
+ * @param handler  Called once per batch of changes to that file
+ * @param ctx      Passed to the handler
+ * @return         The inotify fd (owned by the loop), -1 on failure
+ */
+int event_loop_watch_file(EventLoop *loop, const char *path, EventHandler handler, void *ctx);
+
+/**
+ * Find the source of a descriptor, e.g. for its count inside a handler.
+ *
+ * @param loop  Loop
+ * @param fd    Descriptor
+ * @return      The source, or NULL if fd is not watched
+ */
+EventSource *event_loop_source(EventLoop *loop, int fd);
+
+/**
+ * Stop watching a descriptor. Timers and file watches are closed; caller
+ * descriptors are left open. Safe to call from a handler.
+ *
+ * @param loop  Loop
+ * @param fd    Descriptor
+ * @return      0 on success, -1 if fd is not watched
+ */
+int event_loop_remove(EventLoop *loop, int fd);
+
+/**
+ * Dispatch events until event_loop_stop() is called.
+ *
+ * @param loop  Loop
+ * @return      0 after a stop, -1 if epoll_wait() failed (errno set)
+ */
+int event_loop_run(EventLoop *loop);
+
+/**
+ * Make event_loop_run() return after the current handler.
+ *
+ * @param loop  Loop
+ */
+void event_loop_stop(EventLoop *loop);
+
+/**
+ * Remove every source and close the epoll instance.
+ *
+ * @param loop  Loop
+ */
+void event_loop_close(EventLoop *loop);
+
+#endif // EVENT_LOOP_H